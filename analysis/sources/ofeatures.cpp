@@ -22,6 +22,7 @@ for oscillatory cell behavior described in the input file.
 The format of the input file is
 t c1(t) c2(t) . . . cn(t),
 where t is the time step and ci(t) is the value of cell i at time step t.
+Both the input file and the smoothed file can be text or binary run files (see run-file.h).
 Since we assume that our cells are in synchrony and the simulations are stochastic, the program
 averages the value of all the periods, amplitudes and peak to troughs ratios for each individual cell
 and outputs only one number for each of them. 
@@ -39,6 +40,8 @@ Line i in each of the files contains the values of the oscillation feature indic
 #include <errno.h>
 #include <stdlib.h>
 
+#include "../../stochastic/source/run-file.h"
+
 using namespace std;
 
 int findLastSlash(char* filename) {
@@ -61,7 +64,7 @@ int main(int argc, char** argv) {
 	2) The name of the file containing the smoothed data.
 	   The smoothed data is used to calculate the period, in order to eliminate occurences of false peaks or troughs generated by noise.
 	3) The time step from which the analysis should start.*/
-    ifstream rough, smooth;
+    run_reader rough, smooth;
     char *roughfile, *smoothfile;
 	int cut;
 	if (argc == 4) {
@@ -73,22 +76,15 @@ int main(int argc, char** argv) {
 		exit(0);
 	}
 	
-	rough.open(roughfile, fstream::in);
-	smooth.open(smoothfile, fstream::in);
+	if (!rough.open(roughfile) || !smooth.open(smoothfile)) {
+		cerr << "ofeatures.cpp couldn't open " << roughfile << " or " << smoothfile << endl;
+		exit(0);
+	}
 	
 	// Count the number of lines in the input file
-	int nolines = 0;
-	string line;
-	while (!rough.eof()) { 
-		getline(rough, line);
-		nolines++;
-	}
-	rough.close();
-	rough.open(roughfile, fstream::in);
+	int nolines = rough.lines(roughfile);
 	
-	int w, h; // width and height of the cell grid
-	rough >> w >> h;
-	smooth >> w >> h;
+	int w = smooth.width, h = smooth.height; // width and height of the cell grid
 	
 	const int CELLS = w * h;
 	const int FSIZE = nolines - 1;
@@ -107,11 +103,11 @@ int main(int argc, char** argv) {
 	double timetemp;
 	
 	while (!rough.eof() && !smooth.eof()) {
-		rough >> time[index];
-		smooth >> timetemp;
+		rough.read_time(time[index]);
+		smooth.read_time(timetemp);
 		for (int n = 0; n < CELLS; n++) {
-			smooth >> mh1[n][index];
-			rough >> mh1n[n][index];
+			smooth.read_value(mh1[n][index]);
+			rough.read_value(mh1n[n][index]);
 		}
 		index++;
 	}
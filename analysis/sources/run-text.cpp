@@ -0,0 +1,133 @@
+/*
+Binary to text run file converter for stochastic runs
+Copyright (C) 2012 Ahmet Ay, Jack Holland, Adriana Sperlea
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/*
+Converts a binary run file (printed by the stochastic simulator with -b or --binary) to the text format the simulator prints by default,
+so the result is exactly the file the simulator would have printed without -b. See stochastic/source/run-file.h for both formats.
+*/
+
+#include <fstream>
+#include <iostream>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../../stochastic/source/run-file.h"
+
+// escape codes to color the terminal output and shortcuts for common outputs (set -c or --color to no to disable these)
+#define terminal_blue_d "\x1b[34m"
+#define terminal_red_d "\x1b[31m"
+#define terminal_reset_d "\x1b[0m"
+#define terminal_done terminal_blue << "Done" << terminal_reset
+#define terminal_no_memory terminal_red << "Not enough memory!" << terminal_reset
+
+#define records_per_block 1024 // the number of records to read from the binary file at once
+
+using namespace std;
+
+char* terminal_blue;
+char* terminal_red;
+char* terminal_reset;
+
+void usage (const char*);
+
+int main(int argc, char** argv) {
+	// allocate memory for the terminal color code strings
+	terminal_blue = (char*)malloc(sizeof(terminal_blue_d));
+	terminal_red = (char*)malloc(sizeof(terminal_red_d));
+	terminal_reset = (char*)malloc(sizeof(terminal_reset_d));
+	if (terminal_blue == NULL || terminal_red == NULL || terminal_reset == NULL) {
+		cout << terminal_no_memory << endl;
+		exit(1);
+	}
+	strcpy(terminal_blue, terminal_blue_d);
+	strcpy(terminal_red, terminal_red_d);
+	strcpy(terminal_reset, terminal_reset_d);
+
+	int argi = 1;
+	if (argc > 1 && (strcmp(argv[1], "-c") == 0 || strcmp(argv[1], "--no-color") == 0)) {
+		strcpy(terminal_blue, "");
+		strcpy(terminal_red, "");
+		strcpy(terminal_reset, "");
+		argi++;
+	}
+	if (argc - argi < 2) {
+		usage("Converting requires input and output file names.");
+	}
+
+	ifstream ifile;
+	ifile.open(argv[argi], fstream::in | fstream::binary);
+	run_file_header header;
+	ifile.read((char*)&header, sizeof(header));
+	if (!ifile || !header.valid()) {
+		usage("The input file must be a binary run file.");
+	}
+	ofstream ofile;
+	ofile.open(argv[argi + 1], fstream::out);
+	if (!ofile) {
+		usage("Couldn't create the output file.");
+	}
+
+	/*
+	Convert the file:
+	1) Print the tissue size on the first line
+	2) Read the records a block at a time and print each as a line of tab-separated values, the same way the simulator prints them
+	*/
+
+	ofile << header.width << " " << header.height << "\n";
+
+	const int CELLS = header.width * header.height;
+	const long RSIZE = run_record_size(CELLS);
+	char* block = (char*)malloc(RSIZE * records_per_block);
+	if (block == NULL) {
+		cout << terminal_no_memory << endl;
+		exit(1);
+	}
+
+	while (ifile) {
+		ifile.read(block, RSIZE * records_per_block);
+		long records = ifile.gcount() / RSIZE;
+		for (long rn = 0; rn < records; rn++) {
+			char* record = block + rn * RSIZE;
+			double time;
+			memcpy(&time, record, sizeof(double));
+			ofile << time << "\t";
+			for (int n = 0; n < CELLS; n++) {
+				int32_t count;
+				memcpy(&count, record + sizeof(double) + n * sizeof(int32_t), sizeof(int32_t));
+				ofile << count << "\t";
+			}
+			ofile << "\n";
+		}
+	}
+
+	free(block);
+	ofile.close();
+
+	return 0;
+}
+
+// usage message shown when an argument option or option value is invalid
+void usage (const char* message) {
+	if (strcmp(message, "") != 0) { // if there is an error message to print then print it
+		cout << terminal_red << message << terminal_reset << endl << endl;
+	}
+	cout << "Usage: [-c|--no-color] <binary run file> <text output file>" << endl;
+	exit(0);
+}
+
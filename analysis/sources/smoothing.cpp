@@ -22,6 +22,8 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include <string>
 #include <string.h>
 
+#include "../../stochastic/source/run-file.h"
+
 // escape codes to color the terminal output and shortcuts for common outputs (set -c or --color to no to disable these)
 #define terminal_blue_d "\x1b[34m"
 #define terminal_red_d "\x1b[31m"
@@ -37,19 +39,6 @@ char* terminal_reset;
 
 void usage (const char*);
 
-int getfsize(char* fname) {
-	int count = 0;
-	ifstream ifile;
-	string line;	
-	ifile.open(fname, fstream::in);
-	while (!ifile.eof()) {
-		getline(ifile, line);
-		count++;
-	}
-	ifile.close();
-	return count;
-}
-
 int main(int argc, char** argv) {
 	// allocate memory for the terminal color code strings
 	terminal_blue = (char*)malloc(sizeof(terminal_blue_d));
@@ -67,14 +56,15 @@ int main(int argc, char** argv) {
 		usage("Smoothing requires input and output file names and the size of the interval to average on.");
 	}
 	
-	const int FSIZE = getfsize(argv[1]);	
-    ifstream ifile;
-    ifile.open(argv[1], fstream::in);
+    run_reader ifile; // the input can be a text or binary run file (see run-file.h)
+    if (!ifile.open(argv[1])) {
+		usage("Couldn't open the input file.");
+	}
+	const int FSIZE = ifile.lines(argv[1]);
     ofstream ofile;
     ofile.open(argv[2], fstream::out);
 	const int MSIZE = atoi(argv[3]);
-	int r, c;
-	ifile >> r >> c;
+	int r = ifile.width, c = ifile.height;
 	const int CELLS = r * c;
 	double cell[CELLS][FSIZE];
 	double tstep[FSIZE];
@@ -84,9 +74,9 @@ int main(int argc, char** argv) {
 	
     //calculating the first value requires the first MSIZE / 2 values 
     for (int i = 0; i <= MSIZE / 2; i++) {
-        ifile >> tstep[i];
+        ifile.read_time(tstep[i]);
 		for (int n = 0; n < CELLS; n++) {
-			ifile >> cell[n][i];
+			ifile.read_value(cell[n][i]);
 			sum[n] += cell[n][i];
 		}
     }
@@ -99,9 +89,9 @@ int main(int argc, char** argv) {
 	int cellindex = 1;
     //the next MSIZE / 2 values require incrementally more values
     for (int i = (MSIZE / 2) + 1; i < MSIZE; i++) {
-        ifile >> tstep[i];
+        ifile.read_time(tstep[i]);
 		for (int n = 0; n < CELLS; n++) {
-			ifile >> cell[n][i];
+			ifile.read_value(cell[n][i]);
 			sum[n] += cell[n][i];
 		}
         ofile << tstep[cellindex] << "\t";
@@ -115,9 +105,9 @@ int main(int argc, char** argv) {
     // the next values require all MSIZE values 
     int addindex = MSIZE, removeindex = 0;
     while (!ifile.eof() && addindex < FSIZE) {
-        ifile >> tstep[addindex];
+        ifile.read_time(tstep[addindex]);
 		for (int n = 0; n < CELLS; n++) {
-			ifile >> cell[n][addindex];
+			ifile.read_value(cell[n][addindex]);
 			sum[n] += cell[n][addindex];
 		}
         addindex++;
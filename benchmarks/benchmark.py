@@ -0,0 +1,155 @@
+"""
+Benchmark suite for the stochastic and deterministic simulators
+Copyright (C) 2012 Ahmet Ay, Jack Holland, Adriana Sperlea
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+Runs every benchmark scenario with a fixed seed and prints the results as JSON (run by "make bench", which builds the simulators first).
+Every scenario runs in its own empty directory, so its output bytes are everything it printed there.
+Usage: benchmark.py <stochastic binary> <deterministic binary> <parameter file> [--scenarios name,...] [--output file]
+The parameter file's first line is the stochastic simulator's input; the deterministic simulator generates its parameter sets from the seed.
+If a simulator's binary doesn't exist, its scenarios are skipped unless they're chosen with --scenarios.
+"""
+
+import argparse
+import json
+import os
+import platform
+import shutil
+import subprocess
+import sys
+import tempfile
+import time
+
+seed = 1
+epsilon = 0.01 # the deterministic simulator's Euler timestep
+
+# name, width, height, minutes (larger tissues simulate fewer minutes so every scenario takes a similar time)
+tissues = [("2x1", 2, 1, 600), ("chain10", 10, 1, 600), ("8x8", 8, 8, 120), ("16x16", 16, 16, 60), ("32x32", 32, 32, 20)]
+
+# name, parameter sets, minutes
+parameter_sets = [("1", 1, 600), ("10k", 10000, 600)]
+
+def scenarios():
+	for name, width, height, minutes in tissues:
+		for mode in ["exact", "appx", "langevin"]:
+			yield {"name": "stochastic-" + name + "-" + mode, "simulator": "stochastic", "width": width, "height": height, "minutes": minutes,
+			       "approximate": mode == "appx", "langevin": mode == "langevin"}
+	for name, sets, minutes in parameter_sets:
+		yield {"name": "deterministic-" + name, "simulator": "deterministic", "sets": sets, "minutes": minutes}
+
+# run a command in the given directory, returning its wall seconds and peak resident set size in kilobytes
+def measure(command, directory):
+	start = time.time()
+	process = subprocess.Popen(command, cwd=directory, stdout=subprocess.DEVNULL, stderr=subprocess.DEVNULL)
+	_, status, usage = os.wait4(process.pid, 0)
+	seconds = time.time() - start
+	process.returncode = os.waitstatus_to_exitcode(status)
+	if process.returncode != 0:
+		sys.exit(" ".join(command) + " failed with exit code " + str(process.returncode))
+	return seconds, usage.ru_maxrss
+
+# the number of bytes of every file under the given directory
+def directory_bytes(directory):
+	total = 0
+	for root, _, files in os.walk(directory):
+		for name in files:
+			total += os.path.getsize(os.path.join(root, name))
+	return total
+
+def run_scenario(scenario, stochastic, deterministic, parameters):
+	directory = tempfile.mkdtemp(prefix="bench-")
+	try:
+		if scenario["simulator"] == "stochastic":
+			# the hot-path statistics count the steps, which is why the benchmark binary is built with them (see stochastic/source/run-stats.h)
+			shutil.copy(parameters, os.path.join(directory, "input.txt"))
+			command = [stochastic, "-x", str(scenario["width"]), "-y", str(scenario["height"]), "-m", str(scenario["minutes"]), "-r", "1", "-s", str(seed),
+			           "-i", "input.txt", "-o", "output", "-z", "-c"]
+			if scenario["approximate"]:
+				command.append("-a")
+			if scenario["langevin"]:
+				command.append("-L")
+			seconds, rss = measure(command, directory)
+			with open(os.path.join(directory, "output", "stats.json")) as stats_file:
+				stats = json.load(stats_file)
+			steps = sum(run["nrm_steps"] + run["leaps"] + run["langevin_steps"] for run in stats["runs"])
+			minutes = scenario["minutes"]
+			os.remove(os.path.join(directory, "input.txt"))
+		else:
+			# the deterministic simulator doesn't count its steps, but every set simulates the wild type for minutes / epsilon Euler steps, so those are the ones counted
+			command = [deterministic, "-x", "2", "-y", "1", "-m", str(scenario["minutes"]), "-e", str(epsilon), "-p", str(scenario["sets"]), "-s", str(seed), "-o", "output", "-c"]
+			seconds, rss = measure(command, directory)
+			steps = scenario["sets"] * int(scenario["minutes"] / epsilon)
+			minutes = scenario["sets"] * scenario["minutes"]
+		return {"wall_seconds": round(seconds, 3),
+		        "simulated_minutes": minutes,
+		        "minutes_per_second": minutes / seconds,
+		        "steps": steps,
+		        "steps_per_second": steps / seconds,
+		        "peak_rss_kb": rss,
+		        "output_bytes": directory_bytes(directory)}
+	finally:
+		shutil.rmtree(directory)
+
+def main():
+	parser = argparse.ArgumentParser(description="Run the simulators' benchmark scenarios and print the results as JSON.")
+	parser.add_argument("stochastic", help="the stochastic simulator, built with SIM_STATS defined")
+	parser.add_argument("deterministic", help="the deterministic simulator")
+	parser.add_argument("parameters", help="a parameter file whose first line is the stochastic simulator's input")
+	parser.add_argument("--scenarios", help="a comma-separated list of the scenarios to run, default=every scenario")
+	parser.add_argument("--output", help="the file to print the results to instead of standard output")
+	args = parser.parse_args()
+
+	parameters = tempfile.NamedTemporaryFile("w", suffix=".txt", delete=False)
+	with open(args.parameters) as full:
+		parameters.write(full.readline())
+	parameters.close()
+
+	results = {"machine": {"platform": platform.platform(), "processor": platform.processor(), "cpus": os.cpu_count()},
+	           "seed": seed,
+	           "scenarios": {}}
+	names = [scenario["name"] for scenario in scenarios()]
+	chosen = args.scenarios.split(",") if args.scenarios else names
+	for name in chosen:
+		if name not in names:
+			sys.exit("There is no scenario named " + name + "! The scenarios are " + ", ".join(names) + ".")
+	binaries = {"stochastic": args.stochastic, "deterministic": args.deterministic}
+	for simulator, binary in sorted(binaries.items()):
+		if os.path.isfile(binary):
+			continue
+		if args.scenarios and any(scenario["simulator"] == simulator and scenario["name"] in chosen for scenario in scenarios()):
+			sys.exit("The " + simulator + " simulator " + binary + " doesn't exist!")
+		sys.stderr.write("Skipping the " + simulator + " scenarios, since " + binary + " doesn't exist\n")
+		chosen = [name for name in chosen if not name.startswith(simulator + "-")]
+	try:
+		for scenario in scenarios():
+			if scenario["name"] not in chosen:
+				continue
+			sys.stderr.write("Running " + scenario["name"] + " ... ")
+			sys.stderr.flush()
+			result = run_scenario(scenario, os.path.abspath(args.stochastic), os.path.abspath(args.deterministic), parameters.name)
+			results["scenarios"][scenario["name"]] = result
+			sys.stderr.write("%.1f minutes/s, %.0f steps/s\n" % (result["minutes_per_second"], result["steps_per_second"]))
+	finally:
+		os.remove(parameters.name)
+
+	text = json.dumps(results, indent=1, sort_keys=True) + "\n"
+	if args.output:
+		with open(args.output, "w") as output:
+			output.write(text)
+	else:
+		sys.stdout.write(text)
+
+if __name__ == "__main__":
+	main()
@@ -0,0 +1,66 @@
+"""
+Benchmark comparison for the stochastic and deterministic simulators
+Copyright (C) 2012 Ahmet Ay, Jack Holland, Adriana Sperlea
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+Compares benchmark results (from benchmark.py) with a stored baseline and flags every regression:
+a throughput (simulated minutes or steps per second) lower than the baseline's, or a peak memory or output size higher than the baseline's, by more than the tolerance.
+Exits with 1 if anything regressed, so "make bench" fails.
+Usage: compare.py <baseline> <results> [--tolerance fraction]
+"""
+
+import argparse
+import json
+import sys
+
+# metric, whether higher is better
+metrics = [("minutes_per_second", True), ("steps_per_second", True), ("peak_rss_kb", False), ("output_bytes", False)]
+
+def main():
+	parser = argparse.ArgumentParser(description="Flag benchmark regressions against a baseline.")
+	parser.add_argument("baseline", help="the stored baseline results")
+	parser.add_argument("results", help="the new results")
+	parser.add_argument("--tolerance", type=float, default=0.1, help="the fraction a metric can get worse by before it's a regression, default=0.1")
+	args = parser.parse_args()
+
+	with open(args.baseline) as baseline_file:
+		baseline = json.load(baseline_file)["scenarios"]
+	with open(args.results) as results_file:
+		results = json.load(results_file)["scenarios"]
+
+	regressions = 0
+	print("%-28s %-20s %14s %14s %8s" % ("scenario", "metric", "baseline", "result", "change"))
+	for name in sorted(results):
+		if name not in baseline:
+			print("%-28s (not in the baseline)" % name)
+			continue
+		for metric, higher_is_better in metrics:
+			old = baseline[name][metric]
+			new = results[name][metric]
+			change = (new - old) / old if old != 0 else 0
+			regressed = change < -args.tolerance if higher_is_better else change > args.tolerance
+			regressions += regressed
+			print("%-28s %-20s %14.6g %14.6g %+7.1f%%%s" % (name, metric, old, new, change * 100, "  REGRESSION" if regressed else ""))
+	for name in sorted(baseline):
+		if name not in results:
+			print("%-28s (not run)" % name)
+
+	if regressions > 0:
+		print("%d regression%s beyond %.0f%%" % (regressions, "" if regressions == 1 else "s", args.tolerance * 100))
+		sys.exit(1)
+	print("No regressions beyond %.0f%%" % (args.tolerance * 100))
+
+if __name__ == "__main__":
+	main()
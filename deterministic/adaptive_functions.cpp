@@ -0,0 +1,312 @@
+/*
+ Deterministic simulator for the zebrafish segmentation clock.
+ Copyright (C) 2012 Ahmet Ay, Jack Holland, Adriana Sperlea
+ 
+ This program is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+ 
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+ 
+ You should have received a copy of the GNU General Public License
+ along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <algorithm>
+#include <cstring>
+#include <math.h>
+
+#include "functions.h"
+#include "adaptive_functions.h"
+#include "macros.h"
+
+using namespace std;
+
+history::history (int width) {
+    /*
+     Constructor for the structure in which the recent steps of an adaptive simulation will be stored.
+     width is the number of levels stored per step.
+     */
+    this->width = width;
+    clear();
+}
+
+void history::clear () {
+    /*
+     Forgets the steps of a previous simulation.
+     */
+    t.clear();
+    y.clear();
+    dy.clear();
+    first = 0;
+    for (int j = 0; j < NUM_DELAYS; j++) {
+        last_found[j] = 0;
+    }
+}
+
+void history::add (double time, const double *levels, const double *derivatives) {
+    /*
+     Stores a step at the given time with its levels and derivatives.
+     */
+    t.push_back(time);
+    y.insert(y.end(), levels, levels + width);
+    dy.insert(dy.end(), derivatives, derivatives + width);
+}
+
+void history::forget (double time) {
+    /*
+     Drops the steps which are no longer needed to interpolate the levels at the given time or later.
+     The dropped steps are only erased once they make up half of the history, so each step is moved at most once.
+     */
+    int steps = t.size();
+    while (first + 1 < steps && t[first + 1] <= time) {
+        first++;
+    }
+    if (first > 256 && 2 * first > steps) {
+        t.erase(t.begin(), t.begin() + first);
+        y.erase(y.begin(), y.begin() + first * width);
+        dy.erase(dy.begin(), dy.begin() + first * width);
+        for (int j = 0; j < NUM_DELAYS; j++) {
+            last_found[j] = max(0, last_found[j] - first);
+        }
+        first = 0;
+    }
+}
+
+void past::find (history *h, int delay, double time) {
+    /*
+     Prepares to read the levels at the given time, interpolating between the steps of the history on either side of it.
+     The search starts from the step the given delay was last read from.
+     */
+    int steps = h->t.size();
+    before = time <= 0 || steps < 2;
+    if (before) {
+        return;
+    }
+    int k = max(h->first, min(h->last_found[delay], steps - 2));
+    while (k + 2 < steps && h->t[k + 1] <= time) {
+        k++;
+    }
+    while (k > h->first && h->t[k] > time) {
+        k--;
+    }
+    h->last_found[delay] = k;
+    y0 = &h->y[k * h->width], y1 = &h->y[(k + 1) * h->width];
+    dy0 = &h->dy[k * h->width], dy1 = &h->dy[(k + 1) * h->width];
+    
+    // The cubic Hermite polynomials of the position of the time within the step
+    double span = h->t[k + 1] - h->t[k];
+    double th = span > 0 ? (time - h->t[k]) / span : 0;
+    w0 = (2 * th - 3) * th * th + 1;
+    w1 = (3 - 2 * th) * th * th;
+    v0 = span * ((th - 2) * th + 1) * th;
+    v1 = span * (th - 1) * th * th;
+}
+
+void past::current (const double *levels) {
+    /*
+     Prepares to read the given levels themselves, for a delay of 0.
+     */
+    before = false;
+    y0 = y1 = dy0 = dy1 = levels;
+    w0 = 1, w1 = 0, v0 = 0, v1 = 0;
+}
+
+void derivatives(double time, const double *y, double *dy, history *h, rates *r, const double delay[], glevels *g)
+{
+    /*
+     Computes the derivatives of every concentration in every cell at the given time, from the levels y and the history of the simulation.
+     These are the differential equations model() takes Euler steps of, with the neighbors g found for the tissue.
+     */
+    int cells = g->cells;
+    double *rt = r->curr_rates;
+    past p[NUM_DELAYS];
+    for (int j = 0; j < NUM_DELAYS; j++) {
+        if (j == RDELAYMH13 - RDELAYMH1) {
+            continue; // her13 mRNA is not regulated, so its transcription delay isn't used
+        }
+        if (delay[j] > 0) {
+            p[j].find(h, j, time - delay[j]);
+        } else {
+            p[j].current(y);
+        }
+    }
+    const past &pmh1 = p[RDELAYMH1 - RDELAYMH1], &pmh7 = p[RDELAYMH7 - RDELAYMH1], &pmd = p[RDELAYMDELTA - RDELAYMH1];
+    const past &pph1 = p[RDELAYPH1 - RDELAYMH1], &pph7 = p[RDELAYPH7 - RDELAYMH1], &pph13 = p[RDELAYPH13 - RDELAYMH1], &ppd = p[RDELAYPDELTA - RDELAYMH1];
+    
+    // Average the delayed delta protein of every cell's neighbors once per delay, interpolating each cell's level only once (see model())
+    const past *regulated[] = {&pmh1, &pmh7, &pmd};
+    double *avg[] = {g->avgpdh1, g->avgpdh7, g->avgpdd};
+    for (int j = 0; j < 3; j++) {
+        for (int i = 0; i < cells; i++) {
+            g->delayed[i] = regulated[j]->level(SPDELTA * cells + i);
+        }
+        average_neighbors(g->delayed, avg[j], cells, g->neighbors, g->nc);
+    }
+    
+    for (int i = 0; i < cells; i++) {
+        double ph1 = y[SPH1 * cells + i], ph7 = y[SPH7 * cells + i], ph13 = y[SPH13 * cells + i], pd = y[SPDELTA * cells + i];
+        double ph11 = y[SPH11 * cells + i], ph17 = y[SPH17 * cells + i], ph113 = y[SPH113 * cells + i];
+        double ph77 = y[SPH77 * cells + i], ph713 = y[SPH713 * cells + i], ph1313 = y[SPH1313 * cells + i];
+        double mh1 = y[SMH1 * cells + i], mh7 = y[SMH7 * cells + i], mh13 = y[SMH13 * cells + i], md = y[SMDELTA * cells + i];
+        
+        //Protein synthesis
+        dy[SPH1 * cells + i] = rt[RPSH1] * pph1.level(SMH1 * cells + i) - rt[RPDH1] * ph1 - 2 * rt[RDAH1H1] * ph1 * ph1 + 2 * rt[RDDIH1H1] * ph11 - rt[RDAH1H7] * ph1 * ph7 + rt[RDDIH1H7] * ph17 - rt[RDAH1H13] * ph1 * ph13 + rt[RDDIH1H13] * ph113;
+        dy[SPH7 * cells + i] = rt[RPSH7] * pph7.level(SMH7 * cells + i) - rt[RPDH7] * ph7 - 2 * rt[RDAH7H7] * ph7 * ph7 + 2 * rt[RDDIH7H7] * ph77 - rt[RDAH1H7] * ph1 * ph7 + rt[RDDIH1H7] * ph17 - rt[RDAH7H13] * ph7 * ph13 + rt[RDDIH7H13] * ph713;
+        dy[SPH13 * cells + i] = rt[RPSH13] * pph13.level(SMH13 * cells + i) - rt[RPDH13] * ph13 - 2 * rt[RDAH13H13] * ph13 * ph13 + 2 * rt[RDDIH13H13] * ph1313 - rt[RDAH1H13] * ph1 * ph13 + rt[RDDIH1H13] * ph113 - rt[RDAH7H13] * ph7 * ph13 + rt[RDDIH7H13] * ph713;
+        
+        //Dimer proteins
+        dy[SPH11 * cells + i] = rt[RDAH1H1] * ph1 * ph1 - rt[RDDIH1H1] * ph11 - rt[RDDGH1H1] * ph11;
+        dy[SPH17 * cells + i] = rt[RDAH1H7] * ph1 * ph7 - rt[RDDIH1H7] * ph17 - rt[RDDGH1H7] * ph17;
+        dy[SPH113 * cells + i] = rt[RDAH1H13] * ph1 * ph13 - rt[RDDIH1H13] * ph113 - rt[RDDGH1H13] * ph113;
+        dy[SPH77 * cells + i] = rt[RDAH7H7] * ph7 * ph7 - rt[RDDIH7H7] * ph77 - rt[RDDGH7H7] * ph77;
+        dy[SPH713 * cells + i] = rt[RDAH7H13] * ph7 * ph13 - rt[RDDIH7H13] * ph713 - rt[RDDGH7H13] * ph713;
+        dy[SPH1313 * cells + i] = rt[RDAH13H13] * ph13 * ph13 - rt[RDDIH13H13] * ph1313 - rt[RDDGH13H13] * ph1313;
+        
+        // Delta Protein
+        dy[SPDELTA * cells + i] = rt[RPSDELTA] * ppd.level(SMDELTA * cells + i) - rt[RPDDELTA] * pd;
+        
+        // mRNA Synthesis
+        dy[SMH1 * cells + i] = fh1(pmh1.level(SPH11 * cells + i), pmh1.level(SPH713 * cells + i), g->avgpdh1[i], rt[RMSH1], rt[RCRITPH1H1], rt[RCRITPH7H13], rt[RCRITPDELTA]) - rt[RMDH1] * mh1;
+        dy[SMH7 * cells + i] = fh7(pmh7.level(SPH11 * cells + i), pmh7.level(SPH713 * cells + i), g->avgpdh7[i], rt[RMSH7], rt[RCRITPH1H1], rt[RCRITPH7H13], rt[RCRITPDELTA]) - rt[RMDH7] * mh7;
+        dy[SMH13 * cells + i] = rt[RMSH13] - rt[RMDH13] * mh13;
+        dy[SMDELTA * cells + i] = fd(pmd.level(SPH11 * cells + i), pmd.level(SPH713 * cells + i), g->avgpdd[i], rt[RMSDELTA], rt[RCRITPH1H1], rt[RCRITPH7H13], rt[RCRITPDELTA]) - rt[RMDDELTA] * md;
+    }
+}
+
+void store_levels(glevels *g, const double *y, int cells)
+{
+    /*
+     Copies the levels of the first two cells into the first slot of the ring buffers, where checkPropensities reads them.
+     */
+    double** levels[] = {g->ph1, g->ph7, g->ph13, g->pd, g->ph11, g->ph17, g->ph113, g->ph77, g->ph713, g->ph1313, g->mh1, g->mh7, g->mh13, g->md}; // in the order of macros.h
+    for (int s = 0; s < NUM_SPECIES; s++) {
+        for (int i = 0; i < 2; i++) {
+            levels[s][i][0] = y[s * cells + i];
+        }
+    }
+}
+
+bool model_adaptive(double eps, int nfinal, glevels *g, rates *r, double max_prop, int columns, int rows, double tolerance){
+    /*
+     Runs the deterministic simulation of the model with the Bogacki-Shampine method (see adaptive_functions.h), over the same nfinal * eps minutes as model().
+     For each step:
+     1) Take the three stages of the method and estimate the error of the step from the derivative at its end
+     2) Retry the step with a smaller size if the error is over the tolerance, relative to the levels plus tolerance molecules
+     3) Otherwise check that the concentrations do not become negative and the propensity functions do not go above the set threshold, like model()
+     4) Sample the first cell's her1 mRNA every eps minutes of the step, for finding peaks and troughs and for printing
+     5) Choose the size of the next step from the error of this one
+     The steps never cross a delay or a change of the gradient rates, since the derivatives jump there, and are never longer than the shortest delay,
+     so every delayed level has already been computed.
+     */
+    int cells = rows * columns;
+    int width = NUM_SPECIES * cells;
+    
+    // The delays, and the shortest and longest of them
+    double delay[NUM_DELAYS];
+    double shortest = INFINITY, longest = 0;
+    for (int j = 0; j < NUM_DELAYS; j++) {
+        delay[j] = j == RDELAYMH13 - RDELAYMH1 ? 0 : r->curr_rates[RDELAYMH1 + j];
+        if (delay[j] > 0 && delay[j] < shortest) shortest = delay[j];
+        if (delay[j] > longest) longest = delay[j];
+    }
+    g->reserve(0);
+    
+    // The rates change every nfinal/50 steps when there are gradients, at the same times as in model()
+    int step_size = nfinal/50;
+    int segment = 0;
+    update_rate(r, 0);
+    
+    vector<double> y(width, 0.0), y1(width), stage(width), k1(width), k2(width), k3(width), k4(width);
+    history h(width);
+    derivatives(0, &y[0], &k1[0], &h, r, delay, g);
+    h.add(0, &y[0], &k1[0]);
+    
+    double t = 0, tend = (nfinal - 1) * eps;
+    double step = eps; // the size of the next step to try
+    int n = 0; // the last step of eps minutes sampled
+    double before = 0, level = 0; // the first cell's her1 mRNA at steps n - 1 and n
+    while (t < tend) {
+        // Find where the step ends
+        double limit = min(tend, t + shortest);
+        for (int j = 0; j < NUM_DELAYS; j++) {
+            if (delay[j] > t && delay[j] < limit) limit = delay[j];
+        }
+        double next_rates = r->using_gradients && step_size > 0 ? (segment + 1) * step_size * eps : INFINITY;
+        if (next_rates < limit) limit = next_rates;
+        bool shortened = t + step > limit;
+        double t1 = shortened ? limit : t + step;
+        double hs = t1 - t;
+        
+        // Take the stages
+        for (int k = 0; k < width; k++) stage[k] = y[k] + hs / 2 * k1[k];
+        derivatives(t + hs / 2, &stage[0], &k2[0], &h, r, delay, g);
+        for (int k = 0; k < width; k++) stage[k] = y[k] + 3 * hs / 4 * k2[k];
+        derivatives(t + 3 * hs / 4, &stage[0], &k3[0], &h, r, delay, g);
+        for (int k = 0; k < width; k++) y1[k] = y[k] + hs * (2 * k1[k] / 9 + k2[k] / 3 + 4 * k3[k] / 9);
+        derivatives(t1, &y1[0], &k4[0], &h, r, delay, g);
+        
+        // Estimate the error from the difference with the embedded second order step
+        double error = 0;
+        for (int k = 0; k < width; k++) {
+            double e = hs * (-5 * k1[k] / 72 + k2[k] / 12 + k3[k] / 9 - k4[k] / 8);
+            double scale = tolerance * (1 + max(fabs(y[k]), fabs(y1[k])));
+            error = max(error, fabs(e) / scale);
+        }
+        double factor = error > 0 ? min(5.0, max(0.2, 0.9 * pow(error, -1.0 / 3))) : 5.0;
+        if (error > 1 && hs > 1e-9) {
+            step = hs * factor;
+            continue;
+        }
+        
+        for (int k = 0; k < width; k++) {
+            if (y1[k] < 0) {
+                return false;
+            }
+        }
+        if (max_prop != INFINITY) {
+            store_levels(g, &y1[0], cells);
+            if (!checkPropensities(g, r, 0, max_prop)) {
+                return false;
+            }
+        }
+        
+        // Sample the first cell's her1 mRNA every eps minutes, like the steps of model()
+        const int mh1 = SMH1 * cells;
+        while (n + 1 < nfinal && (n + 1) * eps <= t1) {
+            n++;
+            double th = ((n * eps) - t) / hs;
+            double after = ((2 * th - 3) * th * th + 1) * y[mh1] + (3 - 2 * th) * th * th * y1[mh1] + hs * (((th - 2) * th + 1) * th * k1[mh1] + (th - 1) * th * th * k4[mh1]);
+            if (g->record_step > 0 && n % g->record_step == 0) {
+                g->record[n / g->record_step] = after;
+            }
+            if (n >= 2) {
+                g->mh1_peaks.track(n - 1, nfinal, eps, before, level, after);
+            }
+            before = level;
+            level = after;
+        }
+        
+        // Move on to the end of the step
+        t = t1;
+        y.swap(y1);
+        k1.swap(k4);
+        h.add(t, &y[0], &k1[0]);
+        if (t >= next_rates) {
+            // The rates change here, so the derivative does too
+            segment++;
+            update_rate(r, min(segment, r->steps - 1));
+            derivatives(t, &y[0], &k1[0], &h, r, delay, g);
+            h.add(t, &y[0], &k1[0]);
+        }
+        h.forget(t - longest);
+        if (!shortened) {
+            step = hs * factor;
+        }
+    }
+    return true;
+}
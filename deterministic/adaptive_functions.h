@@ -0,0 +1,74 @@
+/*
+ Deterministic simulator for the zebrafish segmentation clock.
+ Copyright (C) 2012 Ahmet Ay, Jack Holland, Adriana Sperlea
+ 
+ This program is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+ 
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+ 
+ You should have received a copy of the GNU General Public License
+ along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ Euler's method needs a tiny time step to resolve the oscillations accurately, so model_adaptive offers a higher-order alternative:
+ the Bogacki-Shampine Runge-Kutta pair (third order with an embedded second order error estimate) with the step size chosen to keep the estimated error under a tolerance.
+ The levels at delayed times are interpolated between the recent steps with the cubic Hermite polynomials of their levels and derivatives,
+ which keeps the interpolation as accurate as the steps themselves.
+ The first cell's her1 mRNA is sampled from the same interpolation every eps minutes, so the peaks, troughs and recorded levels are found on the same grid as Euler's method finds them.
+ */
+
+#include <vector>
+
+#include "functions.h"
+#include "macros.h"
+
+using namespace std;
+
+#ifndef ADAPTIVE_H
+#define ADAPTIVE_H
+
+#define NUM_DELAYS (RDELAYPDELTA - RDELAYMH1 + 1) // the delays are stored consecutively in the rates (see macros.h)
+
+struct history {
+    /*
+     Structure for storing the recent steps of an adaptive simulation.
+     Every step stores its time, the levels of every concentration in every cell (NUM_SPECIES per cell, see macros.h) and their derivatives.
+     Steps which are further back than the longest delay are dropped as the simulation goes.
+     */
+    int width; // the number of levels stored per step
+    int first; // the index of the oldest step still kept
+    int last_found[NUM_DELAYS]; // the index of the step each delay was last interpolated from, since the delayed times mostly move forward
+    vector<double> t, y, dy;
+
+    history(int);
+    void clear();
+    void add(double, const double*, const double*);
+    void forget(double);
+};
+
+struct past {
+    /*
+     Structure for reading the levels at a delayed time, interpolated from the history.
+     Levels before the start of the simulation are 0, like the levels Euler's method reads before a delay has passed.
+     */
+    const double *y0, *y1, *dy0, *dy1; // the levels and derivatives of the steps on either side of the delayed time
+    double w0, w1, v0, v1; // the Hermite weights of those levels and derivatives
+    bool before; // whether the delayed time is before the start of the simulation
+
+    void find(history*, int, double);
+    void current(const double*);
+    inline double level(int k) const {
+        return before ? 0 : w0 * y0[k] + w1 * y1[k] + v0 * dy0[k] + v1 * dy1[k];
+    }
+};
+
+bool model_adaptive(double, int, glevels*, rates*, double, int, int, double);
+
+#endif
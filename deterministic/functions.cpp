@@ -26,6 +26,7 @@
 #include <math.h>
 
 #include "functions.h"
+#include "adaptive_functions.h"
 #include "macros.h"
 
 using namespace std;
@@ -135,10 +136,10 @@ void reset_rate(rates *rs){
     }
 }
 
-void printForPlotting(string file, glevels* x, int nfinal, double eps) {
+void printForPlotting(string file, glevels* x, int nfinal) {
     /*
      Prints the concentrations of her1 mRNA into a specified output file.
-     The concentrations are printed every 0.1 minutes of the simulation.
+     The concentrations are printed every record_step steps of the simulation (every 0.1 minutes).
      */
     ofstream plot;
     cerr << file.c_str() << endl;
@@ -148,9 +149,9 @@ void printForPlotting(string file, glevels* x, int nfinal, double eps) {
         cerr << terminal_red << "Couldn't open file " << file << " for plotting! Exit status 1." << terminal_reset << endl;
         exit(1);
     }
-    int step = (int) (0.1 / eps);
+    int step = x->record_step;
     for (int n = 0; n < nfinal; n += step) {
-        plot << n << " " << x->mh1[0][n] << endl;
+        plot << n << " " << x->record[n / step] << endl;
     }
     plot.close();
 }
@@ -163,7 +164,7 @@ void usage (const char* message) {
     cout << "Usage: [-option [value]]... [--option [value]]..." << endl;
     cout << "-x, --width        : the tissue width (in cells), 2 for two-cell system, min=3 for chain, min=4 and even for tissue, default=3" << endl;
     cout << "-y, --height       : the tissue height (in cells), 1 for two-cell system and chain, min=4 and even for tissue, default=1" << endl;
-    cout << "-e, --epsilon      : the size of the timestep to be used for solving the DDEs using Euler's method" << endl;
+    cout << "-e, --epsilon      : the size of the timestep to be used for solving the DDEs using Euler's method, or between the concentrations sampled with -t" << endl;
     cout << "-m, --minutes      : the maximum number of minutes to simulate before ending, min=1, default=1200" << endl;
     cout << "-f, --ofeatures    : the path and file in which to print oscillation features" << endl;
     cout << "-p, --parameters   : the number of parameters for which to simulate the model, min=1, default=1" << endl;
@@ -171,6 +172,9 @@ void usage (const char* message) {
     cout << "-i, --input        : the input path and file to accept parameters from, default=input.txt" << endl;
     cout << "-o, --output       : the path and file to print the output (i.e. parameters which passed conditions) to, default=det-allpassed.csv" << endl;
     cout << "-a, --propensities : the threshold for the propensity functions which could be used in the stochastic simulation, min=1, default=none" << endl;
+    cout << "-t, --tolerance    : solve the DDEs with an adaptive Runge-Kutta method, keeping the relative error of each step under this tolerance, e.g. 1e-6, default=unused" << endl;
+    cout << "-n, --threads      : the number of parameter sets to simulate at the same time, min=1, default=1" << endl;
+    cout << "-v, --vectorize    : simulate as many parameter sets at once on each thread as fit in the vector registers, default=unused" << endl;
     cout << "-w, --write        : print the concentrations of the simulations to file, default=unused" << endl;
     cout << "-c, --no-color     : disable coloring the terminal output, default=unused" << endl;
     cout << "-q, --quiet        : hide the terminal output, default=unused" << endl;
@@ -196,6 +200,7 @@ void licensing () {
 bool checkPropensities(glevels *x, rates *pars, int sn, double CUTOFF) {
     /*
      Checks that the propensity functions which could be used in a stochastic simulation do not go over the set CUTOFF.
+     sn is the index of the step to check in the ring buffers.
      Returns true if all propensities are < CUTOFF and false otherwise.
      */
     if (pars->curr_rates[RPSH1]       * x->mh1[0][sn] > CUTOFF) return false;
@@ -380,21 +385,15 @@ void store_values(char* input_file, char* buffer, int &index, rates **rateValues
     }    
 }
 
-void clear_levels(glevels *old, int nfinal, int cells){
+void clear_levels(glevels *old){
     /*
-     Clears concentrations from previous simulations.
+     Clears the peaks and recorded levels from previous simulations.
+     The ring buffers don't need clearing since model() clears each step before computing it.
      */
-    for (int i = 0; i < cells; i++) {
-        for(int j = 0; j < nfinal; j++) {
-            old->mh1[i][j] = 0, old->ph1[i][j] = 0;
-            old->mh7[i][j] = 0, old->ph7[i][j] = 0;
-            old->mh13[i][j] = 0, old->ph13[i][j] = 0;
-            old->md[i][j] = 0, old->pd[i][j] = 0;
-            old->ph11[i][j] = 0, old->ph17[i][j] = 0;
-            old->ph113[i][j] = 0, old->ph77[i][j] = 0;
-            old->ph713[i][j] = 0, old->ph1313[i][j] = 0;
-        }
-    }   
+    old->mh1_peaks.clear();
+    if (old->record_step > 0) {
+        memset(old->record, 0, sizeof(double) * (old->nfinal / old->record_step + 1));
+    }
 }
 
 int fix(int x, int end)
@@ -404,6 +403,71 @@ int fix(int x, int end)
     return x;
 }
 
+int cells_neighbors(int columns, int rows, int nc[][MAX_NEIGHBORS])
+{
+    /*
+     Finds the neighbors of every cell once for the shape of the tissue, so model() only has to look them up.
+     Returns the number of neighbors every cell has, whose indices are stored in nc[cell].
+     In two-cell systems, both cells are neighbors of each other. Chains wrap horizontally and hexagonal
+     tissue grids wrap horizontally and vertically like a honeycomb.
+     Two-cell systems look like this:
+     ___  ___
+     /   \/   \             where 1 and 2 are neighbors of each other
+     | 1 || 2 |
+     \___/\___/
+     
+     Chains of cells look like this:
+     ___  ___  ___  ___
+     /   \/   \/   \/   \   where x has neighbors n
+     | n || x || n ||   |
+     \___/\___/\___/\___/
+     
+     Tissues of cells look like this:
+      ___  ___  ___  ___
+     /   \/   \/   \/   \   where x has neighbors n
+     |   || n || n ||   |
+     \___/\___/\___/\___/_
+     /   \/   \/   \/   \
+     | n || x || n ||   |
+     \___/\___/\___/\___/
+     /   \/   \/   \/   \
+     |   || n || n ||   |
+     \___/\___/\___/\___/
+     /   \/   \/   \/   \
+     |   ||   ||   ||   |
+     \___/\___/\___/\___/
+     The neighbors are listed in the order their delta protein is added up, which decides the last bits of the averages.
+     */
+    int cells = columns * rows;
+    if (rows == 1) {
+        if (columns == 2) {
+            // If there are only two cells, the only delta input is coming from the other cell
+            nc[0][0] = 1;
+            nc[1][0] = 0;
+            return 1;
+        }
+        
+        // If there is a chain of cells, the delta input is coming from the two cells to the left and right
+        for (int i = 0; i < cells; i++) {
+            nc[i][0] = fix(i - 1, columns);
+            nc[i][1] = fix(i + 1, columns);
+        }
+        return 2;
+    }
+    
+    int dx[] = {0, 0, -1, -1, 1, 1};
+    int dyeven[] = {1, -1, -1, 0, -1, 0}, dyodd[] = {1, -1, 0, 1, 0, 1};
+    for (int i = 0; i < cells; i++) {
+        int curi = i / columns, curj = i % columns;
+        int* dy = curi % 2 == 0 ? dyeven : dyodd;
+        for (int k = 0; k < 6; k++) {
+            int xx = fix(curi + dx[k], rows), yy = fix(curj + dy[k], columns); // check for wrapping
+            nc[i][k] = xx * columns + yy;
+        }
+    }
+    return 6;
+}
+
 bool model(double eps, int nfinal, glevels *g, rates *r, double max_prop, int columns, int rows){
     /*
      Runs the deterministic simulation of the model.
@@ -424,11 +488,21 @@ bool model(double eps, int nfinal, glevels *g, rates *r, double max_prop, int co
     ndelaymh1 = int(r->curr_rates[RDELAYMH1]/eps);
     ndelaymh7 = int(r->curr_rates[RDELAYMH7]/eps);
 
+    // The ring buffer indices of the delayed steps
     int nmh1, nph1; 
     int nmh7, nph7;
     int nph13;
     int nmd, npd;
 
+    // Make the ring buffers long enough to reach back to the longest delay
+    int longest = ndelayph1;
+    int delays[] = {ndelayph7, ndelayph13, ndelaypd, ndelaymd, ndelaymh1, ndelaymh7};
+    for (int k = 0; k < 6; k++) {
+        if (delays[k] > longest) longest = delays[k];
+    }
+    g->reserve(longest);
+    g->clear_step(0);
+
     int cells = rows * columns;
     int last_step = 1; //last step when we recalculate the rates based on gradient factors
     int step_size = nfinal/50; //the distance between 2 points we recalculate the rates
@@ -448,148 +522,179 @@ bool model(double eps, int nfinal, glevels *g, rates *r, double max_prop, int co
             update_rate(r, last_step/step_size + 1);            
             last_step = n;
         }
+        
+        // Find the ring buffer indices of the current step, the previous one and the delayed ones
+        g->clear_step(n);
+        int cur = n & g->mask, prev = (n - 1) & g->mask;
+        nmh1 = (n - ndelaymh1) & g->mask, nph1 = (n - ndelayph1) & g->mask;
+        nmh7 = (n - ndelaymh7) & g->mask, nph7 = (n - ndelayph7) & g->mask;
+        nph13 = (n - ndelayph13) & g->mask;
+        nmd = (n - ndelaymd) & g->mask, npd = (n - ndelaypd) & g->mask;
+        
+        // Average the delayed delta protein of every cell's neighbors once per delay, in one pass over the tissue (see cells_neighbors)
+        if (n > ndelaymh1) g->average_delta(nmh1, g->avgpdh1);
+        if (n > ndelaymh7) g->average_delta(nmh7, g->avgpdh7);
+        if (n > ndelaymd) g->average_delta(nmd, g->avgpdd);
+        
         for (int i = 0; i < cells; i++) {
-            nmh1 = ndelaymh1, nph1 = ndelayph1;
-            nmh7 = ndelaymh7, nph7 = ndelayph7;
-            nph13 = ndelayph13;
-            nmd = ndelaymd, npd = ndelaypd;
-    
             //Protein synthesis
-            g->ph1[i][n] = g->ph1[i][n - 1] + eps * ((n > nph1 ? r->curr_rates[RPSH1] * g->mh1[i][n - nph1]:0)-r->curr_rates[RPDH1]*g->ph1[i][n - 1]-2*r->curr_rates[RDAH1H1]*g->ph1[i][n - 1]*g->ph1[i][n - 1]+2*r->curr_rates[RDDIH1H1]*g->ph11[i][n - 1]-r->curr_rates[RDAH1H7]*g->ph1[i][n - 1]*g->ph7[i][n - 1]+r->curr_rates[RDDIH1H7]*g->ph17[i][n - 1]-r->curr_rates[RDAH1H13]*g->ph1[i][n - 1]*g->ph13[i][n - 1]+r->curr_rates[RDDIH1H13]*g->ph113[i][n - 1]);
-            g->ph7[i][n] = g->ph7[i][n - 1] + eps * ((n > nph7 ? r->curr_rates[RPSH7]*g->mh7[i][n - nph7]:0)-r->curr_rates[RPDH7]*g->ph7[i][n - 1]-2*r->curr_rates[RDAH7H7]*g->ph7[i][n - 1]*g->ph7[i][n - 1]+2*r->curr_rates[RDDIH7H7]*g->ph77[i][n - 1]-r->curr_rates[RDAH1H7]*g->ph1[i][n - 1]*g->ph7[i][n - 1]+r->curr_rates[RDDIH1H7]*g->ph17[i][n - 1]-r->curr_rates[RDAH7H13]*g->ph7[i][n - 1]*g->ph13[i][n - 1]+r->curr_rates[RDDIH7H13]*g->ph713[i][n - 1]);
-            g->ph13[i][n] = g->ph13[i][n - 1] + eps * ((n > nph13 ? r->curr_rates[RPSH13]*g->mh13[i][n - nph13]:0)-r->curr_rates[RPDH13]*g->ph13[i][n - 1]-2*r->curr_rates[RDAH13H13]*g->ph13[i][n - 1]*g->ph13[i][n - 1]+2*r->curr_rates[RDDIH13H13]*g->ph1313[i][n - 1]-r->curr_rates[RDAH1H13]*g->ph1[i][n - 1]*g->ph13[i][n - 1]+r->curr_rates[RDDIH1H13]*g->ph113[i][n - 1]-r->curr_rates[RDAH7H13]*g->ph7[i][n - 1]*g->ph13[i][n - 1]+r->curr_rates[RDDIH7H13]*g->ph713[i][n - 1]);
-            if (g->ph1[i][n] < 0 || g->ph7[i][n] < 0 || g->ph13[i][n] < 0) {
+            g->ph1[i][cur] = g->ph1[i][prev] + eps * ((n > ndelayph1 ? r->curr_rates[RPSH1] * g->mh1[i][nph1]:0)-r->curr_rates[RPDH1]*g->ph1[i][prev]-2*r->curr_rates[RDAH1H1]*g->ph1[i][prev]*g->ph1[i][prev]+2*r->curr_rates[RDDIH1H1]*g->ph11[i][prev]-r->curr_rates[RDAH1H7]*g->ph1[i][prev]*g->ph7[i][prev]+r->curr_rates[RDDIH1H7]*g->ph17[i][prev]-r->curr_rates[RDAH1H13]*g->ph1[i][prev]*g->ph13[i][prev]+r->curr_rates[RDDIH1H13]*g->ph113[i][prev]);
+            g->ph7[i][cur] = g->ph7[i][prev] + eps * ((n > ndelayph7 ? r->curr_rates[RPSH7]*g->mh7[i][nph7]:0)-r->curr_rates[RPDH7]*g->ph7[i][prev]-2*r->curr_rates[RDAH7H7]*g->ph7[i][prev]*g->ph7[i][prev]+2*r->curr_rates[RDDIH7H7]*g->ph77[i][prev]-r->curr_rates[RDAH1H7]*g->ph1[i][prev]*g->ph7[i][prev]+r->curr_rates[RDDIH1H7]*g->ph17[i][prev]-r->curr_rates[RDAH7H13]*g->ph7[i][prev]*g->ph13[i][prev]+r->curr_rates[RDDIH7H13]*g->ph713[i][prev]);
+            g->ph13[i][cur] = g->ph13[i][prev] + eps * ((n > ndelayph13 ? r->curr_rates[RPSH13]*g->mh13[i][nph13]:0)-r->curr_rates[RPDH13]*g->ph13[i][prev]-2*r->curr_rates[RDAH13H13]*g->ph13[i][prev]*g->ph13[i][prev]+2*r->curr_rates[RDDIH13H13]*g->ph1313[i][prev]-r->curr_rates[RDAH1H13]*g->ph1[i][prev]*g->ph13[i][prev]+r->curr_rates[RDDIH1H13]*g->ph113[i][prev]-r->curr_rates[RDAH7H13]*g->ph7[i][prev]*g->ph13[i][prev]+r->curr_rates[RDDIH7H13]*g->ph713[i][prev]);
+            if (g->ph1[i][cur] < 0 || g->ph7[i][cur] < 0 || g->ph13[i][cur] < 0) {
                 return false;
             }
 
             //Dimer proteins
-            g->ph11[i][n] = g->ph11[i][n - 1] + eps * (r->curr_rates[RDAH1H1]*g->ph1[i][n - 1]*g->ph1[i][n - 1]-r->curr_rates[RDDIH1H1]*g->ph11[i][n - 1]-r->curr_rates[RDDGH1H1]*g->ph11[i][n - 1]);
-            g->ph17[i][n] = g->ph17[i][n - 1] + eps * (r->curr_rates[RDAH1H7]*g->ph1[i][n - 1]*g->ph7[i][n - 1]-r->curr_rates[RDDIH1H7]*g->ph17[i][n - 1]-r->curr_rates[RDDGH1H7]*g->ph17[i][n - 1]);
-            g->ph113[i][n] = g->ph113[i][n - 1] + eps * (r->curr_rates[RDAH1H13]*g->ph1[i][n - 1]*g->ph13[i][n - 1]-r->curr_rates[RDDIH1H13]*g->ph113[i][n - 1]-r->curr_rates[RDDGH1H13]*g->ph113[i][n - 1]);
-            g->ph77[i][n] = g->ph77[i][n - 1] + eps * (r->curr_rates[RDAH7H7]*g->ph7[i][n - 1]*g->ph7[i][n - 1]-r->curr_rates[RDDIH7H7]*g->ph77[i][n - 1]-r->curr_rates[RDDGH7H7]*g->ph77[i][n - 1]);
-            g->ph713[i][n] = g->ph713[i][n - 1] + eps * (r->curr_rates[RDAH7H13]*g->ph7[i][n - 1]*g->ph13[i][n - 1]-r->curr_rates[RDDIH7H13]*g->ph713[i][n - 1]-r->curr_rates[RDDGH7H13]*g->ph713[i][n - 1]);
-            g->ph1313[i][n] = g->ph1313[i][n - 1] + eps * (r->curr_rates[RDAH13H13]*g->ph13[i][n - 1]*g->ph13[i][n - 1]-r->curr_rates[RDDIH13H13]*g->ph1313[i][n - 1]-r->curr_rates[RDDGH13H13]*g->ph1313[i][n - 1]);
+            g->ph11[i][cur] = g->ph11[i][prev] + eps * (r->curr_rates[RDAH1H1]*g->ph1[i][prev]*g->ph1[i][prev]-r->curr_rates[RDDIH1H1]*g->ph11[i][prev]-r->curr_rates[RDDGH1H1]*g->ph11[i][prev]);
+            g->ph17[i][cur] = g->ph17[i][prev] + eps * (r->curr_rates[RDAH1H7]*g->ph1[i][prev]*g->ph7[i][prev]-r->curr_rates[RDDIH1H7]*g->ph17[i][prev]-r->curr_rates[RDDGH1H7]*g->ph17[i][prev]);
+            g->ph113[i][cur] = g->ph113[i][prev] + eps * (r->curr_rates[RDAH1H13]*g->ph1[i][prev]*g->ph13[i][prev]-r->curr_rates[RDDIH1H13]*g->ph113[i][prev]-r->curr_rates[RDDGH1H13]*g->ph113[i][prev]);
+            g->ph77[i][cur] = g->ph77[i][prev] + eps * (r->curr_rates[RDAH7H7]*g->ph7[i][prev]*g->ph7[i][prev]-r->curr_rates[RDDIH7H7]*g->ph77[i][prev]-r->curr_rates[RDDGH7H7]*g->ph77[i][prev]);
+            g->ph713[i][cur] = g->ph713[i][prev] + eps * (r->curr_rates[RDAH7H13]*g->ph7[i][prev]*g->ph13[i][prev]-r->curr_rates[RDDIH7H13]*g->ph713[i][prev]-r->curr_rates[RDDGH7H13]*g->ph713[i][prev]);
+            g->ph1313[i][cur] = g->ph1313[i][prev] + eps * (r->curr_rates[RDAH13H13]*g->ph13[i][prev]*g->ph13[i][prev]-r->curr_rates[RDDIH13H13]*g->ph1313[i][prev]-r->curr_rates[RDDGH13H13]*g->ph1313[i][prev]);
                         
             // Delta Protein
-            g->pd[i][n] = g->pd[i][n - 1] + eps*((n > npd ? r->curr_rates[RPSDELTA]*g->md[i][n-npd]:0)-r->curr_rates[RPDDELTA]*g->pd[i][n - 1]);
+            g->pd[i][cur] = g->pd[i][prev] + eps*((n > ndelaypd ? r->curr_rates[RPSDELTA]*g->md[i][npd]:0)-r->curr_rates[RPDDELTA]*g->pd[i][prev]);
             
-            if (g->ph11[i][n] < 0 || g->ph17[i][n] < 0 || g->ph113[i][n] < 0 || g->ph77[i][n] < 0 || g->ph713[i][n] < 0 || g->ph1313[i][n] < 0 || g->pd[i][n] < 0) {
+            if (g->ph11[i][cur] < 0 || g->ph17[i][cur] < 0 || g->ph113[i][cur] < 0 || g->ph77[i][cur] < 0 || g->ph713[i][cur] < 0 || g->ph1313[i][cur] < 0 || g->pd[i][cur] < 0) {
                 return false;
             }
             
-            /*
-             Compute the value of the delta protein coming from the neighbors for each cell. In two-cell systems, both cells are neighbors of each other. Chains wrap horizontally and hexagonal
-             tissue grids wrap horizontally and vertically like a honeycomb.
-             Two-cell systems look like this:
-             ___  ___
-             /   \/   \             where 1 and 2 are neighbors of each other
-             | 1 || 2 |
-             \___/\___/
-             
-             Chains of cells look like this:
-             ___  ___  ___  ___
-             /   \/   \/   \/   \   where x has neighbors n
-             | n || x || n ||   |
-             \___/\___/\___/\___/
-             
-             Tissues of cells look like this:
-              ___  ___  ___  ___
-             /   \/   \/   \/   \   where x has neighbors n
-             |   || n || n ||   |
-             \___/\___/\___/\___/_
-             /   \/   \/   \/   \
-             | n || x || n ||   |
-             \___/\___/\___/\___/
-             /   \/   \/   \/   \
-             |   || n || n ||   |
-             \___/\___/\___/\___/
-             /   \/   \/   \/   \
-             |   ||   ||   ||   |
-             \___/\___/\___/\___/
-             */
-            double avgpdh1 = 0, avgpdh7 = 0, avgpdd = 0;
-            if (rows == 1) {
-                if (columns == 2) {
-                    // If there are only two cells, the only delta input is coming from the other cell
-                    avgpdh1 = g->pd[1 - i][n - nmh1];
-                    avgpdh7 = g->pd[1 - i][n - nmh7];
-                    avgpdd = g->pd[1 - i][n - nmd];
-                } else {
-                    // If there is a chain of cells, the delta input is coming from the two cells to the left and right
-                    int left = fix(i - 1, columns), right = fix(i + 1, columns);
-                    avgpdh1 = (g->pd[left][n - nmh1] + g->pd[right][n - nmh1]) / 2;
-                    avgpdh7 = (g->pd[left][n - nmh7] + g->pd[right][n - nmh7]) / 2;
-                    avgpdd = (g->pd[left][n - nmd] + g->pd[right][n - nmd]) / 2;
-                }
-            } else {
-                int curi = i / columns, curj = i % columns, xx, yy;
-                int dx[] = {0, 0, -1, -1, 1, 1};
-                if (curi % 2 == 0) {
-                    int dy[] = {1, -1, -1, 0, -1, 0};
-                    for (int k = 0; k < 6; k++) {
-                        xx = curi + dx[k];
-                        xx = fix(xx, rows); // check for wrapping
-                        yy = curj + dy[k];
-                        yy = fix(yy, columns); // check for wrapping;
-                        int newi = xx * columns + yy;
-                    
-                        // add the delta of all neighbours
-                        if (n > nmh1) avgpdh1 += g -> pd[newi][n - nmh1];
-                        if (n > nmh7) avgpdh7 += g -> pd[newi][n - nmh7];
-                        if (n > nmd) avgpdd += g -> pd[newi][n - nmd];
-                    }
-                } else {
-                    int dy[] = {1, -1, 0, 1, 0, 1};
-                    for (int k = 0; k < 6; k++) {
-                        xx = curi + dx[k];
-                        xx = fix(xx, rows);
-                        yy = curj + dy[k];
-                        yy = fix(yy, columns);
-                        int newi = xx * columns + yy;
-                    
-                        // add the delta of all neighbours
-                        if (n > nmh1) avgpdh1 += g -> pd[newi][n - nmh1];
-                        if (n > nmh7) avgpdh7 += g -> pd[newi][n - nmh7];
-                        if (n > nmd) avgpdd += g -> pd[newi][n - nmd];
-                    }
-                }
-                avgpdh1 /= 6;
-                avgpdh7 /= 6;
-                avgpdd /= 6;
-            }
+            // The delta protein coming from the neighbors, averaged for every cell before the loop
+            double avgpdh1 = g->avgpdh1[i], avgpdh7 = g->avgpdh7[i], avgpdd = g->avgpdd[i];
             
             // mRNA Synthesis
-            g->mh1[i][n] = g->mh1[i][n - 1] + eps * ((n > nmh1 ? fh1(g->ph11[i][n - nmh1], g->ph713[i][n - nmh1], avgpdh1, r->curr_rates[RMSH1], r->curr_rates[RCRITPH1H1], r->curr_rates[RCRITPH7H13], r->curr_rates[RCRITPDELTA]):fh1(0, 0, 0, r->curr_rates[RMSH1], r->curr_rates[RCRITPH1H1], r->curr_rates[RCRITPH7H13], r->curr_rates[RCRITPDELTA]))-r->curr_rates[RMDH1]*g->mh1[i][n - 1]);
-            g->mh7[i][n] = g->mh7[i][n - 1] + eps * ((n > nmh7 ? fh7(g->ph11[i][n - nmh7], g->ph713[i][n - nmh7], avgpdh7, r->curr_rates[RMSH7], r->curr_rates[RCRITPH1H1], r->curr_rates[RCRITPH7H13], r->curr_rates[RCRITPDELTA]):fh7(0, 0, 0, r->curr_rates[RMSH7], r->curr_rates[RCRITPH1H1], r->curr_rates[RCRITPH7H13], r->curr_rates[RCRITPDELTA]))-r->curr_rates[RMDH7]*g->mh7[i][n - 1]);
-            g->mh13[i][n] = g->mh13[i][n - 1] + eps * (r->curr_rates[RMSH13]-r->curr_rates[RMDH13]*g->mh13[i][n - 1]); 
-            g->md[i][n] = g->md[i][n - 1] + eps * ((n > nmd ? fd(g->ph11[i][n - nmd], g->ph713[i][n - nmd], avgpdd, r->curr_rates[RMSDELTA], r->curr_rates[RCRITPH1H1], r->curr_rates[RCRITPH7H13], r->curr_rates[RCRITPDELTA]):fd(0, 0, 0, r->curr_rates[RMSDELTA], r->curr_rates[RCRITPH1H1], r->curr_rates[RCRITPH7H13], r->curr_rates[RCRITPDELTA]))-r->curr_rates[RMDDELTA]*g->md[i][n - 1]);
-            if (g->mh1[i][n] < 0 || g->mh7[i][n] < 0 || g-> mh13[i][n] < 0 || g-> md[i][n] < 0) {
+            g->mh1[i][cur] = g->mh1[i][prev] + eps * ((n > ndelaymh1 ? fh1(g->ph11[i][nmh1], g->ph713[i][nmh1], avgpdh1, r->curr_rates[RMSH1], r->curr_rates[RCRITPH1H1], r->curr_rates[RCRITPH7H13], r->curr_rates[RCRITPDELTA]):fh1(0, 0, 0, r->curr_rates[RMSH1], r->curr_rates[RCRITPH1H1], r->curr_rates[RCRITPH7H13], r->curr_rates[RCRITPDELTA]))-r->curr_rates[RMDH1]*g->mh1[i][prev]);
+            g->mh7[i][cur] = g->mh7[i][prev] + eps * ((n > ndelaymh7 ? fh7(g->ph11[i][nmh7], g->ph713[i][nmh7], avgpdh7, r->curr_rates[RMSH7], r->curr_rates[RCRITPH1H1], r->curr_rates[RCRITPH7H13], r->curr_rates[RCRITPDELTA]):fh7(0, 0, 0, r->curr_rates[RMSH7], r->curr_rates[RCRITPH1H1], r->curr_rates[RCRITPH7H13], r->curr_rates[RCRITPDELTA]))-r->curr_rates[RMDH7]*g->mh7[i][prev]);
+            g->mh13[i][cur] = g->mh13[i][prev] + eps * (r->curr_rates[RMSH13]-r->curr_rates[RMDH13]*g->mh13[i][prev]); 
+            g->md[i][cur] = g->md[i][prev] + eps * ((n > ndelaymd ? fd(g->ph11[i][nmd], g->ph713[i][nmd], avgpdd, r->curr_rates[RMSDELTA], r->curr_rates[RCRITPH1H1], r->curr_rates[RCRITPH7H13], r->curr_rates[RCRITPDELTA]):fd(0, 0, 0, r->curr_rates[RMSDELTA], r->curr_rates[RCRITPH1H1], r->curr_rates[RCRITPH7H13], r->curr_rates[RCRITPDELTA]))-r->curr_rates[RMDDELTA]*g->md[i][prev]);
+            if (i == 0 && g->record_step > 0 && n % g->record_step == 0) {
+                g->record[n / g->record_step] = g->mh1[0][cur];
+            }
+            if (g->mh1[i][cur] < 0 || g->mh7[i][cur] < 0 || g-> mh13[i][cur] < 0 || g-> md[i][cur] < 0) {
                 return false;
             }
-            if (max_prop != INFINITY && !checkPropensities(g, r, n, max_prop)) {
+            if (max_prop != INFINITY && !checkPropensities(g, r, cur, max_prop)) {
                 return false;
             }
         }
+        
+        // The previous step of the first cell's her1 mRNA now has a level on either side, so check whether it's a peak or trough
+        if (n >= 2) {
+            g->mh1_peaks.track(n - 1, nfinal, eps, g->mh1[0][(n - 2) & g->mask], g->mh1[0][prev], g->mh1[0][cur]);
+        }
     }
     return true;
 }
 
-bool run_mutant(glevels *g, int t_steps, double eps, rates *temp_rate, data &of, bool wild, double max_prop, int x, int y)
+bool run_mutant(glevels *g, int t_steps, double eps, rates *temp_rate, data &of, bool wild, double max_prop, int x, int y, double tolerance)
 {
     /*
      Performs the steps necessary in the simulation and analysis of the wild type or a certain mutant.
      1) Clear the levels from the previous simulation.
-     2) Run the model for the specified duration.
+     2) Run the model for the specified duration, with Euler's method or with the adaptive method if a tolerance was given.
      3) Create the oscillation features of the simulation.
      4) Return whether concentrations in the model where positive values below the propensity threshold
      */
-    clear_levels(g, t_steps, x * y);
-    bool pass = model(eps, t_steps, g, temp_rate, max_prop, x, y);
-    ofeatures(g, eps, t_steps, wild, of); 
+    clear_levels(g);
+    bool pass = tolerance > 0 ? model_adaptive(eps, t_steps, g, temp_rate, max_prop, x, y, tolerance) : model(eps, t_steps, g, temp_rate, max_prop, x, y);
+    ofeatures(&g->mh1_peaks, wild, of); 
     return pass;
 }
 
-void ofeatures(glevels *g, double eps, int nfinal, bool wild, data &d) {
+bool simulate_set(glevels *gene, rates *temp_rate, set_result *res, int t_steps, double eps, double max_prop, int x, int y, double tolerance, bool toPrint, string mutants[])
+{
+    /*
+     Simulates the wild type and every mutant of a parameter set, storing their oscillation features in res.
+     For the wild type and every mutant, perform the following steps:
+     1) Adjust the appropriate protein synthesis rates to create mutants if necessary
+     2) Run the simulation
+     3) Stop if the propensities for the set have gone above the set threshold
+     4) Otherwise, test oscillation features
+     5) Stop if the set did not produce oscillations or did not satisfy the mutant conditions
+     Returns whether the set passed every condition.
+     */
+    for (int m = 0; m < NUM_MUTANTS; m++) {
+        clear_data(res->features[m]);
+    }
+    
+    for (int m = 0; m < NUM_MUTANTS; m++) {
+        double original[2];
+        begin_mutant(temp_rate, m, original);
+        bool pass = run_mutant(gene, t_steps, eps, temp_rate, res->features[m], mutant_wild[m], max_prop, x, y, tolerance);
+        if (toPrint) {
+            printForPlotting(mutants[m] + "/run0.txt", gene, t_steps);
+        }
+        if (!pass || !mutant_passed(m, res->features)) {
+            return false;
+        }
+        end_mutant(temp_rate, m, original);
+    }
+    return true;
+}
+
+void begin_mutant(rates *r, int mutant, double original[])
+{
+    /*
+     Knocks out the protein synthesis of the given mutant's genes and resets the current rates to the new base rates.
+     The knocked out rates are stored in original (which must hold 2) so end_mutant can restore them.
+     */
+    if (mutant == MUTANT_DELTA) {
+        original[0] = r->rates_base[RPSDELTA];
+        r->rates_base[RPSDELTA] = 0.0;
+    } else if (mutant == MUTANT_HER13) {
+        original[0] = r->rates_base[RPSH13];
+        r->rates_base[RPSH13] = 0.0;
+    } else if (mutant == MUTANT_HER1) {
+        original[0] = r->rates_base[RPSH1];
+        r->rates_base[RPSH1] = 0.0;
+    } else if (mutant == MUTANT_HER7) {
+        original[0] = r->rates_base[RPSH7];
+        r->rates_base[RPSH7] = 0.0;
+    } else if (mutant == MUTANT_HER713) {
+        original[0] = r->rates_base[RPSH7], original[1] = r->rates_base[RPSH13];
+        r->rates_base[RPSH7] = 0.0, r->rates_base[RPSH13] = 0.0;
+    }
+    reset_rate(r);
+}
+
+void end_mutant(rates *r, int mutant, double original[])
+{
+    /*
+     Restores the rates begin_mutant knocked out.
+     */
+    if (mutant == MUTANT_DELTA) {
+        r->rates_base[RPSDELTA] = original[0];
+    } else if (mutant == MUTANT_HER13) {
+        r->rates_base[RPSH13] = original[0];
+    } else if (mutant == MUTANT_HER1) {
+        r->rates_base[RPSH1] = original[0];
+    } else if (mutant == MUTANT_HER7) {
+        r->rates_base[RPSH7] = original[0];
+    } else if (mutant == MUTANT_HER713) {
+        r->rates_base[RPSH7] = original[0], r->rates_base[RPSH13] = original[1];
+    }
+}
+
+bool mutant_passed(int mutant, data features[])
+{
+    /*
+     Tests whether the oscillation features of the given mutant satisfy its conditions, comparing its period to the wild type's.
+     */
+    data &d = features[mutant];
+    double wperiod = features[MUTANT_WT].period;
+    switch (mutant) {
+        case MUTANT_WT: return fwildtype(d.peaktotrough1, d.peaktotrough2);
+        case MUTANT_DELTA: return fd_mutant(d.period, d.amplitude, wperiod);
+        case MUTANT_HER13: return f13_mutant(d.period, d.amplitude, wperiod);
+        case MUTANT_HER1: return f1_mutant(d.period, d.amplitude, wperiod);
+        case MUTANT_HER7: return f7_mutant(d.period, d.amplitude, wperiod);
+        case MUTANT_HER713: return f713_mutant(d.period, d.amplitude, wperiod);
+    }
+    return false;
+}
+
+void ofeatures(peaks *p, bool wild, data &d) {
     /*
      Calculates the oscillation features -- period, amplitude and peak to trough
      ratio for a set of concentration levels.
@@ -597,59 +702,34 @@ void ofeatures(glevels *g, double eps, int nfinal, bool wild, data &d) {
      since the amplitude of the first few oscillations can be slightly unstable.
      For the wild type, the peak and trough at the middle of the graph are also calculated
      in order to ensure that the oscillations are sustained.
+     The peaks and troughs themselves are found by model() as it runs (see peaks::track).
      */
-    double tmaxlast = 0, tmaxpenult = 0, mmaxlast = 0, mmaxpenult = 0;
-    double tminlast = 0, tminpenult = 0, mminlast = 0, mminpenult = 0;
-        
-    for (int n = 1; n < nfinal - 1; n++) {
-        // check if the current point is a peak
-        if (g -> mh1[0][n + 1] < g -> mh1[0][n] && g -> mh1[0][n] > g -> mh1[0][n - 1]) {
-            tmaxpenult = tmaxlast;
-            tmaxlast = n*eps;
-            mmaxpenult = mmaxlast;
-            mmaxlast = g -> mh1[0][n];
-        }
-        
-        // check if the current point is a trough
-        if (g -> mh1[0][n + 1] > g -> mh1[0][n] && g -> mh1[0][n] < g -> mh1[0][n - 1]){
-            tminpenult = tminlast;
-            tminlast = n * eps;
-            mminpenult = mminlast;
-            mminlast = g -> mh1[0][n];
-        }
-    }
-    
+    double mminlast = p->mminlast;
     if (wild) {
-        // calculate the peak and trough at the middle of the graph
-        double mmaxlast2 = 0.0, mminlast2 = 0.0;
-        for(int m = 2; m < nfinal/2; m++){
-            if(g -> mh1[0][m + 1] < g -> mh1[0][m] && g -> mh1[0][m] > g -> mh1[0][m - 1]){
-                mmaxlast2 = g -> mh1[0][m];
-            }
-            if(g -> mh1[0][m + 1] > g -> mh1[0][m] && g -> mh1[0][m] < g -> mh1[0][m - 1]){
-                mminlast2 = g -> mh1[0][m];
-            }
-        }
+        double mminlast2 = p->mminmid;
         
         // in order to avoid dividing by zero in case a trough is 0, set it to 1
         if(mminlast2 == 0.0 || mminlast == 0.0) {
             mminlast2 = 1.0;
             mminlast = 1.0;
         }
-        d.peaktotrough2 = mmaxlast2/mminlast2;        
+        d.peaktotrough2 = p->mmaxmid/mminlast2;        
     }
-    d.period = tmaxlast-tmaxpenult;
-    d.amplitude = mmaxlast-mminlast;
-    d.peaktotrough1 = mmaxlast/mminlast;
+    d.period = p->tmaxlast-p->tmaxpenult;
+    d.amplitude = p->mmaxlast-mminlast;
+    d.peaktotrough1 = p->mmaxlast/mminlast;
 }
 
-glevels::glevels (int nfinal, int cells) {
+glevels::glevels (int nfinal, int columns, int rows, int record_step) {
     /*
      Constructor for the structure in which the concentration levels will be stored.
-     Each array has two elements because the simulation will be run for two cells.
+     The ring buffers are allocated by reserve once the delays are known, but the neighbors of every cell are found here.
      */
+    int cells = columns * rows;
     this->nfinal = nfinal;
     this->cells = cells;
+    this->size = 0;
+    this->mask = -1;
     
     mh1 = new double*[cells];
     mh7 = new double*[cells];
@@ -667,23 +747,83 @@ glevels::glevels (int nfinal, int cells) {
     ph1313 = new double*[cells];
     
     for (int i = 0; i < cells; i++) {
-        mh1[i] = new double[nfinal];
-        mh7[i] = new double[nfinal];
-        mh13[i] = new double[nfinal];
-        md[i] = new double[nfinal];
-        ph1[i] = new double[nfinal];
-        ph7[i] = new double[nfinal];
-        ph13[i] = new double[nfinal];
-        pd[i] = new double[nfinal];
-        ph11[i] = new double[nfinal];
-        ph17[i] = new double[nfinal];
-        ph113[i] = new double[nfinal];
-        ph77[i] = new double[nfinal];
-        ph713[i] = new double[nfinal];
-        ph1313[i] = new double[nfinal];
+        mh1[i] = NULL;
+        mh7[i] = NULL;
+        mh13[i] = NULL;
+        md[i] = NULL;
+        ph1[i] = NULL;
+        ph7[i] = NULL;
+        ph13[i] = NULL;
+        pd[i] = NULL;
+        ph11[i] = NULL;
+        ph17[i] = NULL;
+        ph113[i] = NULL;
+        ph77[i] = NULL;
+        ph713[i] = NULL;
+        ph1313[i] = NULL;
+    }
+    
+    nc = new int[cells][MAX_NEIGHBORS];
+    neighbors = cells_neighbors(columns, rows, nc);
+    delayed = new double[cells]();
+    avgpdh1 = new double[cells]();
+    avgpdh7 = new double[cells]();
+    avgpdd = new double[cells]();
+    
+    this->record_step = record_step;
+    this->record = record_step > 0 ? new double[nfinal / record_step + 1] : NULL;
+}
+
+void glevels::reserve (int delay) {
+    /*
+     Makes every ring buffer hold at least delay + 1 steps, so the step delay steps back is still there when the current one is computed.
+     At least 4 steps are kept for finding peaks.
+     */
+    int needed = 4;
+    while (needed < delay + 1) {
+        needed *= 2;
+    }
+    if (needed <= this->size) {
+        return;
+    }
+    this->size = needed;
+    this->mask = needed - 1;
+    double** levels[] = {mh1, mh7, mh13, md, ph1, ph7, ph13, pd, ph11, ph17, ph113, ph77, ph713, ph1313};
+    for (int s = 0; s < 14; s++) {
+        for (int i = 0; i < this->cells; i++) {
+            delete[] levels[s][i];
+            levels[s][i] = new double[needed];
+        }
     }
 }
 
+void glevels::clear_step (int n) {
+    /*
+     Clears step n's slot in every ring buffer, so levels read before they're computed in this step are 0 like at the start of a simulation.
+     */
+    int slot = n & this->mask;
+    for (int i = 0; i < this->cells; i++) {
+        mh1[i][slot] = 0, ph1[i][slot] = 0;
+        mh7[i][slot] = 0, ph7[i][slot] = 0;
+        mh13[i][slot] = 0, ph13[i][slot] = 0;
+        md[i][slot] = 0, pd[i][slot] = 0;
+        ph11[i][slot] = 0, ph17[i][slot] = 0;
+        ph113[i][slot] = 0, ph77[i][slot] = 0;
+        ph713[i][slot] = 0, ph1313[i][slot] = 0;
+    }
+}
+
+void glevels::average_delta (int slot, double *avg) {
+    /*
+     Averages the delta protein at the given ring buffer slot over every cell's neighbors.
+     Every cell's level is gathered into one array first, so the neighbors are looked up in it instead of in a ring buffer each.
+     */
+    for (int i = 0; i < this->cells; i++) {
+        delayed[i] = pd[i][slot];
+    }
+    average_neighbors(delayed, avg, this->cells, this->neighbors, this->nc);
+}
+
 glevels::~glevels () {
     /*
      Destructor for the structure containing the concentration levels.
@@ -719,6 +859,47 @@ glevels::~glevels () {
     delete[] ph77;
     delete[] ph713;
     delete[] ph1313;
+    delete[] nc;
+    delete[] delayed;
+    delete[] avgpdh1;
+    delete[] avgpdh7;
+    delete[] avgpdd;
+    delete[] record;
 }
 
+void peaks::clear () {
+    /*
+     Forgets the peaks and troughs of a previous simulation.
+     */
+    tmaxlast = 0, tmaxpenult = 0, mmaxlast = 0, mmaxpenult = 0;
+    tminlast = 0, tminpenult = 0, mminlast = 0, mminpenult = 0;
+    mmaxmid = 0, mminmid = 0;
+}
 
+void peaks::track (int n, int nfinal, double eps, double before, double level, double after) {
+    /*
+     Checks whether step n of a simulation of nfinal steps is a peak or a trough, given the levels of steps n - 1, n and n + 1.
+     The last two peaks and troughs are kept for every simulation, and the last ones before half of the simulation for the wild type.
+     */
+    // check if the current point is a peak
+    if (after < level && level > before) {
+        tmaxpenult = tmaxlast;
+        tmaxlast = n*eps;
+        mmaxpenult = mmaxlast;
+        mmaxlast = level;
+        if (n >= 2 && n < nfinal/2) {
+            mmaxmid = level;
+        }
+    }
+    
+    // check if the current point is a trough
+    if (after > level && level < before) {
+        tminpenult = tminlast;
+        tminlast = n * eps;
+        mminpenult = mminlast;
+        mminlast = level;
+        if (n >= 2 && n < nfinal/2) {
+            mminmid = level;
+        }
+    }
+}
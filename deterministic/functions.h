@@ -36,14 +36,29 @@ using namespace std;
 #define terminal_done terminal_blue << "Done" << terminal_reset
 #define terminal_no_memory terminal_red << "Not enough memory!" << terminal_reset
 
+struct peaks {
+    /*
+     Structure for finding the peaks and troughs of a concentration as it is simulated.
+     */
+    double tmaxlast, tmaxpenult, mmaxlast, mmaxpenult; // times and levels of the last two peaks
+    double tminlast, tminpenult, mminlast, mminpenult; // times and levels of the last two troughs
+    double mmaxmid, mminmid; // levels of the last peak and trough in the first half of the simulation
+
+    void clear();
+    void track(int, int, double, double, double, double);
+};
 
 struct glevels {
     /*
      Structure for storing concentration levels.
+     The simulation never looks further back than its longest delay, so only the most recent steps are kept:
+     each protein and mRNA has a ring buffer per cell, and step n is stored at index n & mask.
+     The oscillation features are found as the steps are computed, and the first cell's her1 mRNA is recorded every record_step steps for printing.
      */
     int nfinal, cells;
- 
-    // matrices which will contain concentration levels for each protein and mRNA
+    int size, mask; // the number of steps kept (a power of two) and size - 1
+
+    // ring buffers which will contain the recent concentration levels for each protein and mRNA
     double** mh1;
     double** mh7;
     double** mh13;
@@ -58,9 +73,24 @@ struct glevels {
     double** ph77;
     double** ph713;
     double** ph1313;
-    
-    glevels(int, int);
+
+    peaks mh1_peaks; // peaks and troughs of the first cell's her1 mRNA
+
+    int neighbors; // the number of neighbors of every cell
+    int (*nc)[MAX_NEIGHBORS]; // the neighbors of every cell, found once for the shape of the tissue (see cells_neighbors)
+    double* delayed; // every cell's delta protein at a delayed step, gathered in one array before averaging it over the neighbors
+    double* avgpdh1; // the average delta protein of every cell's neighbors at the her1 mRNA delay of the current step
+    double* avgpdh7; // the same at the her7 mRNA delay
+    double* avgpdd; // the same at the delta mRNA delay
+
+    int record_step; // the number of steps between recorded levels, 0 if nothing is recorded
+    double* record; // the first cell's her1 mRNA at every record_step steps
+
+    glevels(int, int, int, int);
     ~glevels();
+    void reserve(int);
+    void clear_step(int);
+    void average_delta(int, double*);
 };
 
 struct rates {
@@ -104,24 +134,41 @@ struct data{
     bool w;
 };
 
+struct set_result {
+    /*
+     Structure for storing the outcome of a parameter set until it is its turn to be printed.
+     */
+    data features[NUM_MUTANTS]; // the oscillation features of each mutant (see macros.h)
+    bool passed, done;
+};
+
 bool not_EOL (char c);
 bool checkPropensities(glevels*, rates*, int, double);
-void printForPlotting(string, glevels*, int, double);
+void printForPlotting(string, glevels*, int);
 void test_print(rates);
 void store_values(char*, char*, int&, rates**, const int, int, char*);
-void clear_levels(glevels*, int, int);
+void clear_levels(glevels*);
 bool model(double, int, glevels*, rates*, double);
-void ofeatures(glevels*, double, int, bool, data&);
+void ofeatures(peaks*, bool, data&);
 void parseLine(char*, int[], int&);
 void skipFirstLine(char*, int&);
 void usage(const char*);
 void licensing();
-bool run_mutant(glevels*, int, double, rates*, data&, bool, double, int, int);
+bool run_mutant(glevels*, int, double, rates*, data&, bool, double, int, int, double);
+bool simulate_set(glevels*, rates*, set_result*, int, double, double, int, int, double, bool, string[]);
+void begin_mutant(rates*, int, double[]);
+void end_mutant(rates*, int, double[]);
+bool mutant_passed(int, data[]);
 void fill_rates(rates *rs, char *buffer, int *index);
 void fill_gradients (rates *rs, char* gradients);
 void print_rate(rates *rs);
-void update_rate(rates& rs, int step);
+void update_rate(rates *rs, int step);
 void reset_rate(rates *rs);
+int fix(int x, int end);
+int cells_neighbors(int, int, int[][MAX_NEIGHBORS]);
+
+// whether the oscillation features of each mutant are checked for sustained oscillations
+const bool mutant_wild[NUM_MUTANTS] = {true, false, false, false, true, true};
 
 inline void clear_data(data &d){
     d.period = 0.0;
@@ -131,6 +178,18 @@ inline void clear_data(data &d){
     d.w = false;
 }
 
+inline void average_neighbors(const double *levels, double *avg, int cells, int neighbors, const int nc[][MAX_NEIGHBORS])
+{
+    // the average of the given levels over every cell's neighbors, adding them in the order of the neighbor table
+    for (int i = 0; i < cells; i++) {
+        double sum = 0;
+        for (int k = 0; k < neighbors; k++) {
+            sum += levels[nc[i][k]];
+        }
+        avg[i] = sum / neighbors;
+    }
+}
+
 /*
  Inline functions for computing mRNA transcription rates
  */
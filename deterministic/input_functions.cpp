@@ -118,7 +118,7 @@ void store_filename (char** field, const char* value) {
     strcpy(*field, value);
 }
 
-void checkArgs(int argc, char** argv, char** input_file, char** output_path, char** gradients_file, char** ofeat_file, bool& ofeat, int& pars, int& seed, int& minutes, double& eps, double& max_prop, bool& toPrint, int &x, int &y) {
+void checkArgs(int argc, char** argv, char** input_file, char** output_path, char** gradients_file, char** ofeat_file, bool& ofeat, int& pars, int& seed, int& minutes, double& eps, double& max_prop, bool& toPrint, int &x, int &y, int &threads, bool &vectorize, double &tolerance) {
     terminal_color();    
     
     /*
@@ -185,6 +185,19 @@ void checkArgs(int argc, char** argv, char** input_file, char** output_path, cha
                 if (y < 1) {
                     usage("The tissue heigiht must be at least one cell. Set -y or --height to at least 1.");
                 }
+            } else if (strcmp(option, "-n") == 0 || strcmp(option, "--threads") == 0) {
+                threads = atoi(value);
+                if (threads < 1) {
+                    usage("The parameter sets must be simulated on at least one thread. Set -n or --threads to at least 1.");
+                }
+            } else if (strcmp(option, "-t") == 0 || strcmp(option, "--tolerance") == 0) {
+                tolerance = atof(value);
+                if (tolerance <= 0) {
+                    usage("The error tolerance of the adaptive method must be a positive real number. Set -t or --tolerance to be greater than 0.");
+                }
+            } else if (strcmp(option, "-v") == 0 || strcmp(option, "--vectorize") == 0) {
+                vectorize = true;
+                i--;
             } else if (strcmp(option, "-w") == 0 || strcmp(option, "--write") == 0) {
                 toPrint = true;
                 i--;
@@ -211,6 +224,15 @@ void checkArgs(int argc, char** argv, char** input_file, char** output_path, cha
         if ((y == 1 && x < 2) || (y == 2 || y == 3) || (y > 3 && (x < 4 || y % 2 == 1 || x % 2 == 1))) {
             usage("Invalid simulation size. For two cell systems, x=2, y=1. For chains, x>=3, y=1. For tissues, x>=4 and even, y>=4 and even.");
         }
+        if (toPrint && threads > 1) {
+            usage("The concentrations of every parameter set are printed to the same files, so they can only be printed when simulating on one thread. Remove -w or --write, or set -n or --threads to 1.");
+        }
+        if (tolerance > 0 && vectorize) {
+            usage("The parameter sets simulated at once in vector registers use Euler's method. Remove -t or --tolerance, or -v or --vectorize.");
+        }
+        if (toPrint && vectorize) {
+            usage("The concentrations of every parameter set are printed to the same files, so they can only be printed when simulating one set at a time. Remove -w or --write, or -v or --vectorize.");
+        }
     }
 }
 
@@ -36,6 +36,6 @@ void readFile(char **buffer, char* input_file);
 void create_buffer (char **buffer, char *input_file);
 void terminal_color();
 void store_filename (char** field, const char* value);
-void checkArgs(int, char**, char**, char**, char**, char**, bool&, int&, int&, int&, double&, double&, bool&, int&, int&);
+void checkArgs(int, char**, char**, char**, char**, char**, bool&, int&, int&, int&, double&, double&, bool&, int&, int&, int&, bool&, double&);
 
 #endif
\ No newline at end of file
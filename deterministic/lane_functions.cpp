@@ -0,0 +1,321 @@
+/*
+ Deterministic simulator for the zebrafish segmentation clock.
+ Copyright (C) 2012 Ahmet Ay, Jack Holland, Adriana Sperlea
+ 
+ This program is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+ 
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+ 
+ You should have received a copy of the GNU General Public License
+ along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <iostream>
+#include <new>
+#include <cstdlib>
+#include <cstring>
+#include <math.h>
+
+#include "functions.h"
+#include "lane_functions.h"
+#include "macros.h"
+
+using namespace std;
+
+void load_rates(lane_t rate[], rates *r[])
+{
+    /*
+     Gathers the current rates of every lane into vectors.
+     */
+    for (int k = 0; k < NUM_RATES; k++) {
+        for (int l = 0; l < LANES; l++) {
+            rate[k][l] = r[l]->curr_rates[k];
+        }
+    }
+}
+
+lane_mask checkPropensities_lanes(llevels *x, lane_t rate[], int sn, double CUTOFF) {
+    /*
+     Checks the same propensity functions as checkPropensities in every lane.
+     sn is the index of the step to check in the ring buffers.
+     Returns the lanes in which any propensity is over CUTOFF.
+     */
+    lane_mask over = rate[RPSH1]       * x->mh1[0][sn] > CUTOFF;
+    over |= rate[RPDH1]       * x->ph1[0][sn] > CUTOFF;
+    over |= rate[RDAH1H1]     * x->ph1[0][sn] * (x->ph1[0][sn] - 1) / 2 > CUTOFF;
+    over |= rate[RDDIH1H1]    * x->ph11[0][sn] > CUTOFF;
+    over |= rate[RDAH1H7]     * x->ph1[0][sn] * x->ph7[0][sn] > CUTOFF;
+    over |= rate[RDDIH1H7]    * x->ph17[0][sn] > CUTOFF;
+    over |= rate[RDAH1H13]    * x->ph1[0][sn] * x->ph13[0][sn] > CUTOFF;
+    over |= rate[RDDIH1H13]   * x->ph113[0][sn] > CUTOFF;
+    over |= rate[RPSH7]       * x->mh7[0][sn] > CUTOFF;
+    over |= rate[RPDH7]       * x->ph7[0][sn] > CUTOFF;
+    over |= rate[RDAH7H7]     * x->ph7[0][sn] * (x->ph7[0][sn] - 1) / 2 > CUTOFF;
+    over |= rate[RDDIH7H7]    * x->ph77[0][sn] > CUTOFF;
+    over |= rate[RDAH7H13]    * x->ph7[0][sn]  * x->ph13[0][sn] > CUTOFF;
+    over |= rate[RDDIH7H13]   * x->ph713[0][sn] > CUTOFF;
+    over |= rate[RPSH13]      * x->mh13[0][sn] > CUTOFF;
+    over |= rate[RPDH13]      * x->ph13[0][sn] > CUTOFF;
+    over |= rate[RDAH13H13]   * x->ph13[0][sn] * (x->ph13[0][sn] - 1) / 2  > CUTOFF;
+    over |= rate[RDDIH13H13]  * x->ph1313[0][sn] > CUTOFF;
+    over |= rate[RDDGH1H1]    * x->ph11[0][sn] > CUTOFF;
+    over |= rate[RDDGH1H7]    * x->ph17[0][sn] > CUTOFF;
+    over |= rate[RDDGH1H13]   * x->ph113[0][sn] > CUTOFF;
+    over |= rate[RDDGH7H7]    * x->ph77[0][sn] > CUTOFF;
+    over |= rate[RDDGH7H13]   * x->ph713[0][sn] > CUTOFF;
+    over |= rate[RDDGH13H13]  * x->ph1313[0][sn] > CUTOFF;
+    over |= rate[RPSDELTA]    * x->md[0][sn] > CUTOFF;
+    over |= rate[RPDDELTA]    * x->pd[0][sn] > CUTOFF;
+    over |= fh1(x->ph11[0][sn], x->ph713[0][sn], x->pd[1][sn], rate[RMSH1], rate[RCRITPH1H1], rate[RCRITPH7H13], rate[RCRITPDELTA]) > CUTOFF;
+    over |= rate[RMDH1]       * x->mh1[0][sn] > CUTOFF;
+    over |= fh7(x->ph11[0][sn], x->ph713[0][sn], x->pd[1][sn], rate[RMSH7], rate[RCRITPH1H1], rate[RCRITPH7H13], rate[RCRITPDELTA]) > CUTOFF;
+    over |= rate[RMDH7]       * x->mh7[0][sn] > CUTOFF;
+    over |= rate[RPSH13] > CUTOFF;
+    over |= rate[RMDH13]      * x->mh13[0][sn] > CUTOFF;
+    over |= fd(x->ph11[0][sn], x->ph713[0][sn], x->pd[1][sn], rate[RMSDELTA], rate[RCRITPH1H1], rate[RCRITPH7H13], rate[RCRITPDELTA]) > CUTOFF;
+    over |= rate[RMDDELTA]    * x->md[0][sn] > CUTOFF;
+    return over;
+}
+
+lane_mask model_lanes(double eps, int nfinal, llevels *g, rates *r[], lane_mask active, double max_prop, int columns, int rows){
+    /*
+     Runs the deterministic simulation of the model in every lane at once, each lane with its own rates (see model() for the steps).
+     Inactive lanes are simulated too but ignored, so their rates should point to an active lane's.
+     A lane that fails keeps being simulated with the others but its levels and peaks are no longer used.
+     Returns the active lanes which failed, i.e. the lanes in which model() would have returned false.
+     */
+
+    // Convert the time delay values of every lane to integers, because the deterministic simulation uses discrete time points.
+    lane_mask ndelaymd, ndelayph1, ndelayph7, ndelayph13, ndelaypd, ndelaymh1, ndelaymh7;
+    int longest = 0;
+    for (int l = 0; l < LANES; l++) {
+        ndelayph1[l] = int(r[l]->curr_rates[RDELAYPH1]/eps);
+        ndelayph7[l] = int(r[l]->curr_rates[RDELAYPH7]/eps);
+        ndelayph13[l] = int(r[l]->curr_rates[RDELAYPH13]/eps);
+        ndelaypd[l] = int(r[l]->curr_rates[RDELAYPDELTA]/eps);
+        ndelaymd[l] = int(r[l]->curr_rates[RDELAYMDELTA]/eps);
+        ndelaymh1[l] = int(r[l]->curr_rates[RDELAYMH1]/eps);
+        ndelaymh7[l] = int(r[l]->curr_rates[RDELAYMH7]/eps);
+        long long delays[] = {ndelayph1[l], ndelayph7[l], ndelayph13[l], ndelaypd[l], ndelaymd[l], ndelaymh1[l], ndelaymh7[l]};
+        for (int k = 0; k < 7; k++) {
+            if (delays[k] > longest) longest = delays[k];
+        }
+    }
+
+    // Make the ring buffers long enough to reach back to the longest delay of any lane
+    g->reserve(longest);
+    g->clear_step(0);
+
+    // The ring buffer indices of every lane's delayed steps
+    lane_mask nmh1, nph1;
+    lane_mask nmh7, nph7;
+    lane_mask nph13;
+    lane_mask nmd, npd;
+
+    lane_t rate[NUM_RATES]; // the current rates of every lane
+    lane_t zero = {0};
+    lane_mask failed = {0};
+    int cells = rows * columns;
+    int last_step = 1; //last step when we recalculate the rates based on gradient factors
+    int step_size = nfinal/50; //the distance between 2 points we recalculate the rates
+    for (int l = 0; l < LANES; l++) {
+        update_rate(r[l], 0);
+    }
+    load_rates(rate, r);
+    for (int n = 1; n < nfinal; n++) {
+        if ((n-last_step) >= step_size){
+            for (int l = 0; l < LANES; l++) {
+                update_rate(r[l], last_step/step_size + 1);
+            }
+            load_rates(rate, r);
+            last_step = n;
+        }
+
+        // Find the ring buffer indices of the current step, the previous one and every lane's delayed ones
+        g->clear_step(n);
+        int cur = n & g->mask, prev = (n - 1) & g->mask;
+        long long mask = g->mask;
+        nmh1 = (n - ndelaymh1) & mask, nph1 = (n - ndelayph1) & mask;
+        nmh7 = (n - ndelaymh7) & mask, nph7 = (n - ndelayph7) & mask;
+        nph13 = (n - ndelayph13) & mask;
+        nmd = (n - ndelaymd) & mask, npd = (n - ndelaypd) & mask;
+
+        // The lanes whose delays have passed
+        lane_mask pastph1 = n > ndelayph1, pastph7 = n > ndelayph7, pastph13 = n > ndelayph13, pastpd = n > ndelaypd;
+        lane_mask pastmh1 = n > ndelaymh1, pastmh7 = n > ndelaymh7, pastmd = n > ndelaymd;
+
+        // Average the delayed delta protein of every cell's neighbors once per delay (see model())
+        if (any(pastmh1)) g->average_delta(nmh1, g->avgpdh1);
+        if (any(pastmh7)) g->average_delta(nmh7, g->avgpdh7);
+        if (any(pastmd)) g->average_delta(nmd, g->avgpdd);
+
+        for (int i = 0; i < cells; i++) {
+            // Load the previous step's levels once, since the compiler can't tell the ring buffers being written apart from them
+            lane_t mh1_prev = g->mh1[i][prev], mh7_prev = g->mh7[i][prev], mh13_prev = g->mh13[i][prev], md_prev = g->md[i][prev];
+            lane_t ph1_prev = g->ph1[i][prev], ph7_prev = g->ph7[i][prev], ph13_prev = g->ph13[i][prev], pd_prev = g->pd[i][prev];
+            lane_t ph11_prev = g->ph11[i][prev], ph17_prev = g->ph17[i][prev], ph113_prev = g->ph113[i][prev], ph77_prev = g->ph77[i][prev];
+            lane_t ph713_prev = g->ph713[i][prev], ph1313_prev = g->ph1313[i][prev];
+
+            //Protein synthesis
+            g->ph1[i][cur] = ph1_prev + eps * ((pastph1 ? rate[RPSH1] * gather(g->mh1[i], nph1):zero)-rate[RPDH1]*ph1_prev-2*rate[RDAH1H1]*ph1_prev*ph1_prev+2*rate[RDDIH1H1]*ph11_prev-rate[RDAH1H7]*ph1_prev*ph7_prev+rate[RDDIH1H7]*ph17_prev-rate[RDAH1H13]*ph1_prev*ph13_prev+rate[RDDIH1H13]*ph113_prev);
+            g->ph7[i][cur] = ph7_prev + eps * ((pastph7 ? rate[RPSH7]*gather(g->mh7[i], nph7):zero)-rate[RPDH7]*ph7_prev-2*rate[RDAH7H7]*ph7_prev*ph7_prev+2*rate[RDDIH7H7]*ph77_prev-rate[RDAH1H7]*ph1_prev*ph7_prev+rate[RDDIH1H7]*ph17_prev-rate[RDAH7H13]*ph7_prev*ph13_prev+rate[RDDIH7H13]*ph713_prev);
+            g->ph13[i][cur] = ph13_prev + eps * ((pastph13 ? rate[RPSH13]*gather(g->mh13[i], nph13):zero)-rate[RPDH13]*ph13_prev-2*rate[RDAH13H13]*ph13_prev*ph13_prev+2*rate[RDDIH13H13]*ph1313_prev-rate[RDAH1H13]*ph1_prev*ph13_prev+rate[RDDIH1H13]*ph113_prev-rate[RDAH7H13]*ph7_prev*ph13_prev+rate[RDDIH7H13]*ph713_prev);
+            failed |= (g->ph1[i][cur] < 0) | (g->ph7[i][cur] < 0) | (g->ph13[i][cur] < 0);
+
+            //Dimer proteins
+            g->ph11[i][cur] = ph11_prev + eps * (rate[RDAH1H1]*ph1_prev*ph1_prev-rate[RDDIH1H1]*ph11_prev-rate[RDDGH1H1]*ph11_prev);
+            g->ph17[i][cur] = ph17_prev + eps * (rate[RDAH1H7]*ph1_prev*ph7_prev-rate[RDDIH1H7]*ph17_prev-rate[RDDGH1H7]*ph17_prev);
+            g->ph113[i][cur] = ph113_prev + eps * (rate[RDAH1H13]*ph1_prev*ph13_prev-rate[RDDIH1H13]*ph113_prev-rate[RDDGH1H13]*ph113_prev);
+            g->ph77[i][cur] = ph77_prev + eps * (rate[RDAH7H7]*ph7_prev*ph7_prev-rate[RDDIH7H7]*ph77_prev-rate[RDDGH7H7]*ph77_prev);
+            g->ph713[i][cur] = ph713_prev + eps * (rate[RDAH7H13]*ph7_prev*ph13_prev-rate[RDDIH7H13]*ph713_prev-rate[RDDGH7H13]*ph713_prev);
+            g->ph1313[i][cur] = ph1313_prev + eps * (rate[RDAH13H13]*ph13_prev*ph13_prev-rate[RDDIH13H13]*ph1313_prev-rate[RDDGH13H13]*ph1313_prev);
+
+            // Delta Protein
+            g->pd[i][cur] = pd_prev + eps*((pastpd ? rate[RPSDELTA]*gather(g->md[i], npd):zero)-rate[RPDDELTA]*pd_prev);
+
+            failed |= (g->ph11[i][cur] < 0) | (g->ph17[i][cur] < 0) | (g->ph113[i][cur] < 0) | (g->ph77[i][cur] < 0) | (g->ph713[i][cur] < 0) | (g->ph1313[i][cur] < 0) | (g->pd[i][cur] < 0);
+
+            // The delta protein coming from the neighbors, averaged for every cell before the loop
+            lane_t avgpdh1 = g->avgpdh1[i], avgpdh7 = g->avgpdh7[i], avgpdd = g->avgpdd[i];
+
+            // mRNA Synthesis, choosing the inputs of every lane rather than the outputs so each transcription rate is only computed once
+            g->mh1[i][cur] = mh1_prev + eps * (fh1(pastmh1 ? gather(g->ph11[i], nmh1) : zero, pastmh1 ? gather(g->ph713[i], nmh1) : zero, pastmh1 ? avgpdh1 : zero, rate[RMSH1], rate[RCRITPH1H1], rate[RCRITPH7H13], rate[RCRITPDELTA])-rate[RMDH1]*mh1_prev);
+            g->mh7[i][cur] = mh7_prev + eps * (fh7(pastmh7 ? gather(g->ph11[i], nmh7) : zero, pastmh7 ? gather(g->ph713[i], nmh7) : zero, pastmh7 ? avgpdh7 : zero, rate[RMSH7], rate[RCRITPH1H1], rate[RCRITPH7H13], rate[RCRITPDELTA])-rate[RMDH7]*mh7_prev);
+            g->mh13[i][cur] = mh13_prev + eps * (rate[RMSH13]-rate[RMDH13]*mh13_prev);
+            g->md[i][cur] = md_prev + eps * (fd(pastmd ? gather(g->ph11[i], nmd) : zero, pastmd ? gather(g->ph713[i], nmd) : zero, pastmd ? avgpdd : zero, rate[RMSDELTA], rate[RCRITPH1H1], rate[RCRITPH7H13], rate[RCRITPDELTA])-rate[RMDDELTA]*md_prev);
+            failed |= (g->mh1[i][cur] < 0) | (g->mh7[i][cur] < 0) | (g->mh13[i][cur] < 0) | (g->md[i][cur] < 0);
+            if (max_prop != INFINITY) {
+                failed |= checkPropensities_lanes(g, rate, cur, max_prop);
+            }
+        }
+
+        // Check for peaks and troughs in the lanes that are still going, and stop once every lane has failed
+        lane_mask going = active & ~failed;
+        if (!any(going)) {
+            break;
+        }
+        if (n >= 2) {
+            lane_t before = g->mh1[0][(n - 2) & g->mask], level = g->mh1[0][prev], after = g->mh1[0][cur];
+            lane_mask turning = going & (((after < level) & (level > before)) | ((after > level) & (level < before)));
+            if (any(turning)) {
+                for (int l = 0; l < LANES; l++) {
+                    if (turning[l]) {
+                        g->mh1_peaks[l].track(n - 1, nfinal, eps, before[l], level[l], after[l]);
+                    }
+                }
+            }
+        }
+    }
+    return failed & active;
+}
+
+static lane_t* lane_alloc (int length) {
+    /*
+     Allocates an array of vectors aligned to the size of a vector, since new doesn't align beyond a double before C++17.
+     */
+    void* block;
+    if (posix_memalign(&block, sizeof(lane_t), length * sizeof(lane_t)) != 0) {
+        throw bad_alloc();
+    }
+    return (lane_t*)block;
+}
+
+llevels::llevels (int nfinal, int columns, int rows) {
+    /*
+     Constructor for the structure in which the concentration levels of every lane will be stored.
+     The ring buffers are allocated by reserve once the delays are known, but the neighbors of every cell are found here.
+     */
+    int cells = columns * rows;
+    this->nfinal = nfinal;
+    this->cells = cells;
+    this->size = 0;
+    this->mask = -1;
+
+    lane_t*** levels[] = {&mh1, &mh7, &mh13, &md, &ph1, &ph7, &ph13, &pd, &ph11, &ph17, &ph113, &ph77, &ph713, &ph1313};
+    for (int s = 0; s < 14; s++) {
+        *levels[s] = new lane_t*[cells];
+        for (int i = 0; i < cells; i++) {
+            (*levels[s])[i] = NULL;
+        }
+    }
+
+    nc = new int[cells][MAX_NEIGHBORS];
+    neighbors = cells_neighbors(columns, rows, nc);
+    delayed = lane_alloc(cells);
+    avgpdh1 = lane_alloc(cells);
+    avgpdh7 = lane_alloc(cells);
+    avgpdd = lane_alloc(cells);
+}
+
+void llevels::reserve (int delay) {
+    /*
+     Makes every ring buffer hold at least delay + 1 steps (see glevels::reserve).
+     */
+    int needed = 4;
+    while (needed < delay + 1) {
+        needed *= 2;
+    }
+    if (needed <= this->size) {
+        return;
+    }
+    this->size = needed;
+    this->mask = needed - 1;
+    lane_t** levels[] = {mh1, mh7, mh13, md, ph1, ph7, ph13, pd, ph11, ph17, ph113, ph77, ph713, ph1313};
+    for (int s = 0; s < 14; s++) {
+        for (int i = 0; i < this->cells; i++) {
+            free(levels[s][i]);
+            levels[s][i] = lane_alloc(needed);
+        }
+    }
+}
+
+void llevels::clear_step (int n) {
+    /*
+     Clears step n's slot in every ring buffer (see glevels::clear_step).
+     */
+    int slot = n & this->mask;
+    lane_t zero = {0};
+    for (int i = 0; i < this->cells; i++) {
+        mh1[i][slot] = zero, ph1[i][slot] = zero;
+        mh7[i][slot] = zero, ph7[i][slot] = zero;
+        mh13[i][slot] = zero, ph13[i][slot] = zero;
+        md[i][slot] = zero, pd[i][slot] = zero;
+        ph11[i][slot] = zero, ph17[i][slot] = zero;
+        ph113[i][slot] = zero, ph77[i][slot] = zero;
+        ph713[i][slot] = zero, ph1313[i][slot] = zero;
+    }
+}
+
+void llevels::average_delta (lane_mask slots, lane_t *avg) {
+    /*
+     Averages the delta protein at every lane's ring buffer slot over every cell's neighbors (see glevels::average_delta).
+     */
+    for (int i = 0; i < this->cells; i++) {
+        delayed[i] = gather(pd[i], slots);
+    }
+    average_neighbors(delayed, avg, this->cells, this->neighbors, this->nc);
+}
+
+llevels::~llevels () {
+    /*
+     Destructor for the structure containing the concentration levels of every lane.
+     */
+    lane_t** levels[] = {mh1, mh7, mh13, md, ph1, ph7, ph13, pd, ph11, ph17, ph113, ph77, ph713, ph1313};
+    for (int s = 0; s < 14; s++) {
+        for (int i = 0; i < this->cells; i++) {
+            free(levels[s][i]);
+        }
+        delete[] levels[s];
+    }
+    delete[] nc;
+    free(delayed);
+    free(avgpdh1);
+    free(avgpdh7);
+    free(avgpdd);
+}
@@ -0,0 +1,156 @@
+/*
+ Deterministic simulator for the zebrafish segmentation clock.
+ Copyright (C) 2012 Ahmet Ay, Jack Holland, Adriana Sperlea
+ 
+ This program is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+ 
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+ 
+ You should have received a copy of the GNU General Public License
+ along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ Every parameter set is simulated with the same equations, so several of them can be simulated at once in the lanes of vector registers:
+ each value of model() becomes a vector with one element per lane, and each lane has its own rates, delays and failure flag.
+ The lanes do exactly the same arithmetic as model() does for one set, so their concentration levels and oscillation features are identical to it.
+ */
+
+#include <immintrin.h>
+
+#include "functions.h"
+#include "macros.h"
+
+using namespace std;
+
+#ifndef LANE_H
+#define LANE_H
+
+// the number of parameter sets simulated at once, as many doubles as fit in the widest vector registers being compiled for (see ARCH in the makefile)
+#if defined(__AVX512F__)
+#define LANES 8
+#elif defined(__AVX__)
+#define LANES 4
+#else
+#define LANES 2
+#endif
+
+typedef double lane_t __attribute__((vector_size(LANES * sizeof(double)))); // a value for every lane
+typedef long long lane_mask __attribute__((vector_size(LANES * sizeof(long long)))); // a condition for every lane, -1 where it's true and 0 where it's false
+
+struct llevels {
+    /*
+     Structure for storing the concentration levels of every lane.
+     Like glevels, each protein and mRNA has a ring buffer per cell, but every step in it holds the level of every lane.
+     The ring buffers are long enough for the longest delay of any lane.
+     */
+    int nfinal, cells;
+    int size, mask; // the number of steps kept (a power of two) and size - 1
+
+    // ring buffers which will contain the recent concentration levels for each protein and mRNA
+    lane_t** mh1;
+    lane_t** mh7;
+    lane_t** mh13;
+    lane_t** md;
+    lane_t** ph1;
+    lane_t** ph7;
+    lane_t** ph13;
+    lane_t** pd;
+    lane_t** ph11;
+    lane_t** ph17;
+    lane_t** ph113;
+    lane_t** ph77;
+    lane_t** ph713;
+    lane_t** ph1313;
+
+    peaks mh1_peaks[LANES]; // peaks and troughs of the first cell's her1 mRNA in every lane
+
+    int neighbors; // the number of neighbors of every cell
+    int (*nc)[MAX_NEIGHBORS]; // the neighbors of every cell (see cells_neighbors)
+    lane_t* delayed; // every cell's delta protein at every lane's delayed step
+    lane_t* avgpdh1; // the average delta protein of every cell's neighbors at every lane's her1 mRNA delay
+    lane_t* avgpdh7; // the same at the her7 mRNA delay
+    lane_t* avgpdd; // the same at the delta mRNA delay
+
+    llevels(int, int, int);
+    ~llevels();
+    void reserve(int);
+    void clear_step(int);
+    void average_delta(lane_mask, lane_t*);
+};
+
+lane_mask model_lanes(double, int, llevels*, rates*[], lane_mask, double, int, int);
+lane_mask checkPropensities_lanes(llevels*, lane_t[], int, double);
+
+/*
+ Inline functions for computing mRNA transcription rates in every lane, with the same arithmetic as the ones in functions.h
+ */
+inline lane_t fh1(lane_t xh11, lane_t xh713, lane_t yd, lane_t msh1, lane_t critph1h1, lane_t critph7h13, lane_t critpd)
+{
+    // her1 mRNA
+    lane_t x11 = xh11 / critph1h1, x713 = xh713 / critph7h13, y = yd / critpd;
+    return msh1 * ((1 + y) / (1 + y + x11 * x11 + x713 * x713));
+}
+
+inline lane_t fh7(lane_t xh11, lane_t xh713, lane_t yd, lane_t msh7, lane_t critph1h1, lane_t critph7h13, lane_t critpd)
+{
+    // her7 mRNA
+    lane_t x11 = xh11 / critph1h1, x713 = xh713 / critph7h13, y = yd/critpd;
+    return msh7 * ((1+y) / (1 + y + x11 * x11 + x713 * x713));
+}
+
+inline lane_t fd(lane_t xh11, lane_t xh713, lane_t yd, lane_t msd, lane_t critph1h1, lane_t critph7h13, lane_t critpd)
+{
+    // delta mRNA
+    lane_t x11 = xh11 / critph1h1, x713 = xh713 / critph7h13;
+    return msd / (1 + x11 * x11 + x713 * x713);
+}
+
+inline void average_neighbors(const lane_t *levels, lane_t *avg, int cells, int neighbors, const int nc[][MAX_NEIGHBORS])
+{
+    // the average of the given levels of every lane over every cell's neighbors (see the version in functions.h)
+    lane_t zero = {0};
+    for (int i = 0; i < cells; i++) {
+        lane_t sum = zero;
+        for (int k = 0; k < neighbors; k++) {
+            sum += levels[nc[i][k]];
+        }
+        avg[i] = sum / neighbors;
+    }
+}
+
+inline bool any(lane_mask m)
+{
+    // whether a condition is true in any lane
+    long long x = 0;
+    for (int l = 0; l < LANES; l++) {
+        x |= m[l];
+    }
+    return x != 0;
+}
+
+inline lane_t gather(lane_t* ring, lane_mask slots)
+{
+    // the level of every lane at its own slot of a ring buffer, with a single gather instruction where there is one
+#if defined(__AVX512F__)
+    const lane_mask lanes = {0, 1, 2, 3, 4, 5, 6, 7};
+    return (lane_t)_mm512_mask_i64gather_pd(_mm512_setzero_pd(), 0xff, (__m512i)(slots * LANES + lanes), (const double*)ring, sizeof(double));
+#elif defined(__AVX2__)
+    const lane_mask lanes = {0, 1, 2, 3};
+    return (lane_t)_mm256_mask_i64gather_pd(_mm256_setzero_pd(), (const double*)ring, (__m256i)(slots * LANES + lanes), _mm256_castsi256_pd(_mm256_set1_epi64x(-1)), sizeof(double));
+#else
+    lane_t v;
+    for (int l = 0; l < LANES; l++) {
+        v[l] = ring[slots[l]][l];
+    }
+    return v;
+#endif
+}
+
+#endif
@@ -90,4 +90,34 @@
 #define MIN_DELAY		34 // The smallest index referring to a delay
 #define MAX_DELAY		41 // The largest index referring to a delay
 
+// Mutants, in the order they are simulated
+#define MUTANT_WT		0
+#define MUTANT_DELTA	1
+#define MUTANT_HER13	2
+#define MUTANT_HER1		3
+#define MUTANT_HER7		4
+#define MUTANT_HER713	5
+
+#define NUM_MUTANTS		6 // How big an array holding something for every mutant must be
+
+// Concentrations, in the order the adaptive solver stores them for every cell
+#define SPH1			0
+#define SPH7			1
+#define SPH13			2
+#define SPDELTA			3
+#define SPH11			4
+#define SPH17			5
+#define SPH113			6
+#define SPH77			7
+#define SPH713			8
+#define SPH1313			9
+#define SMH1			10
+#define SMH7			11
+#define SMH13			12
+#define SMDELTA			13
+
+#define NUM_SPECIES		14 // How big an array holding every concentration of a cell must be
+
+#define MAX_NEIGHBORS	6 // How big an array holding the neighbors of a cell must be, for hexagonal tissues
+
 #endif
\ No newline at end of file
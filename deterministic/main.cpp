@@ -19,7 +19,8 @@
 /*
  The program simulates the behavior of the zebrafish segmentation clock for two cells,
  through a matematical model using delay differential equations.
- To solve the equations, the program uses Euler's method, with an adjustable stepsize.
+ To solve the equations, the program uses Euler's method, with an adjustable stepsize,
+ or an adaptive Runge-Kutta method with an adjustable error tolerance.
  The program tries to find parameter sets which replicate the behavior of the system in wild type
  and several mutants.
  */
@@ -38,9 +39,14 @@
 #include <sys/stat.h>
 #include <sys/types.h>
 #include <unistd.h>
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <vector>
 
 #include "functions.h"
 #include "input_functions.h"
+#include "lane_functions.h"
 #include "output_functions.h"
 #include "macros.h"
 using namespace std;
@@ -51,6 +57,172 @@ extern char* terminal_blue;
 extern char* terminal_red;
 extern char* terminal_reset;
 
+struct set_pool {
+    /*
+     Structure shared by the threads simulating a chunk of parameter sets.
+     */
+    rates** rateValues; // the parameter sets of the chunk
+    set_result* results; // the outcome of each set of the chunk
+    int sets; // the number of sets in the chunk
+    int first; // the number of sets in the chunks before this one
+    int t_steps, print_step; // the number of time steps to simulate and to skip between printed concentrations
+    double eps, max_prop; // the time step and the propensities threshold
+    double tolerance; // the error tolerance of the adaptive method, 0 for Euler's method
+    int x, y; // the width and height of the tissue
+    bool toPrint, ofeat; // whether the concentrations and the oscillation features are printed
+    string* mutants; // the directories the concentrations of each mutant are printed in
+    ofstream* allpassed; // the file of the parameter sets that passed every condition
+    ofstream* oft; // the oscillation features file
+    atomic<int> next_set; // the next set to claim
+    int next_write; // the next set to print
+    mutex write_mutex; // guards next_write, the results' done flags, the terminal and the output files
+};
+
+void write_set(set_pool *pool, int i)
+{
+    /*
+     Prints a parameter set that passed every condition into the output file containing the parameters that passed, and its oscillation features into the features file.
+     */
+    data *f = pool->results[i].features;
+    rates *temp_rate = pool->rateValues[i];
+    cerr << terminal_blue << "Parameter set " << i << " passed." << terminal_reset << endl;
+    if (pool->ofeat) {
+        *pool->oft << i << "," << f[MUTANT_WT].period << "," << f[MUTANT_WT].amplitude << "," << f[MUTANT_WT].peaktotrough1 << ",";
+        *pool->oft << f[MUTANT_DELTA].period << "," << f[MUTANT_DELTA].amplitude << "," << f[MUTANT_DELTA].peaktotrough1 << ",";
+        *pool->oft << f[MUTANT_HER1].period << "," << f[MUTANT_HER1].amplitude << "," << f[MUTANT_HER1].peaktotrough1 << ",";
+        *pool->oft << f[MUTANT_HER7].period << "," << f[MUTANT_HER7].amplitude << "," << f[MUTANT_HER7].peaktotrough1 << ",";
+        *pool->oft << f[MUTANT_HER13].period << "," << f[MUTANT_HER13].amplitude << "," << f[MUTANT_HER13].peaktotrough1 << ",";
+        *pool->oft << f[MUTANT_HER713].period << "," << f[MUTANT_HER713].amplitude << "," << f[MUTANT_HER713].peaktotrough1 << ",";
+    }
+    *pool->allpassed<<temp_rate->rates_base[RPSH1]<<","<<temp_rate->rates_base[RPSH7]<<","<<temp_rate->rates_base[RPSH13]<<","<<temp_rate->rates_base[RPSDELTA]<<","<<temp_rate->rates_base[RPDH1]<<","<<temp_rate->rates_base[RPDH7]<<",";
+    *pool->allpassed<<temp_rate->rates_base[RPDH13]<<","<<temp_rate->rates_base[RPDDELTA]<<","<<temp_rate->rates_base[RMSH1]<<","<<temp_rate->rates_base[RMSH7]<<","<<temp_rate->rates_base[RMSH13]<<","<<temp_rate->rates_base[RMSDELTA]<<",";
+    *pool->allpassed<<temp_rate->rates_base[RMDH1]<<","<<temp_rate->rates_base[RMDH7]<<","<<temp_rate->rates_base[RMDH13]<<","<<temp_rate->rates_base[RMDDELTA]<<"," <<temp_rate->rates_base[RDDGH1H1] << "," << temp_rate->rates_base[RDDGH1H7] << ",";
+    *pool->allpassed<<temp_rate->rates_base[RDDGH1H13]<<","<<temp_rate->rates_base[RDDGH7H7]<<","<<temp_rate->rates_base[RDDGH7H13]<<","<<temp_rate->rates_base[RDDGH13H13]<<",";
+    *pool->allpassed<<temp_rate->rates_base[RDELAYMH1]<<","<<temp_rate->rates_base[RDELAYMH7]<<","<<temp_rate->rates_base[RDELAYMH13]<<","<<temp_rate->rates_base[RDELAYMDELTA]<<","<<temp_rate->rates_base[RDELAYPH1]<<",";
+    *pool->allpassed<<temp_rate->rates_base[RDELAYPH7]<<","<<temp_rate->rates_base[RDELAYPH13]<<","<<temp_rate->rates_base[RDELAYPDELTA]<<","<<temp_rate->rates_base[RDAH1H1]<<","<<temp_rate->rates_base[RDDIH1H1]<<","<<temp_rate->rates_base[RDAH1H7]<<",";
+    *pool->allpassed<<temp_rate->rates_base[RDDIH1H7]<<","<<temp_rate->rates_base[RDAH1H13]<<","<<temp_rate->rates_base[RDDIH1H13]<<","<<temp_rate->rates_base[RDAH7H7]<<","<<temp_rate->rates_base[RDDIH7H7]<<","<<temp_rate->rates_base[RDAH7H13]<<",";
+    *pool->allpassed<<temp_rate->rates_base[RDDIH7H13]<<","<<temp_rate->rates_base[RDAH13H13]<<","<<temp_rate->rates_base[RDDIH13H13]<<","<<temp_rate->rates_base[RCRITPH1H1] << "," << temp_rate->rates_base[RCRITPH7H13] <<","<<temp_rate->rates_base[RCRITPDELTA]<<endl;
+}
+
+int claim_set(set_pool *pool)
+{
+    /*
+     Claims the next set that hasn't been simulated yet, returning pool->sets if there are none left.
+     */
+    int i = pool->next_set++;
+    if (i >= pool->sets) {
+        return pool->sets;
+    }
+    pool->write_mutex.lock();
+    cerr << "Simulating set " << pool->first + i << endl;
+    pool->write_mutex.unlock();
+    return i;
+}
+
+void finish_set(set_pool *pool, int i, bool passed)
+{
+    /*
+     Stores whether a set passed and prints every finished set that is next in order,
+     so the output files list the sets in the order they were read no matter which thread finishes first.
+     */
+    pool->write_mutex.lock();
+    pool->results[i].passed = passed;
+    pool->results[i].done = true;
+    while (pool->next_write < pool->sets && pool->results[pool->next_write].done) {
+        if (pool->results[pool->next_write].passed) {
+            write_set(pool, pool->next_write);
+        }
+        pool->next_write++;
+    }
+    pool->write_mutex.unlock();
+}
+
+void simulate_sets(set_pool *pool)
+{
+    /*
+     The loop of each thread simulating a chunk of parameter sets:
+     1) Claim the next set that hasn't been simulated yet, until there are none left
+     2) Simulate it using this thread's own levels structure
+     3) Print it and every other finished set that is next in order
+     */
+    glevels gene(pool->t_steps, pool->x, pool->y, pool->toPrint ? pool->print_step : 0); // Create the structure that contains the ring buffers which hold the gene levels
+    for (int i = claim_set(pool); i < pool->sets; i = claim_set(pool)) {
+        set_result *res = &pool->results[i];
+        finish_set(pool, i, simulate_set(&gene, pool->rateValues[i], res, pool->t_steps, pool->eps, pool->max_prop, pool->x, pool->y, pool->tolerance, pool->toPrint, pool->mutants));
+    }
+}
+
+void simulate_sets_lanes(set_pool *pool)
+{
+    /*
+     The loop of each thread simulating a chunk of parameter sets LANES at a time (see lane_functions.h):
+     1) Give every idle lane the next set that hasn't been simulated yet, starting with its wild type
+     2) Simulate the current mutant of every lane at once
+     3) Move every lane whose mutant passed on to its set's next mutant like simulate_set does,
+        and finish the sets which failed or passed every mutant, freeing their lanes
+     4) Stop once every lane is idle and there are no sets left
+     */
+    llevels gene(pool->t_steps, pool->x, pool->y); // Create the structure that contains the ring buffers which hold the gene levels of every lane
+    int set[LANES]; // the set simulated in each lane, pool->sets if the lane is idle
+    int mutant[LANES]; // the mutant of its set each lane simulates
+    double original[LANES][2]; // the rates knocked out by each lane's mutant
+    for (int l = 0; l < LANES; l++) {
+        set[l] = pool->sets;
+    }
+    
+    while (true) {
+        lane_mask active;
+        int first_active = -1;
+        for (int l = 0; l < LANES; l++) {
+            if (set[l] == pool->sets) {
+                set[l] = claim_set(pool);
+                if (set[l] < pool->sets) {
+                    mutant[l] = MUTANT_WT;
+                    for (int m = 0; m < NUM_MUTANTS; m++) {
+                        clear_data(pool->results[set[l]].features[m]);
+                    }
+                    begin_mutant(pool->rateValues[set[l]], mutant[l], original[l]);
+                }
+            }
+            active[l] = set[l] < pool->sets ? -1 : 0;
+            if (active[l] && first_active < 0) {
+                first_active = l;
+            }
+        }
+        if (first_active < 0) {
+            break;
+        }
+        
+        // Idle lanes simulate the rates of an active lane so their arithmetic stays well behaved
+        rates *lane_rates[LANES];
+        for (int l = 0; l < LANES; l++) {
+            lane_rates[l] = pool->rateValues[set[active[l] ? l : first_active]];
+            gene.mh1_peaks[l].clear();
+        }
+        lane_mask failed = model_lanes(pool->eps, pool->t_steps, &gene, lane_rates, active, pool->max_prop, pool->x, pool->y);
+        
+        for (int l = 0; l < LANES; l++) {
+            if (!active[l]) {
+                continue;
+            }
+            data *features = pool->results[set[l]].features;
+            ofeatures(&gene.mh1_peaks[l], mutant_wild[mutant[l]], features[mutant[l]]);
+            if (failed[l] || !mutant_passed(mutant[l], features)) {
+                finish_set(pool, set[l], false);
+                set[l] = pool->sets;
+                continue;
+            }
+            end_mutant(pool->rateValues[set[l]], mutant[l], original[l]);
+            if (++mutant[l] == NUM_MUTANTS) {
+                finish_set(pool, set[l], true);
+                set[l] = pool->sets;
+            } else {
+                begin_mutant(pool->rateValues[set[l]], mutant[l], original[l]);
+            }
+        }
+    }
+}
+
 int main(int argc, char** argv)
 {
     /*
@@ -66,7 +238,10 @@ int main(int argc, char** argv)
     double eps = 0.01; // time step to be used for Euler's method, default is 0.01
     double max_prop = INFINITY; // maximum threshold for propensity functions, default is INFINITY
     bool toPrint = false, ofeat = false; // boolean marking whether or not concentrations should be printed to a text file
-    checkArgs(argc, argv, &input_file, &output_path, &gradients_file, &ofeat_file, ofeat, PARS, seed, minutes, eps, max_prop, toPrint, x, y);
+    int threads = 1; // number of parameter sets to simulate at the same time, default value is 1
+    bool vectorize = false; // boolean marking whether or not each thread simulates LANES parameter sets at once
+    double tolerance = 0; // error tolerance of the adaptive method, default is 0 for Euler's method
+    checkArgs(argc, argv, &input_file, &output_path, &gradients_file, &ofeat_file, ofeat, PARS, seed, minutes, eps, max_prop, toPrint, x, y, threads, vectorize, tolerance);
     rates *rateValues[CHUNK_SIZE];
     for (int j = 0; j < CHUNK_SIZE; j++){
         rateValues[j] = new rates(50);
@@ -85,139 +260,52 @@ int main(int argc, char** argv)
     create_output(output_path, toPrint, ofeat, ofeat_file, &allpassed, &oft, mutants);
 
 
-    // Iterate through every paramater set
+    // Iterate through every paramater set, a chunk at a time
+    set_result *results = new set_result[CHUNK_SIZE];
     for (int p = 0; p < PARS; p += CHUNK_SIZE) {
         int STEP = (PARS - p > CHUNK_SIZE ? CHUNK_SIZE : PARS - p);
         srand(seed);
         store_values(input_file, buffer, index, rateValues, STEP, seed, gradients); // Read the parameter sets from the buffer
-        glevels gene(minutes / eps, x * y); // Create the structure that contains the 2D arrays which hold the gene levels
-		for (int i = 0; i < STEP; i++) {
-            string res;
-	    	ostringstream convert;
-	    	convert << i;
-	    	res = convert.str();
-            cerr << "Simulating set " << p + i << endl; // Used for creating output file names specific to the paramater
-	    	int t_steps = int(minutes / eps); // Set the amount of time steps to be used in the simulation
-		 
-	    	rates *temp_rate = rateValues[i]; // Temporary rate structure used to alter the protein synthesis rates in order to create mutants
-	    	data of_wt, of_her1, of_her7, of_her13, of_her713, of_delta; // Data structures for storing oscillation features
-	    	bool wt = false, her1 = false, her7 = false, her13 = false, her713 = false, delta = false;  // Booleans to see if we met mutant conditions on each iteration
-		 
-	    	// Clear data from previous iterations
-	    	clear_data(of_wt);
-	    	clear_data(of_her1);
-	    	clear_data(of_her7);
-	    	clear_data(of_her13);
-	    	clear_data(of_her713);
-	    	clear_data(of_delta);
-			
-            /* 
-             For the wild type and every mutant, perform the following steps:
-             1) Adjust the appropriate protein synthesis rates to create mutants if necessary
-             2) Run the simulation
-             3) Go to the next parameter set if the propensities for the current one have gone above the set threshold
-             4) Otherwise, test oscillation features
-             5) Go to the next parameter set if the current one did not produce oscillations or did not satisfy the mutant conditions
-             */
-            wt = run_mutant(&gene, t_steps, eps, temp_rate, of_wt, true, max_prop, x, y);
-            if (toPrint) {
-                printForPlotting(mutants[0] + "/run0.txt", &gene, t_steps, eps);
-            }
-	    	if (!wt) continue; 
-            wt = fwildtype(of_wt.peaktotrough1, of_wt.peaktotrough2); 
-            if (!wt) continue; 
-
-            double original_psd = temp_rate->rates_base[RPSDELTA]; 
-            temp_rate->rates_base[RPSDELTA] = 0.0; 
-            reset_rate(temp_rate);
-            delta = run_mutant(&gene, t_steps, eps, temp_rate, of_delta, false, max_prop, x, y);
-            if (toPrint) {
-                printForPlotting(mutants[1] + "/run0.txt", &gene, t_steps, eps);
-            }
-	    	if (!delta) continue; 
-            delta = fd_mutant(of_delta.period, of_delta.amplitude, of_wt.period); 
-            if (!delta) continue; 
-            temp_rate->rates_base[RPSDELTA] = original_psd; 
-            
-            double original_psh13 = temp_rate->rates_base[RPSH13]; 
-            temp_rate->rates_base[RPSH13] = 0.0;
-            reset_rate(temp_rate); 
-            her13 = run_mutant(&gene, t_steps, eps, temp_rate, of_her13, false, max_prop, x, y);
-            if (toPrint) {
-                printForPlotting(mutants[2] + "/run0.txt", &gene, t_steps, eps);
-            }
-	    	if (!her13) continue; 
-            her13 = f13_mutant(of_her13.period, of_her13.amplitude, of_wt.period);
-            if (!her13) continue; 
-            temp_rate->rates_base[RPSH13] = original_psh13; 
-            
-
-            double original_psh1 = temp_rate->rates_base[RPSH1];
-            temp_rate->rates_base[RPSH1] = 0.0;
-            reset_rate(temp_rate);
-            her1 = run_mutant(&gene, t_steps, eps, temp_rate, of_her1, false, max_prop, x, y);
-            if (toPrint) {
-                printForPlotting(mutants[3] + "/run0.txt", &gene, t_steps, eps);
-            }
-	    	if (!her1) continue;
-            her1 = f1_mutant(of_her1.period, of_her1.amplitude, of_wt.period);
-            if (!her1) continue;
-            temp_rate->rates_base[RPSH1] = original_psh1;
-            
-            double original_psh7 = temp_rate->rates_base[RPSH7];
-            temp_rate->rates_base[RPSH7] = 0.0;
-            reset_rate(temp_rate);
-            her7 = run_mutant(&gene, t_steps, eps, temp_rate, of_her7, true, max_prop, x, y);
-            if (toPrint) {
-                printForPlotting(mutants[4] + "/run0.txt", &gene, t_steps, eps);
-            }
-            if (!her7) continue;
-            her7 = f7_mutant(of_her7.period, of_her7.amplitude, of_wt.period);
-            if (!her7) continue;
-            temp_rate->rates_base[RPSH7] = original_psh7;
-            
-            original_psh7 = temp_rate->rates_base[RPSH7];
-            original_psh13 =  temp_rate->rates_base[RPSH13];
-            temp_rate->rates_base[RPSH7] = 0.0, temp_rate->rates_base[RPSH13] = 0.0;
-            reset_rate(temp_rate);
-            her713 = run_mutant(&gene, t_steps, eps, temp_rate, of_her713, true, max_prop, x, y);
-            if (toPrint) {
-                printForPlotting(mutants[5] + "/run0.txt", &gene, t_steps, eps);
-            }
-	    	if (!her713) continue;
-            her713 = f713_mutant(of_her713.period, of_her713.amplitude, of_wt.period);
-            if (!her713) continue;
-            temp_rate->rates_base[RPSH7] = original_psh7;
-            temp_rate->rates_base[RPSH13] = original_psh13;
-
-            /*
-             If the paramater set created oscillatory behavior in wild type and all the mutant conditions were satisfied:
-             1) Print the appropriate message
-             2) Print the oscillation features into the appropriate files
-             2) Print the parameter set into the output file containing parameter that passed the conditions.
-            */
-            
-            cerr << terminal_blue << "Parameter set " << i << " passed." << terminal_reset << endl;
-            if (ofeat) {
-                oft << res << "," << of_wt.period << "," << of_wt.amplitude << "," << of_wt.peaktotrough1 << ",";
-                oft << of_delta.period << "," << of_delta.amplitude << "," << of_delta.peaktotrough1 << ",";
-                oft << of_her1.period << "," << of_her1.amplitude << "," << of_her1.peaktotrough1 << ",";
-                oft << of_her7.period << "," << of_her7.amplitude << "," << of_her7.peaktotrough1 << ",";
-                oft << of_her13.period << "," << of_her13.amplitude << "," << of_her13.peaktotrough1 << ",";
-                oft << of_her713.period << "," << of_her713.amplitude << "," << of_her713.peaktotrough1 << ",";
-            }
-            allpassed<<temp_rate->rates_base[RPSH1]<<","<<temp_rate->rates_base[RPSH7]<<","<<temp_rate->rates_base[RPSH13]<<","<<temp_rate->rates_base[RPSDELTA]<<","<<temp_rate->rates_base[RPDH1]<<","<<temp_rate->rates_base[RPDH7]<<",";
-	    	allpassed<<temp_rate->rates_base[RPDH13]<<","<<temp_rate->rates_base[RPDDELTA]<<","<<temp_rate->rates_base[RMSH1]<<","<<temp_rate->rates_base[RMSH7]<<","<<temp_rate->rates_base[RMSH13]<<","<<temp_rate->rates_base[RMSDELTA]<<",";
-	    	allpassed<<temp_rate->rates_base[RMDH1]<<","<<temp_rate->rates_base[RMDH7]<<","<<temp_rate->rates_base[RMDH13]<<","<<temp_rate->rates_base[RMDDELTA]<<"," <<temp_rate->rates_base[RDDGH1H1] << "," << temp_rate->rates_base[RDDGH1H7] << ",";
-	    	allpassed<<temp_rate->rates_base[RDDGH1H13]<<","<<temp_rate->rates_base[RDDGH7H7]<<","<<temp_rate->rates_base[RDDGH7H13]<<","<<temp_rate->rates_base[RDDGH13H13]<<",";
-	    	allpassed<<temp_rate->rates_base[RDELAYMH1]<<","<<temp_rate->rates_base[RDELAYMH7]<<","<<temp_rate->rates_base[RDELAYMH13]<<","<<temp_rate->rates_base[RDELAYMDELTA]<<","<<temp_rate->rates_base[RDELAYPH1]<<",";
-	    	allpassed<<temp_rate->rates_base[RDELAYPH7]<<","<<temp_rate->rates_base[RDELAYPH13]<<","<<temp_rate->rates_base[RDELAYPDELTA]<<","<<temp_rate->rates_base[RDAH1H1]<<","<<temp_rate->rates_base[RDDIH1H1]<<","<<temp_rate->rates_base[RDAH1H7]<<",";
-	    	allpassed<<temp_rate->rates_base[RDDIH1H7]<<","<<temp_rate->rates_base[RDAH1H13]<<","<<temp_rate->rates_base[RDDIH1H13]<<","<<temp_rate->rates_base[RDAH7H7]<<","<<temp_rate->rates_base[RDDIH7H7]<<","<<temp_rate->rates_base[RDAH7H13]<<",";
-	    	allpassed<<temp_rate->rates_base[RDDIH7H13]<<","<<temp_rate->rates_base[RDAH13H13]<<","<<temp_rate->rates_base[RDDIH13H13]<<","<<temp_rate->rates_base[RCRITPH1H1] << "," << temp_rate->rates_base[RCRITPH7H13] <<","<<temp_rate->rates_base[RCRITPDELTA]<<endl;
-	    }
+        
+        /*
+         Simulate the chunk on a pool of threads (by default 1, but can be changed with -n or --threads), with the calling thread acting as the first one.
+         Each thread simulates whichever set is next, or whichever LANES sets are next with -v or --vectorize, and the sets are printed in order as they finish (see simulate_sets).
+         */
+        set_pool pool;
+        pool.rateValues = rateValues;
+        pool.results = results;
+        pool.sets = STEP;
+        pool.first = p;
+        pool.t_steps = int(minutes / eps); // Set the amount of time steps to be used in the simulation
+        pool.print_step = int(0.1 / eps) > 0 ? int(0.1 / eps) : 1; // Print the concentrations every 0.1 minutes
+        pool.eps = eps;
+        pool.max_prop = max_prop;
+        pool.tolerance = tolerance;
+        pool.x = x;
+        pool.y = y;
+        pool.toPrint = toPrint;
+        pool.ofeat = ofeat;
+        pool.mutants = mutants;
+        pool.allpassed = &allpassed;
+        pool.oft = &oft;
+        pool.next_set = 0;
+        pool.next_write = 0;
+        for (int i = 0; i < STEP; i++) {
+            results[i].done = false;
+        }
+        
+        vector<thread> workers;
+        for (int w = 1; w < threads && w < STEP; w++) {
+            workers.push_back(thread(vectorize ? simulate_sets_lanes : simulate_sets, &pool));
+        }
+        (vectorize ? simulate_sets_lanes : simulate_sets)(&pool);
+        for (unsigned int w = 0; w < workers.size(); w++) {
+            workers[w].join();
+        }
         
         cerr << terminal_blue << "Done with " << terminal_reset << STEP << " parameter sets." << endl;
 	}
+    delete[] results;
 
 	if (input_file != NULL) {
         free(buffer);
@@ -0,0 +1,150 @@
+/*
+Stochastic simulator for zebrafish segmentation
+Copyright (C) 2012 Ahmet Ay, Jack Holland, Adriana Sperlea
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/*
+Benchmark of the delayed reaction queues:
+Replays the pushes and pops the next-reaction-method makes on the delayed reaction queues of a tissue and counts the memory allocations they cause,
+first with the std::list pair the simulator used to use (one list of firing times and one of firings and spans per delayed reaction) and then with delay_arena.
+Every delayed reaction starts at a fixed rate (by default 60 per minute, around the transcription rates of a typical parameter set) and finishes after a fixed delay
+(by default 10 minutes, around the transcription delays), so each queue holds about rate * delay nodes once the first delay has passed.
+Usage: delay-queue [cells] [minutes] [runs] [rate] [delay]
+*/
+
+#include <iostream>
+#include <list>
+#include <new>
+#include <stdlib.h>
+#include <time.h>
+
+#include "../source/delay-queue.h"
+#include "../source/macros.h"
+#include "../source/rand-dist.h"
+
+using namespace std;
+
+unsigned long allocations = 0; // the number of calls to operator new since the program started
+
+void* operator new (size_t size) {
+	allocations++;
+	void* p = malloc(size);
+	if (p == NULL) {
+		throw bad_alloc();
+	}
+	return p;
+}
+
+void operator delete (void* p) noexcept {
+	free(p);
+}
+
+void operator delete (void* p, size_t) noexcept {
+	free(p);
+}
+
+// the firings and span half of a node as the simulator used to store it, in a list next to the list of firing times
+struct old_rq_node {
+	int firings;
+	double span;
+	
+	old_rq_node (int firings, double span) {
+		this->firings = firings;
+		this->span = span;
+	}
+};
+
+struct bench_settings {
+	int cells;
+	int minutes;
+	int runs;
+	double rate;
+	double delay;
+};
+
+// replay a run on the std::list queues, returning the number of nodes that finished
+long replay_lists (bench_settings* bs) {
+	long finished = 0;
+	for (int r = 0; r < bs->runs; r++) {
+		list<double> rq[bs->cells][num_of_delayed_reactions];
+		list<old_rq_node> rq_idl[bs->cells][num_of_delayed_reactions];
+		double t = 0;
+		double total_rate = bs->rate * bs->cells * num_of_delayed_reactions;
+		rand_stream rng(1, r);
+		while (t < bs->minutes) {
+			t += expo_dist(&rng, total_rate);
+			int q = unif_dist(&rng) * (bs->cells * num_of_delayed_reactions);
+			int i = q / num_of_delayed_reactions;
+			int d = q % num_of_delayed_reactions;
+			while (!rq[i][d].empty() && rq[i][d].front() <= t) {
+				rq[i][d].pop_front();
+				rq_idl[i][d].pop_front();
+				finished++;
+			}
+			rq[i][d].push_back(t + bs->delay);
+			rq_idl[i][d].push_back(old_rq_node(1, 0));
+		}
+	}
+	return finished;
+}
+
+// replay a run on a delay_arena, returning the number of nodes that finished
+long replay_arena (bench_settings* bs) {
+	long finished = 0;
+	delay_arena rq(bs->cells, delay_queue_capacity);
+	for (int r = 0; r < bs->runs; r++) {
+		double t = 0;
+		double total_rate = bs->rate * bs->cells * num_of_delayed_reactions;
+		rand_stream rng(1, r);
+		while (t < bs->minutes) {
+			t += expo_dist(&rng, total_rate);
+			int q = unif_dist(&rng) * (bs->cells * num_of_delayed_reactions);
+			int i = q / num_of_delayed_reactions;
+			int d = q % num_of_delayed_reactions;
+			while (!rq[i][d].empty() && rq[i][d].front().time <= t) {
+				rq[i][d].pop_front();
+				finished++;
+			}
+			rq[i][d].push_back(rq_node(t + bs->delay, 1, 0));
+		}
+		rq.clear();
+	}
+	return finished;
+}
+
+void report (const char* name, bench_settings* bs, long (*replay)(bench_settings*)) {
+	unsigned long start_allocations = allocations;
+	clock_t start = clock();
+	long finished = replay(bs);
+	double seconds = (double)(clock() - start) / CLOCKS_PER_SEC;
+	unsigned long used = allocations - start_allocations;
+	cout << name << ": " << used << " allocations, " << (double)used / ((double)bs->minutes * bs->runs) << " per simulated minute, " << seconds << " s (" << finished << " delayed reactions finished)" << endl;
+}
+
+int main (int argc, char** argv) {
+	bench_settings bs;
+	bs.cells = argc > 1 ? atoi(argv[1]) : 16;
+	bs.minutes = argc > 2 ? atoi(argv[2]) : 1200;
+	bs.runs = argc > 3 ? atoi(argv[3]) : 3;
+	bs.rate = argc > 4 ? atof(argv[4]) : 60;
+	bs.delay = argc > 5 ? atof(argv[5]) : 10;
+	
+	cout << bs.cells << " cells, " << bs.minutes << " minutes, " << bs.runs << " runs, " << bs.rate << " starts per minute per delayed reaction, " << bs.delay << " minute delays" << endl;
+	report("std::list", &bs, replay_lists);
+	report("delay_arena", &bs, replay_arena);
+	return 0;
+}
+
@@ -0,0 +1,171 @@
+/*
+Stochastic simulator for zebrafish segmentation
+Copyright (C) 2012 Ahmet Ay, Jack Holland, Adriana Sperlea
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/*
+Benchmark and sanity checks of the random number layer in rand-dist.h:
+1) Check xoshiro256++ against its reference output, that fill_unif matches unif_dist, and that jumped streams differ
+2) Check the mean and variance (and for the uniform distribution a chi-square statistic) of each distribution against their expected values
+3) Time the uniform distribution with the old rand() based generator and with xoshiro256++ (one at a time and filled in batches), and the other distributions
+The program returns 1 if any check fails.
+Usage: rand-dist [samples]
+*/
+
+#include <iostream>
+#include <math.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "../source/rand-dist.h"
+
+using namespace std;
+
+int failures = 0; // the number of checks that failed
+
+void check (const char* name, bool passed) {
+	cout << (passed ? "passed" : "FAILED") << ": " << name << endl;
+	if (!passed) {
+		failures++;
+	}
+}
+
+// whether or not a sample mean is within 5 standard errors of the expected mean
+bool close_mean (double mean, double expected, double variance, long samples) {
+	return fabs(mean - expected) < 5 * sqrt(variance / samples);
+}
+
+// check the mean and variance of samples drawn by sample against the distribution's expected values
+template <typename sampler> void check_moments (const char* name, sampler sample, double expected_mean, double expected_variance, long samples) {
+	double sum = 0;
+	double sum_sq = 0;
+	for (long i = 0; i < samples; i++) {
+		double v = sample();
+		sum += v;
+		sum_sq += v * v;
+	}
+	double mean = sum / samples;
+	double variance = sum_sq / samples - mean * mean;
+	cout << name << ": mean " << mean << " (expected " << expected_mean << "), variance " << variance << " (expected " << expected_variance << ")" << endl;
+	check(name, close_mean(mean, expected_mean, expected_variance, samples) && fabs(variance - expected_variance) < 0.01 * expected_variance);
+}
+
+// time samples draws of sample and print the time per draw
+template <typename sampler> void time_draws (const char* name, sampler sample, long samples) {
+	double sink = 0; // keeps the draws from being optimized away
+	clock_t start = clock();
+	for (long i = 0; i < samples; i++) {
+		sink += sample();
+	}
+	double seconds = (double)(clock() - start) / CLOCKS_PER_SEC;
+	cout << name << ": " << seconds * 1e9 / samples << " ns per draw (" << sink / samples << ")" << endl;
+}
+
+int main (int argc, char** argv) {
+	long samples = argc > 1 ? atol(argv[1]) : 10000000;
+	
+	// 1) the engine
+	xoshiro256pp reference(0);
+	reference.s[0] = 1;
+	reference.s[1] = 2;
+	reference.s[2] = 3;
+	reference.s[3] = 4;
+	check("xoshiro256++ reference output", reference.next() == 41943041ULL);
+	
+	rand_stream a(1, 0);
+	rand_stream b(1, 0);
+	double batch[1000];
+	a.fill_unif(batch, 1000);
+	bool same = true;
+	for (int i = 0; i < 1000; i++) {
+		same = same && batch[i] == unif_dist(&b);
+	}
+	check("fill_unif matches unif_dist", same);
+	
+	rand_stream run0(1, 0);
+	rand_stream run1(1, 1);
+	rand_stream jumped(1, 0);
+	jumped.jump();
+	bool jump_matches = true;
+	double cov = 0;
+	for (int i = 0; i < 100000; i++) {
+		double u0 = unif_dist(&run0) - 0.5;
+		uint64_t v1 = run1.next();
+		jump_matches = jump_matches && v1 == jumped.next();
+		double u1 = (v1 >> 11) * (1.0 / 9007199254740992.0) - 0.5;
+		cov += u0 * u1;
+	}
+	check("run streams are jumped from the seed", jump_matches);
+	check("neighboring run streams are uncorrelated", fabs(cov / 100000) < 5 * (1.0 / 12) / sqrt(100000.0));
+	
+	stream_source source(1);
+	unsigned int order[] = {0, 3, 4, 9, 2, 6, 7, 5, 1}; // increasing, then back to an earlier run, then (with a checkpoint at 5) back to runs after and before it
+	bool source_matches = true;
+	for (int k = 0; k < 9; k++) {
+		if (k == 5) {
+			source.checkpoint(5);
+		}
+		rand_stream from_source = source.stream(order[k]);
+		rand_stream from_seed(1, order[k]);
+		for (int i = 0; i < 100; i++) {
+			source_matches = source_matches && from_source.next() == from_seed.next();
+		}
+	}
+	check("stream_source hands out the same streams as the seed", source_matches);
+	
+	// 2) the distributions
+	rand_stream rng(12345, 0);
+	check_moments("uniform", [&]() { return unif_dist(&rng); }, 0.5, 1.0 / 12, samples);
+	long bins[100] = {0};
+	for (long i = 0; i < samples; i++) {
+		bins[(int)(unif_dist(&rng) * 100)]++;
+	}
+	double chi_sq = 0;
+	for (int i = 0; i < 100; i++) {
+		double expected = samples / 100.0;
+		chi_sq += (bins[i] - expected) * (bins[i] - expected) / expected;
+	}
+	cout << "uniform chi-square over 100 bins: " << chi_sq << " (expected 99)" << endl;
+	check("uniform chi-square", chi_sq < 99 + 5 * sqrt(2 * 99.0));
+	check_moments("exponential", [&]() { return expo_dist(&rng, 2.5); }, 1 / 2.5, 1 / (2.5 * 2.5), samples);
+	check_moments("Poisson", [&]() { return (double)pois_dist(&rng, 3.7); }, 3.7, 3.7, samples);
+	check_moments("Poisson (large mean)", [&]() { return (double)pois_dist(&rng, 250.0); }, 250, 250, samples);
+	check_moments("binomial", [&]() { return (double)bino_dist(&rng, 20, 0.3); }, 20 * 0.3, 20 * 0.3 * 0.7, samples);
+	check_moments("binomial (few trials)", [&]() { return (double)bino_dist(&rng, 5, 0.3); }, 5 * 0.3, 5 * 0.3 * 0.7, samples);
+	check_moments("binomial (large mean)", [&]() { return (double)bino_dist(&rng, 1000, 0.3); }, 1000 * 0.3, 1000 * 0.3 * 0.7, samples);
+	check_moments("binomial (p > 0.5)", [&]() { return (double)bino_dist(&rng, 200, 0.8); }, 200 * 0.8, 200 * 0.8 * 0.2, samples);
+	check_moments("Pk", [&]() { return pk_dist(&rng); }, 1, 1, samples);
+	
+	// 3) timing
+	srand(1);
+	time_draws("uniform (rand)", []() { return rand() / (((double)RAND_MAX) + 1); }, samples);
+	time_draws("uniform (xoshiro256++)", [&]() { return unif_dist(&rng); }, samples);
+	double* filled = new double[samples];
+	rng.fill_unif(filled, samples); // touch the memory first so the timing below doesn't include page faults
+	clock_t start = clock();
+	rng.fill_unif(filled, samples);
+	double seconds = (double)(clock() - start) / CLOCKS_PER_SEC;
+	cout << "uniform (xoshiro256++ fill_unif): " << seconds * 1e9 / samples << " ns per draw (" << filled[samples - 1] << ")" << endl;
+	delete[] filled;
+	time_draws("exponential", [&]() { return expo_dist(&rng, 2.5); }, samples);
+	time_draws("Poisson (mean 3.7)", [&]() { return (double)pois_dist(&rng, 3.7); }, samples);
+	time_draws("Poisson (mean 250)", [&]() { return (double)pois_dist(&rng, 250.0); }, samples);
+	time_draws("binomial (n 1000, p 0.3)", [&]() { return (double)bino_dist(&rng, 1000, 0.3); }, samples);
+	time_draws("Pk", [&]() { return pk_dist(&rng); }, samples);
+	
+	return failures > 0;
+}
+
@@ -0,0 +1,215 @@
+/*
+Stochastic simulator for zebrafish segmentation
+Copyright (C) 2012 Ahmet Ay, Jack Holland, Adriana Sperlea
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/*
+Benchmark of the Poisson and binomial samplers used by tau-leaping and id-leaping:
+Draws from synthetic mixes of (mean) and (n, p) arguments, each aimed at one path of pois_dist and bino_dist, with the samplers the simulator used to use
+(Knuth's multiplication loop and one Bernoulli trial per firing) and the ones in rand-dist.h.
+The arguments are generated from a fixed seed, so every run replays the same mixes.
+For each mix it prints the time and number of uniforms per draw of both samplers, and checks that the totals of the draws match the totals of the means.
+The program returns 1 if any total doesn't match.
+Usage: tau-leap-draws [passes]
+*/
+
+#include <iostream>
+#include <math.h>
+#include <stdlib.h>
+#include <time.h>
+#include <vector>
+
+#include "../source/rand-dist.h"
+
+using namespace std;
+
+// an engine that counts how many numbers it generated
+struct counting_stream : rand_stream {
+	unsigned long draws;
+	
+	counting_stream () : rand_stream(1, 0) {
+		this->draws = 0;
+	}
+	
+	uint64_t next () {
+		this->draws++;
+		return rand_stream::next();
+	}
+};
+
+// the Poisson sampler the simulator used to use
+template <typename engine> inline int pois_knuth (engine* rng, double mean) {
+	double L = pow(M_E, -mean);
+	int k = 0;
+	double p = 1;
+	do {
+		k++;
+		p *= unif_dist(rng);
+	} while (p > L);
+	return k - 1;
+}
+
+// the binomial sampler the simulator used to use
+template <typename engine> inline int bino_bernoulli (engine* rng, int n, double p) {
+	int x = 0;
+	for (int i = 0; i < n; i++) {
+		if (unif_dist(rng) < p) {
+			x++;
+		}
+	}
+	return x;
+}
+
+struct bino_args {
+	int n;
+	double p;
+};
+
+// a mix of Poisson means or binomial arguments aimed at one path of the samplers
+struct draw_mix {
+	const char* name;
+	vector<double> means;
+	vector<bino_args> binos;
+};
+
+const int mix_size = 10000; // the number of arguments in each mix
+
+// a number between low and high spread evenly on a log scale, for arguments spanning several orders of magnitude
+inline double log_unif (rand_stream* rng, double low, double high) {
+	return low * pow(high / low, unif_dist(rng));
+}
+
+// a Poisson mix with means between low and high
+draw_mix pois_mix (rand_stream* rng, const char* name, double low, double high, bool logscale) {
+	draw_mix m;
+	m.name = name;
+	for (int i = 0; i < mix_size; i++) {
+		m.means.push_back(logscale ? log_unif(rng, low, high) : low + (high - low) * unif_dist(rng));
+	}
+	return m;
+}
+
+// a binomial mix with between nlow and nhigh trials and either the expected firings n * p or p itself between low and high
+draw_mix bino_mix (rand_stream* rng, const char* name, int nlow, int nhigh, double low, double high, bool by_mean) {
+	draw_mix m;
+	m.name = name;
+	for (int i = 0; i < mix_size; i++) {
+		bino_args b;
+		b.n = nlow + (int)((nhigh - nlow + 1) * unif_dist(rng));
+		double x = low + (high - low) * unif_dist(rng);
+		b.p = !by_mean ? x : (x < b.n ? x / b.n : 1);
+		m.binos.push_back(b);
+	}
+	return m;
+}
+
+int failures = 0; // the number of totals that didn't match
+
+// print the time and uniforms per draw of one sampler and check its total against the expected total
+void report (const char* name, clock_t start, unsigned long uniforms, double total, double expected, double variance, long draws) {
+	double seconds = (double)(clock() - start) / CLOCKS_PER_SEC;
+	bool passed = fabs(total - expected) < 5 * sqrt(variance);
+	cout << "  " << name << ": " << seconds * 1e9 / draws << " ns per draw, " << (double)uniforms / draws << " uniforms per draw, total " << total << " (expected " << expected << ") " << (passed ? "passed" : "FAILED") << endl;
+	if (!passed) {
+		failures++;
+	}
+}
+
+// time the old and new Poisson samplers on a mix
+void replay_pois (const draw_mix& m, int passes) {
+	double expected = 0;
+	for (unsigned int i = 0; i < m.means.size(); i++) {
+		expected += m.means[i];
+	}
+	expected *= passes;
+	long draws = (long)m.means.size() * passes;
+	cout << m.name << endl;
+	
+	counting_stream rng;
+	clock_t start = clock();
+	double total = 0;
+	for (int r = 0; r < passes; r++) {
+		for (unsigned int i = 0; i < m.means.size(); i++) {
+			total += pois_knuth(&rng, m.means[i]);
+		}
+	}
+	report("Knuth", start, rng.draws, total, expected, expected, draws);
+	
+	rng.draws = 0;
+	start = clock();
+	total = 0;
+	for (int r = 0; r < passes; r++) {
+		for (unsigned int i = 0; i < m.means.size(); i++) {
+			total += pois_dist(&rng, m.means[i]);
+		}
+	}
+	report("pois_dist", start, rng.draws, total, expected, expected, draws);
+}
+
+// time the old and new binomial samplers on a mix
+void replay_bino (const draw_mix& m, int passes) {
+	double expected = 0;
+	double variance = 0;
+	for (unsigned int i = 0; i < m.binos.size(); i++) {
+		expected += m.binos[i].n * m.binos[i].p;
+		variance += m.binos[i].n * m.binos[i].p * (1 - m.binos[i].p);
+	}
+	expected *= passes;
+	variance *= passes;
+	long draws = (long)m.binos.size() * passes;
+	cout << m.name << endl;
+	
+	counting_stream rng;
+	clock_t start = clock();
+	double total = 0;
+	for (int r = 0; r < passes; r++) {
+		for (unsigned int i = 0; i < m.binos.size(); i++) {
+			total += bino_bernoulli(&rng, m.binos[i].n, m.binos[i].p);
+		}
+	}
+	report("Bernoulli trials", start, rng.draws, total, expected, variance, draws);
+	
+	rng.draws = 0;
+	start = clock();
+	total = 0;
+	for (int r = 0; r < passes; r++) {
+		for (unsigned int i = 0; i < m.binos.size(); i++) {
+			total += bino_dist(&rng, m.binos[i].n, m.binos[i].p);
+		}
+	}
+	report("bino_dist", start, rng.draws, total, expected, variance, draws);
+}
+
+int main (int argc, char** argv) {
+	int passes = argc > 1 ? atoi(argv[1]) : 20;
+	
+	/*
+	Most of tau-leaping's firing counts have means well under 1, so the first mixes matter most for the simulator as it is;
+	the larger ones cover the rejection samplers, which take over for high copy numbers and long leaps.
+	Means stay under 500 since Knuth's loop underflows past about 700.
+	*/
+	rand_stream args(2013, 0);
+	cout << mix_size << " arguments per mix, replayed " << passes << " times" << endl;
+	replay_pois(pois_mix(&args, "Poisson, means 0.001-1 (inversion)", 0.001, 1, true), passes);
+	replay_pois(pois_mix(&args, "Poisson, means 1-10 (inversion)", 1, 10, false), passes);
+	replay_pois(pois_mix(&args, "Poisson, means 10-500 (PTRS)", 10, 500, true), passes);
+	replay_bino(bino_mix(&args, "binomial, 1-15 trials (Bernoulli trials)", 1, 15, 0, 1, false), passes);
+	replay_bino(bino_mix(&args, "binomial, 16-200 trials, n * p under 10 (inversion)", 16, 200, 0, 10, true), passes);
+	replay_bino(bino_mix(&args, "binomial, 100-2000 trials, n * p 10-100 (BTRS)", 100, 2000, 10, 100, true), passes);
+	replay_bino(bino_mix(&args, "binomial, 100-2000 trials, p 0.5-0.99 (BTRS on 1 - p)", 100, 2000, 0.5, 0.99, false), passes);
+	
+	return failures > 0;
+}
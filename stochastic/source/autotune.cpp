@@ -0,0 +1,327 @@
+/*
+Stochastic simulator for zebrafish segmentation
+Copyright (C) 2012 Ahmet Ay, Jack Holland, Adriana Sperlea
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <math.h>
+#include <mutex>
+#include <sstream>
+#include <stdlib.h>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "autotune.h"
+#include "batch.h"
+#include "features.h"
+#include "leap-settings.h"
+#include "macros.h"
+#include "parameters.h"
+#include "simulation.h"
+
+using namespace std;
+
+// global variables set in main.cpp
+extern char* terminal_blue;
+extern char* terminal_red;
+extern char* terminal_reset;
+
+static mutex cout_mutex; // keeps the workers' progress messages from interleaving
+
+// the approximate settings tried for each condition, every epsilon with every tau1_mult (the other settings are the ones given with -w or --leap)
+static const double candidate_epsilons[] = {0.01, 0.03, 0.05};
+static const double candidate_tau1_mults[] = {5, 10, 20};
+
+// the mean features of one setting's calibration runs and how long they took to simulate
+struct calibration {
+	double period;
+	double amplitude;
+	double syncscore;
+	double seconds;
+};
+
+/*
+The tag every cache key starts with, which spells out the candidate grid and how candidates are judged,
+so settings tuned with a different grid, calibration length, or tolerance are never taken for ones tuned with these.
+It has no commas, so it's a single value of a cache line.
+*/
+static string calibration_tag () {
+	ostringstream tag;
+	tag << "autotune(epsilon=";
+	for (unsigned int e = 0; e < sizeof(candidate_epsilons) / sizeof(double); e++) {
+		tag << (e > 0 ? " " : "") << candidate_epsilons[e];
+	}
+	tag << ";tau1_mult=";
+	for (unsigned int t = 0; t < sizeof(candidate_tau1_mults) / sizeof(double); t++) {
+		tag << (t > 0 ? " " : "") << candidate_tau1_mults[t];
+	}
+	tag << ";minutes=" << autotune_minutes << ";runs=" << autotune_runs << ";tolerance=" << autotune_tolerance << ")";
+	return tag.str();
+}
+
+/*
+The key a condition's settings are cached under: the calibration tag, the tissue size, the condition's parameters (with its mutant's knockouts applied),
+and the settings the candidates are built from (the ones given with -a, -H, -L, and -w or --leap), so tuning with other base settings doesn't reuse these.
+*/
+static string cache_key (sim_constants* sc, sim_condition* condition) {
+	double values[num_of_parameters];
+	parameter_values(&condition->pars, values);
+	double leaping[num_of_leap_settings];
+	get_leap_settings(&condition->leaping, leaping);
+	ostringstream key;
+	key.precision(17);
+	key << calibration_tag() << "," << sc->width << "," << sc->height;
+	for (int i = 0; i < num_of_parameters; i++) {
+		key << "," << values[i];
+	}
+	key << "," << condition->leaping.appx << "," << condition->leaping.hybrid << "," << condition->leaping.langevin;
+	for (int l = 0; l < num_of_leap_settings; l++) {
+		key << "," << leaping[l];
+	}
+	return key.str();
+}
+
+/*
+Load the settings cached by earlier autotuning:
+every nonempty line of the cache file is a cache key (see cache_key), whether to approximate, whether to simulate hybridly, and whether to solve the chemical Langevin equation (1 or 0), and the value of each leaping setting in the order of leap_setting_names.
+Lines that don't start with the current calibration tag were tuned differently (or before the tag existed), so they're skipped.
+A missing cache file is an empty cache, since autotuning creates it.
+*/
+static void load_cache (const char* cache_file, map<string, leap_settings>* cache) {
+	ifstream file(cache_file);
+	if (!file) {
+		return;
+	}
+	string tag = calibration_tag() + ",";
+	int key_values = 3 + num_of_parameters + 3 + num_of_leap_settings;
+	string line;
+	int line_number = 0;
+	while (getline(file, line)) {
+		line_number++;
+		if (line.find_first_not_of(" \t\r") == string::npos || line.compare(0, tag.size(), tag) != 0) {
+			continue;
+		}
+		vector<size_t> commas;
+		for (size_t i = 0; i < line.size(); i++) {
+			if (line[i] == ',') {
+				commas.push_back(i);
+			}
+		}
+		if ((int)commas.size() != key_values + 2 + num_of_leap_settings) {
+			cout << terminal_red << "Line " << line_number << " of " << cache_file << " has " << commas.size() + 1 << " values instead of " << key_values + 3 + num_of_leap_settings << "!" << terminal_reset << endl;
+			exit(1);
+		}
+		leap_settings settings;
+		settings.appx = atoi(line.c_str() + commas[key_values - 1] + 1) != 0;
+		settings.hybrid = atoi(line.c_str() + commas[key_values] + 1) != 0;
+		settings.langevin = atoi(line.c_str() + commas[key_values + 1] + 1) != 0;
+		double values[num_of_leap_settings];
+		for (int l = 0; l < num_of_leap_settings; l++) {
+			values[l] = atof(line.c_str() + commas[key_values + 2 + l] + 1);
+		}
+		set_leap_settings(&settings, values);
+		(*cache)[line.substr(0, commas[key_values - 1])] = settings;
+	}
+}
+
+// append the given settings to the cache file under the given key
+static void store_cache (const char* cache_file, const string& key, const leap_settings& settings) {
+	ofstream file(cache_file, fstream::out | fstream::app);
+	if (!file) {
+		cout << terminal_red << "Couldn't open " << cache_file << "!" << terminal_reset << endl;
+		exit(1);
+	}
+	double values[num_of_leap_settings];
+	get_leap_settings(&settings, values);
+	file.precision(17);
+	file << key << "," << settings.appx << "," << settings.hybrid << "," << settings.langevin;
+	for (int l = 0; l < num_of_leap_settings; l++) {
+		file << "," << values[l];
+	}
+	file << endl;
+}
+
+/*
+Simulate the calibration runs of a condition with the given settings:
+the runs print nothing but their features, simulate at most autotune_minutes, and use the first autotune_runs random number streams,
+so every setting of a condition is calibrated with the same random numbers.
+Once the runs have taken longer than the given limit the setting can't be the fastest, so the rest are skipped and it takes infinite seconds.
+*/
+static calibration calibrate (sim_constants* sc, sim_state* ss, sim_condition* condition, const leap_settings& leaping, double limit) {
+	sim_condition trial = *condition;
+	trial.leaping = leaping;
+	run_features features[autotune_runs];
+	sim_constants cal = *sc;
+	cal.max_minutes = sc->max_minutes < autotune_minutes ? sc->max_minutes : autotune_minutes;
+	cal.print_runs = false;
+	cal.quiet = true;
+	cal.stats = NULL;
+	cal.features = features;
+	cal.runs = autotune_runs;
+	cal.num_conditions = 1;
+	cal.conditions = &trial;
+	cal.evaluate = false;
+
+	calibration c;
+	chrono::steady_clock::time_point start = chrono::steady_clock::now();
+	for (unsigned int j = 0; j < autotune_runs; j++) {
+		simulate_run(&cal, ss, j);
+		ss->writer.drain(); // the features are only complete once the output thread has processed every chunk
+		c.seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+		if (c.seconds > limit) {
+			c.seconds = INFINITY;
+			return c;
+		}
+	}
+	c.period = c.amplitude = c.syncscore = 0;
+	for (unsigned int j = 0; j < autotune_runs; j++) {
+		c.period += features[j].period / autotune_runs;
+		c.amplitude += features[j].amplitude / autotune_runs;
+		c.syncscore += features[j].syncscore / autotune_runs;
+	}
+	return c;
+}
+
+// whether or not a candidate's features are within the tolerance of the exact ones (a candidate whose runs didn't complete a period never is, since its period is NaN)
+static bool close_enough (const calibration& exact, const calibration& candidate) {
+	return fabs(candidate.period - exact.period) <= autotune_tolerance * exact.period
+	       && fabs(candidate.amplitude - exact.amplitude) <= autotune_tolerance * exact.amplitude
+	       && fabs(candidate.syncscore - exact.syncscore) <= autotune_tolerance;
+}
+
+/*
+Choose the leaping settings of a condition:
+1) Calibrate the exact next-reaction-method, whose features are the reference
+2) If the exact runs didn't oscillate then there's nothing to compare, so keep the condition's settings
+3) Otherwise, calibrate every candidate (hybrid simulation, chemical Langevin simulation, and every approximation) and keep the fastest one within the tolerance of the reference,
+   or the exact method if none is both faster and close enough
+*/
+static leap_settings tune_condition (sim_constants* sc, sim_state* ss, sim_condition* condition) {
+	leap_settings exact = condition->leaping;
+	exact.appx = false;
+	exact.hybrid = false;
+	exact.langevin = false;
+	calibration reference = calibrate(sc, ss, condition, exact, INFINITY);
+	if (!(reference.period > 0)) {
+		return condition->leaping;
+	}
+
+	vector<leap_settings> candidates;
+	leap_settings candidate = exact;
+	candidate.hybrid = true;
+	candidates.push_back(candidate);
+	candidate = exact;
+	candidate.langevin = true;
+	candidates.push_back(candidate);
+	for (unsigned int e = 0; e < sizeof(candidate_epsilons) / sizeof(double); e++) {
+		for (unsigned int t = 0; t < sizeof(candidate_tau1_mults) / sizeof(double); t++) {
+			candidate = exact;
+			candidate.appx = true;
+			candidate.epsilon = candidate_epsilons[e];
+			candidate.tau1_mult = candidate_tau1_mults[t];
+			candidates.push_back(candidate);
+		}
+	}
+
+	leap_settings best = exact;
+	double best_seconds = reference.seconds;
+	for (unsigned int c = 0; c < candidates.size(); c++) {
+		calibration cal = calibrate(sc, ss, condition, candidates[c], best_seconds);
+		if (cal.seconds < best_seconds && close_enough(reference, cal)) {
+			best = candidates[c];
+			best_seconds = cal.seconds;
+		}
+	}
+	return best;
+}
+
+// the loop of each autotuning worker thread, which takes the next untuned condition until there are none left
+static void autotune_worker (sim_constants* sc, vector<unsigned int>* untuned, atomic<unsigned int>* next, leap_settings* tuned) {
+	sim_state ss(sc->cells, sc->chunk, true, sc->seed);
+	for (unsigned int u = (*next)++; u < untuned->size(); u = (*next)++) {
+		sim_condition* condition = &sc->conditions[(*untuned)[u]];
+		tuned[u] = tune_condition(sc, &ss, condition);
+
+		cout_mutex.lock();
+		cout << terminal_blue << "Autotuned " << terminal_reset;
+		if (sc->num_conditions > 1) {
+			cout << "set #" << condition->set << " " << mutant_names[condition->mutant] << " ";
+		}
+		if (tuned[u].appx) {
+			cout << "(epsilon=" << tuned[u].epsilon << ", tau1_mult=" << tuned[u].tau1_mult << ") ... ";
+		} else if (tuned[u].hybrid) {
+			cout << "(hybrid) ... ";
+		} else if (tuned[u].langevin) {
+			cout << "(langevin) ... ";
+		} else {
+			cout << "(exact) ... ";
+		}
+		cout << terminal_done << endl;
+		cout_mutex.unlock();
+	}
+}
+
+/*
+Autotune the leaping settings of every condition:
+1) Load the settings cached by earlier autotuning, if the cache file exists
+2) Calibrate every condition whose key isn't cached on a pool of worker threads (conditions with the same key are calibrated once), appending its settings to the cache
+3) Give every condition its cached settings
+*/
+void autotune (sim_constants* sc, unsigned int threads, const char* cache_file) {
+	map<string, leap_settings> cache;
+	load_cache(cache_file, &cache);
+
+	vector<string> keys(sc->num_conditions);
+	vector<unsigned int> untuned; // the first condition of every key that isn't cached
+	map<string, bool> pending;
+	for (unsigned int c = 0; c < sc->num_conditions; c++) {
+		keys[c] = cache_key(sc, &sc->conditions[c]);
+		if (cache.count(keys[c]) == 0 && pending.count(keys[c]) == 0) {
+			pending[keys[c]] = true;
+			untuned.push_back(c);
+		}
+	}
+
+	if (untuned.size() > 0) {
+		if (threads > untuned.size()) {
+			threads = untuned.size();
+		}
+		vector<leap_settings> tuned(untuned.size());
+		atomic<unsigned int> next(0);
+		vector<thread> workers;
+		for (unsigned int w = 1; w < threads; w++) {
+			workers.push_back(thread(autotune_worker, sc, &untuned, &next, &tuned[0]));
+		}
+		autotune_worker(sc, &untuned, &next, &tuned[0]);
+		for (unsigned int w = 0; w < workers.size(); w++) {
+			workers[w].join();
+		}
+		for (unsigned int u = 0; u < untuned.size(); u++) {
+			cache[keys[untuned[u]]] = tuned[u];
+			store_cache(cache_file, keys[untuned[u]], tuned[u]);
+		}
+	}
+
+	for (unsigned int c = 0; c < sc->num_conditions; c++) {
+		sc->conditions[c].leaping = cache[keys[c]];
+	}
+}
+
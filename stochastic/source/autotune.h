@@ -0,0 +1,40 @@
+/*
+Stochastic simulator for zebrafish segmentation
+Copyright (C) 2012 Ahmet Ay, Jack Holland, Adriana Sperlea
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/*
+Autotuning (-d or --autotune) chooses the leaping settings (see leap-settings.h) of each condition before simulating it.
+It runs short calibration simulations of the condition with the exact next-reaction-method, hybrid simulation, chemical Langevin simulation, and a grid of approximate settings,
+and picks the fastest settings whose oscillation features (see features.h) stay within a tolerance of the exact ones.
+The chosen settings are cached in a file under the tissue size, the condition's parameters, the base settings, and the candidate grid and tolerance, so later simulations of the same condition skip calibrating.
+Candidates are ranked by how long their calibration runs take on this machine, so the chosen settings (and therefore the simulated results) can differ between machines,
+thread counts, and even repeated calibrations; reusing the cache file is what makes later simulations repeat the same choices.
+*/
+
+#ifndef AUTOTUNE_H
+#define AUTOTUNE_H
+
+#include "simulation.h"
+
+#define autotune_minutes 200 // the most minutes each calibration run simulates
+#define autotune_runs 2 // the number of calibration runs of each candidate setting
+#define autotune_tolerance 0.1 // how far the features of approximate settings can stray from the exact ones (relative for the period and amplitude, absolute for the synchronization score)
+
+void autotune(sim_constants*, unsigned int, const char*);
+
+#endif
+
@@ -0,0 +1,242 @@
+/*
+Stochastic simulator for zebrafish segmentation
+Copyright (C) 2012 Ahmet Ay, Jack Holland, Adriana Sperlea
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <fstream>
+#include <iostream>
+#include <new>
+#include <stdlib.h>
+#include <string>
+#include <string.h>
+#include <vector>
+
+#include "batch.h"
+#include "file-io.h"
+#include "macros.h"
+#include "parameters.h"
+
+using namespace std;
+
+// global variables set in main.cpp
+extern char* terminal_red;
+extern char* terminal_reset;
+
+const char* mutant_names[num_of_mutants] = {"wt", "delta", "her13", "her1", "her7", "her713"};
+
+// store the values of one line of a parameter file (in the input file's order) in a parameter set
+void store_parameters (double items[], parameters* p) {
+	p->psh1 = items[0];
+	p->psh7 = items[1];
+	p->psh13 = items[2];
+	p->psd = items[3];
+	p->pdh1 = items[4];
+	p->pdh7 = items[5];
+	p->pdh13 = items[6];
+	p->pdd = items[7];
+	p->msh1 = items[8];
+	p->msh7 = items[9];
+	p->msh13 = items[10];
+	p->msd = items[11];
+	p->mdh1 = items[12];
+	p->mdh7 = items[13];
+	p->mdh13 = items[14];
+	p->mdd = items[15];
+	p->ddgh1h1 = items[16];
+	p->ddgh1h7 = items[17];
+	p->ddgh1h13 = items[18];
+	p->ddgh7h7 = items[19];
+	p->ddgh7h13 = items[20];
+	p->ddgh13h13 = items[21];
+	p->delaymh1 = items[22];
+	p->delaymh7 = items[23];
+	p->delaymh13 = items[24];
+	p->delaymd = items[25];
+	p->delayph1 = items[26];
+	p->delayph7 = items[27];
+	p->delayph13 = items[28];
+	p->delaypd = items[29];
+	p->dah1h1 = items[30];
+	p->ddh1h1 = items[31];
+	p->dah1h7 = items[32];
+	p->ddh1h7 = items[33];
+	p->dah1h13 = items[34];
+	p->ddh1h13 = items[35];
+	p->dah7h7 = items[36];
+	p->ddh7h7 = items[37];
+	p->dah7h13 = items[38];
+	p->ddh7h13 = items[39];
+	p->dah13h13 = items[40];
+	p->ddh13h13 = items[41];
+	p->critph1h1 = items[42];
+	p->critph7h13 = items[43];
+	p->critpd = items[44];
+}
+
+// store the values of a parameter set in an array (in the input file's order), the reverse of store_parameters
+void parameter_values (parameters* p, double items[]) {
+	items[0] = p->psh1;
+	items[1] = p->psh7;
+	items[2] = p->psh13;
+	items[3] = p->psd;
+	items[4] = p->pdh1;
+	items[5] = p->pdh7;
+	items[6] = p->pdh13;
+	items[7] = p->pdd;
+	items[8] = p->msh1;
+	items[9] = p->msh7;
+	items[10] = p->msh13;
+	items[11] = p->msd;
+	items[12] = p->mdh1;
+	items[13] = p->mdh7;
+	items[14] = p->mdh13;
+	items[15] = p->mdd;
+	items[16] = p->ddgh1h1;
+	items[17] = p->ddgh1h7;
+	items[18] = p->ddgh1h13;
+	items[19] = p->ddgh7h7;
+	items[20] = p->ddgh7h13;
+	items[21] = p->ddgh13h13;
+	items[22] = p->delaymh1;
+	items[23] = p->delaymh7;
+	items[24] = p->delaymh13;
+	items[25] = p->delaymd;
+	items[26] = p->delayph1;
+	items[27] = p->delayph7;
+	items[28] = p->delayph13;
+	items[29] = p->delaypd;
+	items[30] = p->dah1h1;
+	items[31] = p->ddh1h1;
+	items[32] = p->dah1h7;
+	items[33] = p->ddh1h7;
+	items[34] = p->dah1h13;
+	items[35] = p->ddh1h13;
+	items[36] = p->dah7h7;
+	items[37] = p->ddh7h7;
+	items[38] = p->dah7h13;
+	items[39] = p->ddh7h13;
+	items[40] = p->dah13h13;
+	items[41] = p->ddh13h13;
+	items[42] = p->critph1h1;
+	items[43] = p->critph7h13;
+	items[44] = p->critpd;
+}
+
+// knock out the protein synthesis rates of the given mutant, as the deterministic simulator does
+void knockout (parameters* p, int mutant) {
+	if (mutant == mutant_delta) {
+		p->psd = 0;
+	} else if (mutant == mutant_her13) {
+		p->psh13 = 0;
+	} else if (mutant == mutant_her1) {
+		p->psh1 = 0;
+	} else if (mutant == mutant_her7) {
+		p->psh7 = 0;
+	} else if (mutant == mutant_her713) {
+		p->psh7 = 0;
+		p->psh13 = 0;
+	}
+}
+
+// set up the condition of the given parameter set and mutant
+void init_condition (sim_condition* condition, parameters* p, int set, int mutant) {
+	condition->pars = *p;
+	knockout(&condition->pars, mutant);
+	double delay_times[num_of_delayed_reactions] = {p->delayph1, p->delayph7, p->delayph13, p->delaypd, p->delaymh1, p->delaymh7, p->delaymd}; // in the order of delayed_reactions (see simulation.cpp)
+	for (int d = 0; d < num_of_delayed_reactions; d++) {
+		condition->delay_times[d] = delay_times[d];
+	}
+	condition->set = set;
+	condition->mutant = mutant;
+}
+
+// parse a comma-separated list of mutant names into their indices, returning how many there are or 0 if any name isn't a mutant
+int parse_mutants (const char* list, int mutants[]) {
+	int count = 0;
+	string names(list);
+	size_t start = 0;
+	while (start <= names.size()) {
+		size_t end = names.find(',', start);
+		if (end == string::npos) {
+			end = names.size();
+		}
+		string name = names.substr(start, end - start);
+		int m;
+		for (m = 0; m < num_of_mutants && name != mutant_names[m]; m++) {}
+		if (m == num_of_mutants || count == num_of_mutants) {
+			return 0;
+		}
+		mutants[count++] = m;
+		start = end + 1;
+	}
+	return count;
+}
+
+/*
+Parse a batch file into its conditions:
+1) Read every nonempty line of the file as a parameter set, which must have num_of_parameters comma-separated values like the input file
+2) Create a condition for every parameter set and every given mutant, ordered by set and then by mutant
+The conditions are allocated with new[] and the number of them is returned.
+*/
+int parse_batch (const char* filename, int mutants[], int num_mutants, sim_condition** conditions) {
+	ifstream file(filename);
+	if (!file) {
+		cout << terminal_red << "Couldn't open " << filename << "!" << terminal_reset << endl;
+		exit(1);
+	}
+
+	vector<parameters> sets;
+	string line;
+	int line_number = 0;
+	while (getline(file, line)) {
+		line_number++;
+		if (line.find_first_not_of(" \t\r") == string::npos) {
+			continue;
+		}
+		int values = 1;
+		for (unsigned int i = 0; i < line.size(); i++) {
+			values += line[i] == ',';
+		}
+		if (values != num_of_parameters) {
+			cout << terminal_red << "Line " << line_number << " of " << filename << " has " << values << " values instead of " << num_of_parameters << "!" << terminal_reset << endl;
+			exit(1);
+		}
+		double items[num_of_parameters];
+		int index = 0;
+		parse_line((char*)line.c_str(), items, &index);
+		parameters p;
+		store_parameters(items, &p);
+		sets.push_back(p);
+	}
+	if (sets.size() == 0) {
+		cout << terminal_red << filename << " doesn't have any parameter sets!" << terminal_reset << endl;
+		exit(1);
+	}
+
+	try {
+		*conditions = new sim_condition[sets.size() * num_mutants];
+	} catch (bad_alloc) { // if there isn't enough memory to allocate the conditions then exit the program
+		cout << terminal_no_memory << endl;
+		exit(1);
+	}
+	for (unsigned int s = 0; s < sets.size(); s++) {
+		for (int m = 0; m < num_mutants; m++) {
+			init_condition(&(*conditions)[s * num_mutants + m], &sets[s], s, mutants[m]);
+		}
+	}
+	return sets.size() * num_mutants;
+}
+
@@ -0,0 +1,61 @@
+/*
+Stochastic simulator for zebrafish segmentation
+Copyright (C) 2012 Ahmet Ay, Jack Holland, Adriana Sperlea
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/*
+Batch mode (-j or --batch) simulates every parameter set in a file for every mutant in one process, instead of one process per set and mutant.
+Each pair of a parameter set and a mutant is a sim_condition, and every run of every condition is scheduled on the same pool of workers (see simulation.h),
+so the workers' memory is allocated once for the whole batch. Batch mode prints only the oscillation features of each run (see features.h), all to one file.
+Mutants knock out the same protein synthesis rates as the deterministic simulator and seg-clock.
+*/
+
+#ifndef BATCH_H
+#define BATCH_H
+
+#include "leap-settings.h"
+#include "macros.h"
+#include "parameters.h"
+
+#define num_of_mutants 6 // the number of mutants batch mode can simulate (including the wild type)
+#define mutant_wt 0
+#define mutant_delta 1
+#define mutant_her13 2
+#define mutant_her1 3
+#define mutant_her7 4
+#define mutant_her713 5
+
+// the names of the mutants, as given to -u or --mutants and printed in the results (in the deterministic simulator's order)
+extern const char* mutant_names[num_of_mutants];
+
+// a parameter set with a mutant's knockouts applied
+struct sim_condition {
+	parameters pars; // the rates of the condition
+	double delay_times[num_of_delayed_reactions]; // the delay of each delayed reaction
+	int set; // the index of the parameter set (its line in the batch file, not counting empty lines)
+	int mutant; // the index of the mutant in mutant_names
+	leap_settings leaping; // how the condition's runs trade accuracy for speed (the same for every condition unless autotuned, see autotune.h)
+};
+
+void store_parameters(double[], parameters*);
+void parameter_values(parameters*, double[]);
+void knockout(parameters*, int);
+void init_condition(sim_condition*, parameters*, int, int);
+int parse_mutants(const char*, int[]);
+int parse_batch(const char*, int[], int, sim_condition**);
+
+#endif
+
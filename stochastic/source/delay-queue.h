@@ -0,0 +1,163 @@
+/*
+Stochastic simulator for zebrafish segmentation
+Copyright (C) 2012 Ahmet Ay, Jack Holland, Adriana Sperlea
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/*
+The delayed reaction queues used by the next-reaction-method and id-leaping.
+Each queue is a ring buffer of rq_nodes (see rq-node.h) whose capacity is a power of 2.
+Every queue of every cell starts as a slice of one slab allocated by its delay_arena, so pushing and popping never allocate memory
+(large tissues start every queue with fewer nodes so the slab stays a manageable size);
+a queue that runs out of room doubles its capacity with its own buffer, and keeps that buffer for the rest of the program.
+Clearing the arena between runs only resets the queues' lengths, so later runs reuse the memory earlier runs grew into.
+*/
+
+#ifndef DELAY_QUEUE_H
+#define DELAY_QUEUE_H
+
+#include <stdlib.h>
+
+#include "macros.h"
+#include "rq-node.h"
+
+struct delay_queue {
+	rq_node* nodes; // the ring buffer
+	int capacity; // the number of nodes the ring buffer can hold (always a power of 2)
+	int head; // the index in nodes of the front of the queue
+	int count; // the number of nodes in the queue
+	bool owned; // whether or not nodes was allocated by this queue (as opposed to being a slice of its arena's slab)
+	
+	delay_queue () {
+		this->nodes = NULL;
+		this->capacity = 0;
+		this->head = 0;
+		this->count = 0;
+		this->owned = false;
+	}
+	
+	~delay_queue () {
+		if (this->owned) {
+			delete[] this->nodes;
+		}
+	}
+	
+	bool empty () const {
+		return this->count == 0;
+	}
+	
+	int size () const {
+		return this->count;
+	}
+	
+	// the nth node from the front of the queue
+	rq_node& at (int n) {
+		return this->nodes[(this->head + n) & (this->capacity - 1)];
+	}
+	
+	rq_node& front () {
+		return this->nodes[this->head];
+	}
+	
+	rq_node& back () {
+		return this->at(this->count - 1);
+	}
+	
+	// add a node to the back of the queue (throws bad_alloc if the queue has to grow and there isn't enough memory)
+	void push_back (const rq_node& node) {
+		if (this->count == this->capacity) {
+			this->grow();
+		}
+		this->at(this->count) = node;
+		this->count++;
+	}
+	
+	void pop_front () {
+		this->head = (this->head + 1) & (this->capacity - 1);
+		this->count--;
+	}
+	
+	// keep only the first n nodes of the queue (used after the nodes to keep have been compacted to the front)
+	void truncate (int n) {
+		this->count = n;
+	}
+	
+	void clear () {
+		this->head = 0;
+		this->count = 0;
+	}
+	
+	// double the capacity of the ring buffer, moving the queue to the start of the new buffer
+	void grow () {
+		int new_capacity = this->capacity > 0 ? this->capacity * 2 : 1;
+		rq_node* new_nodes = new rq_node[new_capacity];
+		for (int n = 0; n < this->count; n++) {
+			new_nodes[n] = this->at(n);
+		}
+		if (this->owned) {
+			delete[] this->nodes;
+		}
+		this->nodes = new_nodes;
+		this->capacity = new_capacity;
+		this->head = 0;
+		this->owned = true;
+	}
+};
+
+struct delay_arena {
+	int cells; // the number of cells with queues
+	rq_node* slab; // the memory every queue starts with
+	delay_queue* queues; // the queues, num_of_delayed_reactions per cell
+	
+	// capacity must be a power of 2
+	delay_arena (int cells, int capacity) {
+		this->cells = cells;
+		this->slab = new rq_node[cells * num_of_delayed_reactions * capacity];
+		this->queues = new delay_queue[cells * num_of_delayed_reactions];
+		for (int q = 0; q < cells * num_of_delayed_reactions; q++) {
+			this->queues[q].nodes = this->slab + q * capacity;
+			this->queues[q].capacity = capacity;
+		}
+	}
+	
+	~delay_arena () {
+		delete[] this->queues;
+		delete[] this->slab;
+	}
+	
+	// the capacity every queue should start with in a tissue of the given size, so the slab never starts with more than delay_arena_nodes nodes
+	static int initial_capacity (int cells) {
+		int capacity = delay_queue_capacity;
+		while (capacity > 1 && cells * num_of_delayed_reactions * capacity > delay_arena_nodes) {
+			capacity /= 2;
+		}
+		return capacity;
+	}
+	
+	// the cell's queues, indexed by delayed reaction index (so arena[cell][d] is a single queue)
+	delay_queue* operator[] (int cell) {
+		return this->queues + cell * num_of_delayed_reactions;
+	}
+	
+	// empty every queue, keeping their memory for the next run
+	void clear () {
+		for (int q = 0; q < this->cells * num_of_delayed_reactions; q++) {
+			this->queues[q].clear();
+		}
+	}
+};
+
+#endif
+
@@ -0,0 +1,130 @@
+/*
+Stochastic simulator for zebrafish segmentation
+Copyright (C) 2012 Ahmet Ay, Jack Holland, Adriana Sperlea
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/*
+The reaction dependency graph used by the next-reaction-method.
+A propensity group is one of the update_a* functions in updates.h, which recalculates every propensity that reads a given species.
+An event is either a non-delayed reaction firing (event k for reaction k, which for a delayed reaction means it is starting and changes no species)
+or a delayed reaction finishing (event reactions + d for the dth delayed reaction).
+For each event the graph stores which propensity groups must be recalculated in the active cell and in its neighbors (only Delta protein is read by neighbors),
+and which propensities those groups change, so only those reactions' Tk values and heap entries have to be touched.
+Every list below stores its length as its first value, like species_update_indices in main.cpp.
+*/
+
+#ifndef DEPENDENCIES_H
+#define DEPENDENCIES_H
+
+#include "macros.h"
+
+#define num_of_propensity_groups 15 // the number of update_a* functions in updates.h
+#define num_of_events (reactions + num_of_delayed_reactions) // non-delayed firings followed by delayed finishings
+
+// the propensity groups (each index corresponds to an update_a* function in updates.h)
+#define group_a0_27			0
+#define group_a1_2_4_6		1
+#define group_a3_18			2
+#define group_a4_9_10_12	3
+#define group_a5_19			4
+#define group_a6_12_15_16	5
+#define group_a7_20			6
+#define group_a8_29			7
+#define group_a11_21		8
+#define group_a13_22		9
+#define group_a14_31		10
+#define group_a17_23		11
+#define group_a24_33		12
+#define group_a25			13
+#define group_a26_28_32		14
+
+// the propensities each group recalculates
+const int group_propensities[num_of_propensity_groups][5] = {{2, 0, 27}, {4, 1, 2, 4, 6}, {2, 3, 18}, {4, 4, 9, 10, 12}, {2, 5, 19}, {4, 6, 12, 15, 16}, {2, 7, 20}, {2, 8, 29}, {2, 11, 21}, {2, 13, 22}, {2, 14, 31}, {2, 17, 23}, {2, 24, 33}, {1, 25}, {3, 26, 28, 32}};
+
+// the groups to recalculate in a cell when one of its species changes
+const int species_groups[species][3] = {{1, group_a0_27}, {1, group_a8_29}, {1, group_a14_31}, {1, group_a24_33}, {1, group_a1_2_4_6}, {1, group_a4_9_10_12}, {1, group_a6_12_15_16}, {1, group_a25}, {2, group_a3_18, group_a26_28_32}, {1, group_a5_19}, {1, group_a7_20}, {1, group_a11_21}, {2, group_a13_22, group_a26_28_32}, {1, group_a17_23}};
+
+// the groups to recalculate in each neighbor of a cell when one of its species changes (transcription reads the neighbors' Delta protein)
+const int species_groups_neighbor[species][2] = {{0}, {0}, {0}, {0}, {0}, {0}, {0}, {1, group_a26_28_32}, {0}, {0}, {0}, {0}, {0}, {0}};
+
+struct dependency_graph {
+	int local_groups[num_of_events][num_of_propensity_groups + 1]; // the groups to recalculate in the active cell
+	int neighbor_groups[num_of_events][num_of_propensity_groups + 1]; // the groups to recalculate in each of the active cell's neighbors
+	int local_propensities[num_of_events][reactions + 1]; // the propensities the local groups change
+	int neighbor_propensities[num_of_events][reactions + 1]; // the propensities the neighbor groups change
+	int delayed_index[reactions]; // the delayed reaction index of each reaction, or -1 if the reaction isn't delayed
+
+	dependency_graph (const int delayed_reactions[], const int species_update_indices[][4], const int species_update_indices_delayed[]) {
+		for (int k = 0; k < reactions; k++) {
+			this->delayed_index[k] = -1;
+		}
+		for (int d = 0; d < num_of_delayed_reactions; d++) {
+			this->delayed_index[delayed_reactions[d]] = d;
+		}
+
+		for (int e = 0; e < num_of_events; e++) {
+			this->local_groups[e][0] = 0;
+			this->neighbor_groups[e][0] = 0;
+			if (e < reactions) {
+				if (this->delayed_index[e] == -1) { // a delayed reaction that is starting doesn't change any species
+					for (int s = 1; s <= species_update_indices[e][0]; s++) {
+						this->add_species(e, species_update_indices[e][s]);
+					}
+				}
+			} else {
+				this->add_species(e, species_update_indices_delayed[e - reactions]);
+			}
+			this->fill_propensities(this->local_groups[e], this->local_propensities[e]);
+			this->fill_propensities(this->neighbor_groups[e], this->neighbor_propensities[e]);
+		}
+	}
+
+	~dependency_graph () {}
+
+	// add the groups that read species j to event e's lists
+	void add_species (int e, int j) {
+		for (int g = 1; g <= species_groups[j][0]; g++) {
+			add_unique(this->local_groups[e], species_groups[j][g]);
+		}
+		for (int g = 1; g <= species_groups_neighbor[j][0]; g++) {
+			add_unique(this->neighbor_groups[e], species_groups_neighbor[j][g]);
+		}
+	}
+
+	// store every propensity the given groups change
+	static void fill_propensities (const int groups[], int propensities[]) {
+		propensities[0] = 0;
+		for (int g = 1; g <= groups[0]; g++) {
+			const int* gp = group_propensities[groups[g]];
+			for (int p = 1; p <= gp[0]; p++) {
+				add_unique(propensities, gp[p]);
+			}
+		}
+	}
+
+	// add value to a length-prefixed list if it isn't already in it
+	static void add_unique (int list[], int value) {
+		for (int i = 1; i <= list[0]; i++) {
+			if (list[i] == value) {
+				return;
+			}
+		}
+		list[++list[0]] = value;
+	}
+};
+
+#endif
+
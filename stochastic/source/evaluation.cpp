@@ -0,0 +1,183 @@
+/*
+Stochastic simulator for zebrafish segmentation
+Copyright (C) 2012 Ahmet Ay, Jack Holland, Adriana Sperlea
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <math.h>
+
+#include "batch.h"
+#include "evaluation.h"
+#include "features.h"
+#include "macros.h"
+
+#define beta_iterations 200 // the most terms of the incomplete beta function's continued fraction that are evaluated
+#define beta_epsilon 1e-12 // the relative change below which the continued fraction has converged
+#define beta_tiny 1e-300 // what near-zero denominators of the continued fraction are replaced with
+
+const double mutant_period_ratios[num_of_mutants][2] = {{-INFINITY, INFINITY}, // wt
+                                                        {1.04, 1.30}, // delta (fd_mutant)
+                                                        {1.03, 1.09}, // her13 (f13_mutant)
+                                                        {0.97, 1.03}, // her1 (f1_mutant)
+                                                        {0.97, 1.03}, // her7 (f7_mutant)
+                                                        {1.03, 1.09}}; // her713 (f713_mutant)
+
+// the regularized incomplete beta function I_x(a, b), evaluated with its continued fraction by Lentz's method (as in Numerical Recipes' betai)
+static double incomplete_beta (double x, double a, double b) {
+	if (x <= 0) {
+		return 0;
+	}
+	if (x >= 1) {
+		return 1;
+	}
+	if (x > (a + 1) / (a + b + 2)) { // the continued fraction converges quickly only below this, so use the symmetry of the function above it
+		return 1 - incomplete_beta(1 - x, b, a);
+	}
+	double front = exp(lgamma(a + b) - lgamma(a) - lgamma(b) + a * log(x) + b * log(1 - x)) / a;
+	double c = 1;
+	double d = 1 - (a + b) * x / (a + 1);
+	d = 1 / (fabs(d) < beta_tiny ? beta_tiny : d);
+	double fraction = d;
+	for (int m = 1; m <= beta_iterations; m++) {
+		for (int step = 0; step < 2; step++) {
+			double numerator = step == 0 ? m * (b - m) * x / ((a + 2 * m - 1) * (a + 2 * m)) : -(a + m) * (a + b + m) * x / ((a + 2 * m) * (a + 2 * m + 1));
+			d = 1 + numerator * d;
+			d = 1 / (fabs(d) < beta_tiny ? beta_tiny : d);
+			c = 1 + numerator / c;
+			c = fabs(c) < beta_tiny ? beta_tiny : c;
+			fraction *= c * d;
+		}
+		if (fabs(c * d - 1) < beta_epsilon) {
+			break;
+		}
+	}
+	return front * fraction;
+}
+
+/*
+The two-sided critical value of Student's t distribution with the given (possibly fractional) degrees of freedom at the given significance level,
+i.e. the t for which P(|T| > t) = alpha, found by bisecting P(|T| > t) = I_x(df / 2, 1 / 2) with x = df / (df + t^2) between 0 and 1.
+*/
+static double t_critical (double alpha, double df) {
+	double low = 0;
+	double high = 1;
+	for (int i = 0; i < 100; i++) {
+		double x = (low + high) / 2;
+		if (incomplete_beta(x, df / 2, 0.5) < alpha) {
+			low = x;
+		} else {
+			high = x;
+		}
+	}
+	double x = (low + high) / 2;
+	return sqrt(df * (1 - x) / x);
+}
+
+// whether an estimate with a confidence interval of the given half width is inside the bounds, outside them, or straddling either one
+static int compare_interval (double estimate, double half, double low, double high) {
+	if (low < estimate - half && estimate + half < high) {
+		return test_pass;
+	}
+	if (estimate + half <= low || estimate - half >= high) {
+		return test_fail;
+	}
+	return test_undecided;
+}
+
+// add the value of the next run
+void sequential_test::add (double value) {
+	if (isnan(value)) {
+		this->invalid = true;
+		return;
+	}
+	this->n++;
+	double deviation = value - this->mean;
+	this->mean += deviation / this->n;
+	this->squares += deviation * (value - this->mean);
+}
+
+/*
+Decide the test with the values so far:
+1) Fail if any value was NaN
+2) If this is the last run then pass if and only if the mean is within the bounds
+3) Otherwise pass if the mean's confidence interval is within the bounds, fail if it is entirely outside them, and leave the test undecided if it straddles either bound
+looks is how many times the test can be decided before the last run, between which sequential_alpha is split.
+*/
+int sequential_test::decide (bool last, int looks) {
+	if (this->invalid) {
+		return test_fail;
+	}
+	if (last) {
+		return (this->low < this->mean && this->mean < this->high) ? test_pass : test_fail;
+	}
+	if (this->n < min_sequential_runs) {
+		return test_undecided;
+	}
+	double half = t_critical(sequential_alpha / looks, this->n - 1) * sqrt(this->squares / (this->n - 1) / this->n);
+	return compare_interval(this->mean, half, this->low, this->high);
+}
+
+/*
+Decide whether the ratio of the mean to base's mean is within the bounds, like decide but with both means uncertain:
+the ratio's relative variance is the sum of the two means' relative variances (the delta method), with Welch's degrees of freedom for their sum.
+A base with a single value (only possible when there is one run) adds no variance.
+*/
+int sequential_test::decide_ratio (const sequential_test& base, bool last, int looks) {
+	if (this->invalid || base.invalid) {
+		return test_fail;
+	}
+	double ratio = this->mean / base.mean;
+	if (last) {
+		return (this->low < ratio && ratio < this->high) ? test_pass : test_fail;
+	}
+	if (this->n < min_sequential_runs) {
+		return test_undecided;
+	}
+	double own = this->squares / (this->n - 1) / this->n / (this->mean * this->mean);
+	double other = base.n > 1 ? base.squares / (base.n - 1) / base.n / (base.mean * base.mean) : 0;
+	double df = (own + other) * (own + other) / (own * own / (this->n - 1) + (base.n > 1 ? other * other / (base.n - 1) : 0));
+	if (!(df >= 1)) { // neither mean varies (0 / 0), so the interval is empty whatever the degrees of freedom
+		df = 1;
+	}
+	double half = t_critical(sequential_alpha / looks, df) * fabs(ratio) * sqrt(own + other);
+	return compare_interval(ratio, half, this->low, this->high);
+}
+
+/*
+Decide a condition with the features of its runs so far:
+1) Test the synchronization score of the wild type and delta mutant and the period of the wild type or the ratio of the mutant's mean period to the wild type's
+2) Fail if any test fails, pass if every test passes, and otherwise leave the condition undecided so another run is simulated
+mutant is the condition's mutant, features are its runs' features, count is how many runs there are, wt_period is the test of the wild type's periods (ignored for the wild type),
+and runs is how many runs the condition can have.
+*/
+int decide_condition (int mutant, run_features* features, int count, const sequential_test& wt_period, int runs) {
+	bool last = count == runs;
+	int looks = runs - min_sequential_runs > 1 ? runs - min_sequential_runs : 1; // a test can be decided early after every run from min_sequential_runs to the one before the last
+	sequential_test sync(mutant == mutant_wt ? sync_wildtype : -INFINITY, mutant == mutant_delta ? sync_delta : INFINITY);
+	sequential_test period(mutant_period_ratios[mutant][0], mutant_period_ratios[mutant][1]);
+	for (int r = 0; r < count; r++) {
+		sync.add(features[r].syncscore);
+		period.add(features[r].period);
+	}
+	int sync_result = (mutant == mutant_wt || mutant == mutant_delta) ? sync.decide(last, looks) : test_pass;
+	int period_result = mutant == mutant_wt ? period.decide(last, looks) : period.decide_ratio(wt_period, last, looks);
+	if (sync_result == test_fail || period_result == test_fail) {
+		return test_fail;
+	}
+	if (sync_result == test_pass && period_result == test_pass) {
+		return test_pass;
+	}
+	return test_undecided;
+}
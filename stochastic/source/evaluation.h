@@ -0,0 +1,91 @@
+/*
+Stochastic simulator for zebrafish segmentation
+Copyright (C) 2012 Ahmet Ay, Jack Holland, Adriana Sperlea
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/*
+Evaluating parameter sets in batch mode (-v or --evaluate with -j or --batch), which is what seg-clock -F does but without simulating doomed sets to the end:
+every set's conditions are simulated in the deterministic simulator's order (wild type, delta, her13, her1, her7, her713), and the set stops at the first condition that fails.
+A condition passes if the means of its runs' features meet seg-clock's criteria: the wild type's cells must be synchronized, the delta mutant's cells must not be,
+and every mutant's mean period must be within the deterministic simulator's range of ratios to the wild type's mean period.
+Each mean is tested sequentially: after every run (from the second on) a confidence interval of the mean is compared with the criterion,
+and the condition is decided as soon as every interval is inside its range or any is outside it, so no more runs are simulated than needed.
+Since a test looks at its interval after every run, the 1% chance of an early decision being wrong is split between all of its looks (Bonferroni),
+and the interval of a period ratio includes the uncertainty of the wild type's mean period as well as the mutant's (by the delta method),
+since the wild type is often decided on its synchronization after only a few runs.
+Only the last run (-r or --runs) decides on the means alone, as seg-clock does; before a mutant's last run the wild type's remaining runs are simulated,
+so its mean period is over every run and the wild type must pass on the means of all of them too.
+*/
+
+#ifndef EVALUATION_H
+#define EVALUATION_H
+
+#include "batch.h"
+#include "features.h"
+#include "macros.h"
+
+#define min_sequential_runs 2 // the fewest runs a condition can be decided on before its last one
+#define sequential_alpha 0.01 // the chance of a test deciding wrongly before the last run, over all of its looks
+#define sync_wildtype 0.8 // the wild type's mean synchronization score must be above this (as in seg-clock)
+#define sync_delta 0.7 // the delta mutant's mean synchronization score must be below this (as in seg-clock)
+
+#define test_undecided 0
+#define test_pass 1
+#define test_fail 2
+
+// a test of whether the mean of a statistic over a condition's runs is strictly between two bounds (either of which can be infinite)
+struct sequential_test {
+	double low; // the lower bound
+	double high; // the upper bound
+	int n; // the number of values so far
+	double mean; // the mean of the values so far
+	double squares; // the sum of the squared deviations of the values from their mean
+	bool invalid; // whether or not any value was NaN (i.e. a run had no full period), which fails the test
+
+	sequential_test (double low, double high) {
+		this->low = low;
+		this->high = high;
+		this->n = 0;
+		this->mean = 0;
+		this->squares = 0;
+		this->invalid = false;
+	}
+
+	void add(double);
+	int decide(bool, int);
+	int decide_ratio(const sequential_test&, bool, int);
+};
+
+// the outcome of evaluating a parameter set
+struct set_evaluation {
+	bool passed; // whether or not every condition passed
+	int failed; // the mutant of the condition that failed, -1 if none did
+	int jobs; // the number of runs simulated for the set
+
+	set_evaluation () {
+		this->passed = false;
+		this->failed = -1;
+		this->jobs = 0;
+	}
+};
+
+// the range of each mutant's period as a ratio to the wild type's (from the deterministic simulator's f*_mutant functions)
+extern const double mutant_period_ratios[num_of_mutants][2];
+
+int decide_condition(int, run_features*, int, const sequential_test&, int);
+
+#endif
+
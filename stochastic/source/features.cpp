@@ -0,0 +1,260 @@
+/*
+Stochastic simulator for zebrafish segmentation
+Copyright (C) 2012 Ahmet Ay, Jack Holland, Adriana Sperlea
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <iostream>
+#include <math.h>
+#include <new>
+#include <stdlib.h>
+#include <vector>
+
+#include "features.h"
+#include "macros.h"
+#include "main.h"
+
+using namespace std;
+
+// global variables set in main.cpp
+extern char* terminal_red;
+extern char* terminal_reset;
+
+#define history_index(i) ((i) & (features_history - 1)) // the ring buffer position of timestep i
+
+feature_extractor::feature_extractor (int cells) {
+	this->cells = cells;
+	try {
+		this->raw = new double[cells * features_history];
+		this->smooth = new double[cells * features_history];
+		this->sums = new double[cells];
+		this->extremes = new cell_extremes[cells];
+		this->means = new double[cells];
+		this->squares = new double[cells];
+		this->products = new double[cells];
+	} catch (bad_alloc) { // if there isn't enough memory to allocate the structures then exit the program
+		cout << terminal_no_memory << endl;
+		exit(1);
+	}
+	this->reset();
+}
+
+feature_extractor::~feature_extractor () {
+	delete[] this->raw;
+	delete[] this->smooth;
+	delete[] this->sums;
+	delete[] this->extremes;
+	delete[] this->means;
+	delete[] this->squares;
+	delete[] this->products;
+}
+
+// forget the current run so the next one can be given
+void feature_extractor::reset () {
+	this->samples = 0;
+	this->smoothed = 0;
+	this->next = 0;
+	this->searching = false;
+	for (int n = 0; n < this->cells; n++) {
+		this->sums[n] = 0;
+		this->extremes[n].clear();
+		this->means[n] = 0;
+		this->squares[n] = 0;
+		this->products[n] = 0;
+	}
+}
+
+/*
+Add a printed timestep:
+1) Store every cell's concentration of the printed level (x is the timestep's concentrations, stored like the rows of sim_state's chunks)
+2) Update the running means and deviations used by the synchronization score
+3) Smooth the timestep half an interval back, which is the first one whose whole interval is now known
+4) Search every smoothed timestep whose whole window is now known for peaks and troughs
+*/
+void feature_extractor::add (double time, int* x, int con_level) {
+	long i = this->samples++;
+	int h = history_index(i);
+	this->times[h] = time;
+	for (int n = 0; n < this->cells; n++) {
+		double value = x[n * species + con_level];
+		this->raw[n * features_history + h] = value;
+		this->sums[n] += value;
+		if (i >= smoothing_interval) {
+			this->sums[n] -= this->raw[n * features_history + history_index(i - smoothing_interval)];
+		}
+	}
+
+	// update the means and deviations one timestep at a time (Welford's method), which is as accurate as two passes over the whole run
+	double first_deviation = x[con_level] - this->means[0];
+	for (int n = 0; n < this->cells; n++) {
+		double value = x[n * species + con_level];
+		double deviation = value - this->means[n];
+		this->means[n] += deviation / this->samples;
+		this->squares[n] += deviation * (value - this->means[n]);
+		this->products[n] += first_deviation * (value - this->means[n]);
+	}
+
+	// analysis/smoothing averages over fewer timesteps at the start of a run (dividing the first average by one less than it sums)
+	const int half = smoothing_interval / 2;
+	if (i < half) {
+		return;
+	}
+	double divisor = i == half ? half : (i < smoothing_interval ? i + 1 : smoothing_interval);
+	int s = history_index(i - half);
+	for (int n = 0; n < this->cells; n++) {
+		this->smooth[n * features_history + s] = this->sums[n] / divisor;
+	}
+	this->smoothed++;
+
+	// the search starts at features_start unless the run turns out to be short, which isn't known until it has more than features_short smoothed timesteps
+	if (!this->searching && this->smoothed > features_short) {
+		this->searching = true;
+		this->next = features_start;
+	}
+	if (this->searching) {
+		for (; this->next + features_window + 2 <= this->smoothed; this->next++) {
+			this->search(this->next, this->smoothed);
+		}
+	}
+}
+
+/*
+Check whether the given smoothed timestep is a peak or a trough of any cell, with the rules of analysis/ofeatures:
+1) A peak (trough) is a local maximum (minimum) of the smoothed concentrations more than features_spacing minutes after the cell's last one
+   that is also the highest (lowest) smoothed concentration within features_window timesteps on either side
+2) The value of a peak is the highest unsmoothed concentration among the 5 timesteps before it, then updated with each of the 5 timesteps after it
+   whose smoothed concentration exceeds the value so far (just as analysis/ofeatures does), and the value of a trough is the lowest unsmoothed concentration within features_window timesteps on either side
+count is the number of smoothed timesteps so far, and timesteps after count - 2 aren't compared, as in analysis/ofeatures.
+*/
+void feature_extractor::search (long t, long count) {
+	long last = count - 2;
+	double time = this->times[history_index(t)];
+	for (int n = 0; n < this->cells; n++) {
+		double* s = this->smooth + n * features_history;
+		double* r = this->raw + n * features_history;
+		cell_extremes& e = this->extremes[n];
+		double before = s[history_index(t - 1)];
+		double current = s[history_index(t)];
+		double after = s[history_index(t + 1)];
+
+		if ((after <= current && current > before) || (after < current && current >= before)) {
+			if (e.peaks.empty() || fabs(time - e.last_peak) > features_spacing) {
+				double maxval = 0;
+				bool ispeak = true;
+				for (long j = t - 1; j >= 0 && j >= t - 5; j--) {
+					if (r[history_index(j)] > maxval) {
+						maxval = r[history_index(j)];
+					}
+				}
+				for (long j = t - 1; j >= 0 && j >= t - features_window; j--) {
+					if (s[history_index(j)] > current) {
+						ispeak = false;
+					}
+				}
+				for (long j = t + 1; j <= last && j <= t + 5; j++) {
+					if (s[history_index(j)] > maxval) {
+						maxval = r[history_index(j)];
+					}
+				}
+				for (long j = t + 1; j <= last && j <= t + features_window; j++) {
+					if (s[history_index(j)] > current) {
+						ispeak = false;
+					}
+				}
+				if (ispeak) {
+					e.peaks.push_back(maxval);
+					e.last_peak = time;
+				}
+			}
+		}
+
+		if ((after >= current && current < before) || (after > current && current <= before)) {
+			if (e.trough_times.empty() || fabs(time - e.trough_times.back()) > features_spacing) {
+				double minval = 99999999;
+				bool istrough = true;
+				for (long j = t - 1; j >= 0 && j >= t - features_window; j--) {
+					if (r[history_index(j)] < minval) {
+						minval = r[history_index(j)];
+					}
+					if (s[history_index(j)] < current) {
+						istrough = false;
+					}
+				}
+				for (long j = t + 1; j <= last && j <= t + features_window; j++) {
+					if (r[history_index(j)] < minval) {
+						minval = r[history_index(j)];
+					}
+					if (s[history_index(j)] < current) {
+						istrough = false;
+					}
+				}
+				if (istrough) {
+					e.troughs.push_back(minval);
+					e.trough_times.push_back(time);
+				}
+			}
+		}
+	}
+}
+
+/*
+Finish the run and store its features:
+1) Search the smoothed timesteps that are left, whose windows are cut off by the end of the run
+2) Pair every two consecutive troughs of a cell with the cell's next peak and average the resulting periods, amplitudes, and peak to trough ratios over every cell
+3) Average the correlation between the first cell and every other cell (a cell whose concentration never changes counts as perfectly correlated)
+4) Reset the extractor for the next run
+*/
+void feature_extractor::finish (run_features* features) {
+	if (!this->searching) {
+		this->searching = true;
+		this->next = 1;
+	}
+	for (; this->next < this->smoothed - 1; this->next++) {
+		this->search(this->next, this->smoothed);
+	}
+
+	double period = 0, amplitude = 0, peak_to_trough = 0;
+	int periods = 0;
+	for (int n = 0; n < this->cells; n++) {
+		cell_extremes& e = this->extremes[n];
+		for (unsigned int p = 0; p < e.peaks.size() && p + 1 < e.troughs.size(); p++) {
+			period += e.trough_times[p + 1] - e.trough_times[p];
+			double trough = (e.troughs[p] + e.troughs[p + 1]) / 2;
+			if (trough < 1.0) {
+				trough = 1.0;
+			}
+			peak_to_trough += e.peaks[p] / trough;
+			amplitude += e.peaks[p] - trough;
+			periods++;
+		}
+	}
+	features->period = period / periods; // NaN if no cell had a full period, like analysis/ofeatures
+	features->amplitude = amplitude / periods;
+	features->peak_to_trough = peak_to_trough / periods;
+
+	double score = 0;
+	for (int n = 1; n < this->cells; n++) {
+		if (this->squares[0] == 0 || this->squares[n] == 0) {
+			score += 1;
+		} else {
+			score += this->products[n] / sqrt(this->squares[0] * this->squares[n]);
+		}
+	}
+	features->syncscore = this->cells > 1 ? score / (this->cells - 1) : 1;
+	features->simulated = true;
+
+	this->reset();
+}
+
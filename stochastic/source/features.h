@@ -0,0 +1,99 @@
+/*
+Stochastic simulator for zebrafish segmentation
+Copyright (C) 2012 Ahmet Ay, Jack Holland, Adriana Sperlea
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/*
+The oscillation features of a run, computed while the run is printed (-f or --ofeatures) instead of by rereading its run file.
+A feature_extractor is given each printed timestep in order and does what seg-clock's analysis steps do to a run file:
+1) Smooth every cell's concentrations with the same moving average as analysis/smoothing (with seg-clock's interval of 40 timesteps)
+2) Find peaks and troughs with the same rules as analysis/ofeatures (starting at seg-clock's timestep 100), and from them the period, amplitude, and peak to trough ratio
+3) Score how synchronized the cells are like analysis/synchronized.py, i.e. the mean correlation between the first cell and every other cell
+Only the last features_history timesteps are kept, since the peak and trough rules only look 50 timesteps around each candidate.
+*/
+
+#ifndef FEATURES_H
+#define FEATURES_H
+
+#include <vector>
+
+#include "macros.h"
+
+using namespace std;
+
+#define smoothing_interval 40 // the number of timesteps each smoothed value averages (seg-clock passes 40 to analysis/smoothing)
+#define features_start 100 // the first smoothed timestep searched for peaks and troughs (seg-clock passes 100 to analysis/ofeatures)
+#define features_short 300 // runs with this many smoothed timesteps or fewer are searched from timestep 1 instead
+#define features_window 50 // a peak (trough) must be the highest (lowest) smoothed value this many timesteps before and after it
+#define features_spacing 10 // the minimum number of minutes between two peaks (troughs) of a cell
+#define features_history 512 // the number of timesteps kept per cell (a power of 2 greater than features_short + smoothing_interval / 2 - features_start + features_window)
+
+// the oscillation features of one run, averaged over every cell
+struct run_features {
+	double period; // the mean time between consecutive troughs
+	double amplitude; // the mean height of a peak above its neighboring troughs
+	double peak_to_trough; // the mean ratio of a peak to its neighboring troughs
+	double syncscore; // the mean correlation between the first cell and every other cell, from -1 to 1
+	bool simulated; // whether or not the run was simulated (evaluating parameter sets can skip runs, see evaluation.h)
+
+	run_features () {
+		this->period = 0;
+		this->amplitude = 0;
+		this->peak_to_trough = 0;
+		this->syncscore = 0;
+		this->simulated = false;
+	}
+};
+
+// the peaks and troughs found so far in one cell
+struct cell_extremes {
+	vector<double> peaks; // the unsmoothed concentration of each peak
+	vector<double> troughs; // the unsmoothed concentration of each trough
+	vector<double> trough_times; // the time of each trough
+	double last_peak; // the time of the last peak (only valid if peaks isn't empty)
+
+	void clear () {
+		this->peaks.clear();
+		this->troughs.clear();
+		this->trough_times.clear();
+	}
+};
+
+struct feature_extractor {
+	int cells; // the number of cells
+	double* raw; // the last features_history unsmoothed concentrations of each cell (cell n's start at n * features_history)
+	double* smooth; // the last features_history smoothed concentrations of each cell
+	double times[features_history]; // the last features_history times
+	double* sums; // the sum of each cell's last smoothing_interval unsmoothed concentrations
+	long samples; // the number of timesteps given so far
+	long smoothed; // the number of smoothed timesteps so far
+	long next; // the next smoothed timestep to search for peaks and troughs
+	bool searching; // whether or not it's known which timestep the search starts at
+	cell_extremes* extremes; // the peaks and troughs of each cell
+	double* means; // the mean concentration of each cell
+	double* squares; // the sum of the squared deviations from the mean of each cell
+	double* products; // the sum of the products of the first cell's and each cell's deviations from their means
+
+	feature_extractor (int cells);
+	~feature_extractor ();
+	void add(double, int*, int);
+	void finish(run_features*);
+	void search(long, long);
+	void reset();
+};
+
+#endif
+
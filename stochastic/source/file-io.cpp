@@ -18,32 +18,216 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
 #include "file-io.h"
 
+#include <chrono>
 #include <fstream>
+#include <new>
+#include <sstream>
+#include <stdint.h>
 #include <stdlib.h>
+#include <string>
 #include <string.h>
 
+#include "batch.h"
+#include "evaluation.h"
+#include "features.h"
+#include "leap-settings.h"
 #include "macros.h"
 #include "main.h"
+#include "run-file.h"
+#include "run-stats.h"
 
 // global variables set in main.cpp
 extern char* terminal_blue;
 extern char* terminal_red;
 extern char* terminal_reset;
 
-// store the her1 values of the simulation up to the chunk index specified by chunk
-void store_results (ofstream* file, int** x, double* T, int cells, int chunk, int run, int con_level) {
+// store the header of a run's output file: the tissue size for text files, or a run_file_header for binary ones (see run-file.h)
+void store_header (ofstream* file, int width, int height, int con_level, double granularity, bool binary, int run) {
 	try {
-		for (int sn = 1; sn < chunk; sn++) {
-			*file << T[sn] << "\t";
-			for (int i = 0; i < cells; i++) {
-				*file << x[sn][i * species + con_level] << "\t";
+		if (binary) {
+			run_file_header header(width, height, con_level, granularity);
+			file->write((char*)&header, sizeof(header));
+		} else {
+			*file << width << " " << height << "\n";
+		}
+	} catch (ofstream::failure) { // if there was a problem writing the header then exit the program
+		cout << terminal_red << "Couldn't write to run #" << run << "'s output file!" << terminal_reset << endl;
+		exit(1);
+	}
+}
+
+/*
+Store the chosen concentration level of the simulation up to the chunk index specified by chunk:
+The whole chunk is formatted (or packed, for binary files) into one buffer first and then written at once,
+so printing a chunk takes a few large writes instead of a flush for every timestep.
+*/
+void store_results (ofstream* file, int** x, double* T, int cells, int chunk, int run, int con_level, bool binary) {
+	try {
+		if (binary) {
+			long record_size = run_record_size(cells);
+			char* buffer = new char[record_size * (chunk > 1 ? chunk - 1 : 0) + 1];
+			char* record = buffer;
+			for (int sn = 1; sn < chunk; sn++) {
+				memcpy(record, &T[sn], sizeof(double)); // records are only 4-byte aligned when there is an odd number of cells
+				int32_t* counts = (int32_t*)(record + sizeof(double));
+				for (int i = 0; i < cells; i++) {
+					counts[i] = x[sn][i * species + con_level];
+				}
+				record += record_size;
+			}
+			file->write(buffer, record - buffer);
+			delete[] buffer;
+		} else {
+			ostringstream buffer;
+			for (int sn = 1; sn < chunk; sn++) {
+				buffer << T[sn] << "\t";
+				for (int i = 0; i < cells; i++) {
+					buffer << x[sn][i * species + con_level] << "\t";
+				}
+				buffer << "\n";
 			}
-			*file << endl;
+			string text = buffer.str();
+			file->write(text.data(), text.size());
 		}
 	} catch (ofstream::failure) { // if there was a problem writing the results then exit the program
 		cout << terminal_red << "Couldn't write to run #" << run << "'s output file!" << terminal_reset << endl;
 		exit(1);
+	} catch (bad_alloc) { // if there isn't enough memory to buffer the results then exit the program
+		cout << terminal_no_memory << endl;
+		exit(1);
+	}
+}
+
+/*
+Store the oscillation features of every run (see features.h) in the given file relative to the output directory, one line per run.
+In batch mode (when conditions isn't NULL) every line also names the run's parameter set and mutant, and the runs of each condition are consecutive.
+Runs that weren't simulated because their parameter set was already decided (see evaluation.h) have no line.
+*/
+void store_features (char* output_path, char* ofeat_file, run_features* features, int runs, sim_condition* conditions, int num_conditions) {
+	int path_length = strlen(output_path);
+	char filename[path_length + strlen(ofeat_file) + 2];
+	strcpy(filename, output_path);
+	if (path_length > 0 && filename[path_length - 1] != '/') {
+		strcat(filename, "/");
+	}
+	strcat(filename, ofeat_file);
+	
+	cout << terminal_blue << "Creating oscillation features file " << terminal_reset << filename << " ... ";
+	ofstream file;
+	file.open(filename, fstream::out);
+	if (!file) {
+		cout << terminal_red << "Couldn't create " << filename << "!" << terminal_reset << endl;
+		exit(1);
+	}
+	ostringstream buffer;
+	if (conditions != NULL) {
+		buffer << "set,mutant,";
+	}
+	buffer << "run,per,amp,peak to trough,syncscore\n";
+	for (int j = 0; j < runs * (conditions != NULL ? num_conditions : 1); j++) {
+		if (!features[j].simulated) { // only evaluating parameter sets skips runs
+			continue;
+		}
+		if (conditions != NULL) {
+			sim_condition* condition = &conditions[j / runs];
+			buffer << condition->set << "," << mutant_names[condition->mutant] << ",";
+		}
+		buffer << j % runs << "," << features[j].period << "," << features[j].amplitude << "," << features[j].peak_to_trough << "," << features[j].syncscore << "\n";
+	}
+	string text = buffer.str();
+	file.write(text.data(), text.size());
+	file.close();
+	cout << terminal_done << endl;
+}
+
+// store whether each parameter set passed (see evaluation.h) in the given file relative to the output directory, one line per set
+void store_evaluations (char* output_path, const char* eval_file, set_evaluation* evaluations, int sets) {
+	int path_length = strlen(output_path);
+	char filename[path_length + strlen(eval_file) + 2];
+	strcpy(filename, output_path);
+	if (path_length > 0 && filename[path_length - 1] != '/') {
+		strcat(filename, "/");
+	}
+	strcat(filename, eval_file);
+	
+	cout << terminal_blue << "Creating evaluation file " << terminal_reset << filename << " ... ";
+	ofstream file;
+	file.open(filename, fstream::out);
+	if (!file) {
+		cout << terminal_red << "Couldn't create " << filename << "!" << terminal_reset << endl;
+		exit(1);
+	}
+	ostringstream buffer;
+	buffer << "set,result,failed mutant,runs\n";
+	for (int s = 0; s < sets; s++) {
+		set_evaluation* e = &evaluations[s];
+		buffer << s << "," << (e->passed ? "passed" : "failed") << "," << (e->failed >= 0 ? mutant_names[e->failed] : "") << "," << e->jobs << "\n";
+	}
+	string text = buffer.str();
+	file.write(text.data(), text.size());
+	file.close();
+	cout << terminal_done << endl;
+}
+
+/*
+Store the hot-path statistics of every run (see run-stats.h) as JSON in the given file relative to the output directory:
+an object with an array of every simulated run's statistics and the leaping settings it was simulated with, in the order of the features file (the set and mutant of each run are only printed in batch mode).
+*/
+void store_stats (char* output_path, const char* stats_file, run_stats* stats, int runs, sim_condition* conditions, int num_conditions, bool batch) {
+	int path_length = strlen(output_path);
+	char filename[path_length + strlen(stats_file) + 2];
+	strcpy(filename, output_path);
+	if (path_length > 0 && filename[path_length - 1] != '/') {
+		strcat(filename, "/");
+	}
+	strcat(filename, stats_file);
+	
+	cout << terminal_blue << "Creating statistics file " << terminal_reset << filename << " ... ";
+	ofstream file;
+	file.open(filename, fstream::out);
+	if (!file) {
+		cout << terminal_red << "Couldn't create " << filename << "!" << terminal_reset << endl;
+		exit(1);
+	}
+	ostringstream buffer;
+	buffer << "{\n\t\"runs\": [";
+	bool first = true;
+	for (int j = 0; j < runs * num_conditions; j++) {
+		run_stats* s = &stats[j];
+		if (!s->simulated) {
+			continue;
+		}
+		buffer << (first ? "\n" : ",\n") << "\t\t{";
+		first = false;
+		sim_condition* condition = &conditions[j / runs];
+		if (batch) {
+			buffer << "\"set\": " << condition->set << ", \"mutant\": \"" << mutant_names[condition->mutant] << "\", ";
+		}
+		buffer << "\"run\": " << j % runs;
+		
+		// the settings the run leaped with, which differ between conditions when they're autotuned
+		double settings[num_of_leap_settings];
+		get_leap_settings(&condition->leaping, settings);
+		buffer << ", \"leaping\": {\"appx\": " << (condition->leaping.appx ? "true" : "false") << ", \"hybrid\": " << (condition->leaping.hybrid ? "true" : "false")
+		       << ", \"langevin\": " << (condition->leaping.langevin ? "true" : "false");
+		for (int l = 0; l < num_of_leap_settings; l++) {
+			buffer << ", \"" << leap_setting_names[l] << "\": " << settings[l];
+		}
+		buffer << "}"
+		       << ", \"nrm_steps\": " << s->nrm_steps << ", \"nrm_delayed\": " << s->nrm_delayed << ", \"hybrid_steps\": " << s->hybrid_steps << ", \"langevin_steps\": " << s->langevin_steps
+		       << ", \"leaps\": " << s->leaps << ", \"explicit_leaps\": " << s->explicit_leaps << ", \"implicit_leaps\": " << s->implicit_leaps
+		       << ", \"repeats\": " << s->repeats << ", \"skips\": " << s->skips
+		       << ", \"poisson_draws\": " << s->poisson_draws << ", \"binomial_draws\": " << s->binomial_draws
+		       << ", \"delay_pushes\": " << s->delay_pushes << ", \"delay_merges\": " << s->delay_merges
+		       << ", \"delay_queue_mean\": " << (s->delay_pushes > 0 ? (double)s->delay_queue_total / s->delay_pushes : 0) << ", \"delay_queue_max\": " << s->delay_queue_max
+		       << ", \"seconds\": {\"tau_selection\": " << s->tau_selection << ", \"firing\": " << s->firing << ", \"delay_release\": " << s->delay_release
+		       << ", \"propensity_update\": " << s->propensity_update << ", \"output\": " << s->output << ", \"total\": " << s->total << "}}";
 	}
+	buffer << "\n\t]\n}\n";
+	string text = buffer.str();
+	file.write(text.data(), text.size());
+	file.close();
+	cout << terminal_done << endl;
 }
 
 // store the filename for the input or the file path for the output
@@ -25,7 +25,15 @@ using namespace std;
 
 #include "main.h"
 
-void store_results(ofstream*, int**, double*, int, int, int, int);
+void store_header(ofstream*, int, int, int, double, bool, int);
+void store_results(ofstream*, int**, double*, int, int, int, int, bool);
+struct run_features;
+struct sim_condition;
+struct set_evaluation;
+struct run_stats;
+void store_features(char*, char*, run_features*, int, sim_condition*, int);
+void store_evaluations(char*, const char*, set_evaluation*, int);
+void store_stats(char*, const char*, run_stats*, int, sim_condition*, int, bool);
 void store_filename(char**, const char*);
 void read_file(char*, char**);
 void parse_line(char*, double[], int*);
@@ -0,0 +1,205 @@
+/*
+Stochastic simulator for zebrafish segmentation
+Copyright (C) 2012 Ahmet Ay, Jack Holland, Adriana Sperlea
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <math.h>
+#include <vector>
+
+#include "langevin.h"
+#include "macros.h"
+#include "parameters.h"
+#include "rand-dist.h"
+#include "reaction-array.h"
+#include "stoichiometry.h"
+
+using namespace std;
+
+/*
+Start a run with the given initial concentrations, delays (in the order of delayed_reactions), and timestep:
+1) Allocate the state if this is the worker's first chemical Langevin run (throws bad_alloc if there isn't enough memory)
+2) Set every cell's concentrations to the initial ones
+3) Round each delay down to whole timesteps (but at least one, so every delayed firing finishes after it starts) and empty its ring
+*/
+void langevin_state::start (unsigned int cells, const int initial_concentrations[], const double delay_times[], double dt) {
+	if (this->x.data == NULL) {
+		this->cells = cells;
+		this->x.allocate(cells, species);
+		this->a.allocate(cells);
+		this->firings.allocate(cells);
+	}
+	
+	for (int j = 0; j < species; j++) {
+		double* xj = this->x[j];
+		for (unsigned int i = 0; i < cells; i++) {
+			xj[i] = initial_concentrations[j];
+		}
+	}
+	
+	for (int d = 0; d < num_of_delayed_reactions; d++) {
+		this->delay_steps[d] = (int)(delay_times[d] / dt);
+		if (this->delay_steps[d] < 1) {
+			this->delay_steps[d] = 1;
+		}
+		this->released[d].assign((size_t)this->delay_steps[d] * cells, 0);
+	}
+	this->step = 0;
+}
+
+// recalculate every propensity of every cell with the same rate laws as the exact simulation's (see updates.h), one reaction across every cell at a time
+void langevin_state::update_propensities (parameters* p, int neighbors, int (*nc)[7]) {
+	unsigned int cells = this->cells;
+	reaction_array<double>& a = this->a;
+	const double* mh1 = this->x[0];
+	const double* mh7 = this->x[1];
+	const double* mh13 = this->x[2];
+	const double* md = this->x[3];
+	const double* ph1 = this->x[4];
+	const double* ph7 = this->x[5];
+	const double* ph13 = this->x[6];
+	const double* pd = this->x[7];
+	const double* ph11 = this->x[8];
+	const double* ph17 = this->x[9];
+	const double* ph113 = this->x[10];
+	const double* ph77 = this->x[11];
+	const double* ph713 = this->x[12];
+	const double* ph1313 = this->x[13];
+	
+	for (unsigned int i = 0; i < cells; i++) {
+		// mRNA
+		a[0][i] = p->psh1 * mh1[i];			// Her1 protein synthesis
+		a[27][i] = p->mdh1 * mh1[i];		// her1 mRNA degradation
+		a[8][i] = p->psh7 * mh7[i];			// Her7 protein synthesis
+		a[29][i] = p->mdh7 * mh7[i];		// her7 mRNA degradation
+		a[14][i] = p->psh13 * mh13[i];		// Her13 protein synthesis
+		a[31][i] = p->mdh13 * mh13[i];		// her13 mRNA degradation
+		a[24][i] = p->psd * md[i];			// Delta protein synthesis
+		a[33][i] = p->mdd * md[i];			// delta mRNA degradation
+	}
+	
+	for (unsigned int i = 0; i < cells; i++) {
+		// monomer proteins (a fraction of a molecule can't pair with itself, so self-association stops below 1)
+		a[1][i] = p->pdh1 * ph1[i];											// Her1 protein degradation
+		a[2][i] = ph1[i] > 1 ? p->dah1h1 * ph1[i] * (ph1[i] - 1) / 2 : 0;	// Her1-Her1 dimer association
+		a[4][i] = p->dah1h7 * ph1[i] * ph7[i];								// Her1-Her7 dimer association
+		a[6][i] = p->dah1h13 * ph1[i] * ph13[i];								// Her1-Her13 dimer association
+		a[9][i] = p->pdh7 * ph7[i];											// Her7 protein degradation
+		a[10][i] = ph7[i] > 1 ? p->dah7h7 * ph7[i] * (ph7[i] - 1) / 2 : 0;	// Her7-Her7 dimer association
+		a[12][i] = p->dah7h13 * ph7[i] * ph13[i];							// Her7-Her13 dimer association
+		a[15][i] = p->pdh13 * ph13[i];										// Her13 protein degradation
+		a[16][i] = ph13[i] > 1 ? p->dah13h13 * ph13[i] * (ph13[i] - 1) / 2 : 0;	// Her13-Her13 dimer association
+		a[25][i] = p->pdd * pd[i];											// Delta protein degradation
+	}
+	
+	for (unsigned int i = 0; i < cells; i++) {
+		// dimers
+		a[3][i] = p->ddh1h1 * ph11[i];			// Her1-Her1 dimer dissociation
+		a[18][i] = p->ddgh1h1 * ph11[i];		// Her1-Her1 dimer degradation
+		a[5][i] = p->ddh1h7 * ph17[i];			// Her1-Her7 dimer dissociation
+		a[19][i] = p->ddgh1h7 * ph17[i];		// Her1-Her7 dimer degradation
+		a[7][i] = p->ddh1h13 * ph113[i];		// Her1-Her13 dimer dissociation
+		a[20][i] = p->ddgh1h13 * ph113[i];		// Her1-Her13 dimer degradation
+		a[11][i] = p->ddh7h7 * ph77[i];			// Her7-Her7 dimer dissociation
+		a[21][i] = p->ddgh7h7 * ph77[i];		// Her7-Her7 dimer degradation
+		a[13][i] = p->ddh7h13 * ph713[i];		// Her7-Her13 dimer dissociation
+		a[22][i] = p->ddgh7h13 * ph713[i];		// Her7-Her13 dimer degradation
+		a[17][i] = p->ddh13h13 * ph1313[i];		// Her13-Her13 dimer dissociation
+		a[23][i] = p->ddgh13h13 * ph1313[i];	// Her13-Her13 dimer degradation
+	}
+	
+	for (unsigned int i = 0; i < cells; i++) {
+		// transcription, repressed by Her1-Her1 and Her7-Her13 dimers and activated by the neighbors' Delta protein
+		double x11 = ph11[i] / p->critph1h1;
+		double x713 = ph713[i] / p->critph7h13;
+		double reaction_sum = 0;
+		for (int nn = 1; nn < neighbors; nn++) {
+			reaction_sum += pd[nc[i][nn]];
+		}
+		double y = (reaction_sum / (neighbors - 1)) / p->critpd;
+		double result1 = 1 + x11 * x11 + x713 * x713;
+		double result2 = (1 + y) / (y + result1);
+		a[26][i] = p->msh1 * result2;	// her1 mRNA transcription
+		a[28][i] = p->msh7 * result2;	// her7 mRNA transcription
+		a[30][i] = p->msh13;			// her13 mRNA transcription
+		a[32][i] = p->msd / result1;	// delta mRNA transcription
+	}
+}
+
+/*
+Advance every cell by one timestep with the Euler-Maruyama scheme:
+1) Fire each reaction a * dt + sqrt(a * dt) * N(0, 1) times, drawing the normals of one reaction across every cell at a time
+2) Release the delayed firings that started delay_steps steps ago and hold the new ones in their place in the ring
+3) Apply the firings of the non-delayed reactions
+4) Clip negative concentrations to 0, since the noise can overshoot when a species is nearly gone
+*/
+void langevin_state::advance (rand_stream* rng, double dt, const stoichiometry& st, const int delayed_reactions[]) {
+	unsigned int cells = this->cells;
+	for (int k = 0; k < reactions; k++) {
+		const double* ak = this->a[k];
+		double* fk = this->firings[k];
+		norm_dist_fill(rng, fk, cells);
+		for (unsigned int i = 0; i < cells; i++) {
+			double mean = ak[i] * dt;
+			fk[i] = mean + sqrt(mean) * fk[i];
+		}
+	}
+	
+	for (int d = 0; d < num_of_delayed_reactions; d++) {
+		int k = delayed_reactions[d];
+		double* ring = &this->released[d][(this->step % this->delay_steps[d]) * cells];
+		for (int n = st.reaction_offsets[k]; n < st.reaction_offsets[k + 1]; n++) {
+			double* xj = this->x[st.reaction_species[n]];
+			int value = st.reaction_values[n];
+			for (unsigned int i = 0; i < cells; i++) {
+				xj[i] += value * ring[i];
+			}
+		}
+		const double* fk = this->firings[k];
+		for (unsigned int i = 0; i < cells; i++) {
+			ring[i] = fk[i];
+		}
+	}
+	
+	for (int nd = 1; nd <= st.non_delayed[0]; nd++) {
+		int k = st.non_delayed[nd];
+		const double* fk = this->firings[k];
+		for (int n = st.reaction_offsets[k]; n < st.reaction_offsets[k + 1]; n++) {
+			double* xj = this->x[st.reaction_species[n]];
+			int value = st.reaction_values[n];
+			for (unsigned int i = 0; i < cells; i++) {
+				xj[i] += value * fk[i];
+			}
+		}
+	}
+	
+	for (int j = 0; j < species; j++) {
+		double* xj = this->x[j];
+		for (unsigned int i = 0; i < cells; i++) {
+			xj[i] = xj[i] < 0 ? 0 : xj[i];
+		}
+	}
+	this->step++;
+}
+
+// store every cell's concentrations, rounded to whole molecules, in the given concentrations array of an output chunk (which is stored by cell, see simulation.h)
+void langevin_state::round_concentrations (int* cx) {
+	for (unsigned int i = 0; i < this->cells; i++) {
+		for (int j = 0; j < species; j++) {
+			cx[i * species + j] = (int)(this->x[j][i] + 0.5);
+		}
+	}
+}
+
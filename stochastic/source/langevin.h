@@ -0,0 +1,64 @@
+/*
+Stochastic simulator for zebrafish segmentation
+Copyright (C) 2012 Ahmet Ay, Jack Holland, Adriana Sperlea
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/*
+Chemical Langevin simulation (-L or --langevin) keeps the noise of the exact simulation but advances the whole tissue by fixed timesteps instead of firing one reaction at a time.
+Every step, each reaction of each cell fires its expected number of times, a * dt, plus Gaussian noise with the same variance (the Euler-Maruyama scheme for the chemical Langevin equation),
+so a step costs the same no matter how many molecules there are and the concentrations are no longer whole numbers.
+Delays are rounded to whole timesteps like the deterministic simulator's: a delayed reaction's firings are held in a ring of that many steps and change their species once they come back around.
+The concentrations and propensities are stored by species or reaction across cells (see reaction-array.h), so every loop over a reaction's cells can be vectorized.
+The approximation is good when every reaction fires many times per step, so runs should be checked against exact ones before trusting their details,
+but it's fast enough to screen the synchronization of large tissues.
+*/
+
+#ifndef LANGEVIN_H
+#define LANGEVIN_H
+
+#include <vector>
+
+#include "macros.h"
+#include "parameters.h"
+#include "rand-dist.h"
+#include "reaction-array.h"
+#include "stoichiometry.h"
+
+using namespace std;
+
+// the state of a worker's chemical Langevin runs, allocated by the worker's first one
+struct langevin_state {
+	unsigned int cells; // the number of cells
+	reaction_array<double> x; // the concentration of each species (rows are species)
+	reaction_array<double> a; // the propensity of each reaction
+	reaction_array<double> firings; // how many times each reaction fires in the current step (noise first, then the firings themselves)
+	vector<double> released[num_of_delayed_reactions]; // each delayed reaction's firings still in progress, a ring of delay_steps steps of every cell
+	int delay_steps[num_of_delayed_reactions]; // each delay in whole timesteps
+	unsigned long step; // the current step
+	
+	langevin_state () {
+		this->cells = 0;
+		this->step = 0;
+	}
+	
+	void start(unsigned int, const int[], const double[], double);
+	void update_propensities(parameters*, int, int (*)[7]);
+	void advance(rand_stream*, double, const stoichiometry&, const int[]);
+	void round_concentrations(int*);
+};
+
+#endif
+
@@ -0,0 +1,98 @@
+/*
+Stochastic simulator for zebrafish segmentation
+Copyright (C) 2012 Ahmet Ay, Jack Holland, Adriana Sperlea
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <stdlib.h>
+#include <string>
+
+#include "leap-settings.h"
+#include "macros.h"
+
+using namespace std;
+
+const char* leap_setting_names[num_of_leap_settings] = {"beta", "delta_factor", "epsilon", "hybrid_step", "hybrid_threshold", "langevin_step", "ncrit", "nstiff", "skip_steps_ex", "skip_steps_im", "tau1_mult"};
+
+static const bool leap_setting_whole[num_of_leap_settings] = {false, false, false, false, true, false, true, false, true, true, false}; // whether or not each setting must be a whole number
+
+// store the values of the settings in the order of leap_setting_names
+void get_leap_settings (const leap_settings* ls, double values[]) {
+	values[0] = ls->beta;
+	values[1] = ls->delta_factor;
+	values[2] = ls->epsilon;
+	values[3] = ls->hybrid_step;
+	values[4] = ls->hybrid_threshold;
+	values[5] = ls->langevin_step;
+	values[6] = ls->ncrit;
+	values[7] = ls->nstiff;
+	values[8] = ls->skip_steps_ex;
+	values[9] = ls->skip_steps_im;
+	values[10] = ls->tau1_mult;
+}
+
+// set the settings to the given values in the order of leap_setting_names
+void set_leap_settings (leap_settings* ls, double values[]) {
+	ls->beta = values[0];
+	ls->delta_factor = values[1];
+	ls->epsilon = values[2];
+	ls->hybrid_step = values[3];
+	ls->hybrid_threshold = (int)values[4];
+	ls->langevin_step = values[5];
+	ls->ncrit = (int)values[6];
+	ls->nstiff = values[7];
+	ls->skip_steps_ex = (int)values[8];
+	ls->skip_steps_im = (int)values[9];
+	ls->tau1_mult = values[10];
+}
+
+/*
+Parse a comma-separated list of name=value pairs (e.g. epsilon=0.03,tau1_mult=20) into the given settings, leaving the settings not in the list as they are.
+Returns false if any name isn't a setting or any value isn't a positive number (the step counts and thresholds must also be whole numbers).
+*/
+bool parse_leap_settings (const char* list, leap_settings* ls) {
+	double values[num_of_leap_settings];
+	get_leap_settings(ls, values);
+	string pairs(list);
+	size_t start = 0;
+	while (start <= pairs.size()) {
+		size_t end = pairs.find(',', start);
+		if (end == string::npos) {
+			end = pairs.size();
+		}
+		string pair = pairs.substr(start, end - start);
+		size_t equals = pair.find('=');
+		if (equals == string::npos) {
+			return false;
+		}
+		string name = pair.substr(0, equals);
+		int s;
+		for (s = 0; s < num_of_leap_settings && name != leap_setting_names[s]; s++) {}
+		if (s == num_of_leap_settings) {
+			return false;
+		}
+		const char* text = pair.c_str() + equals + 1;
+		char* rest;
+		double value = strtod(text, &rest);
+		if (rest == text || *rest != '\0' || value <= 0 || (leap_setting_whole[s] && value != (int)value)) {
+			return false;
+		}
+		values[s] = value;
+		start = end + 1;
+	}
+	set_leap_settings(ls, values);
+	return true;
+}
+
@@ -0,0 +1,74 @@
+/*
+Stochastic simulator for zebrafish segmentation
+Copyright (C) 2012 Ahmet Ay, Jack Holland, Adriana Sperlea
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/*
+The settings that trade the accuracy of tau-leaping, id-leaping, hybrid simulation, and chemical Langevin simulation for speed.
+They start as the defaults in macros.h, can be changed with -w or --leap (e.g. -w epsilon=0.03,tau1_mult=20), and can be chosen per condition by autotuning (see autotune.h).
+Every condition (see batch.h) has its own settings, since parameter sets with very different rates leap best with very different settings.
+*/
+
+#ifndef LEAP_SETTINGS_H
+#define LEAP_SETTINGS_H
+
+#include "macros.h"
+
+#define num_of_leap_settings 11 // the number of settings -w or --leap can change
+
+struct leap_settings {
+	bool appx; // whether or not to use the approximation algorithms at all (-a or --approximate)
+	double beta; // increase this to merge more delayed queues for id-leaping at the cost of less accuracy
+	double delta_factor; // increase this to make partial equilibrium a more stringent condition
+	double epsilon; // increase this to increase the timesteps of tau-leaping
+	bool hybrid; // whether or not to integrate the reactions of high-copy species as ODEs instead of firing them one at a time (-H or --hybrid)
+	double hybrid_step; // the timestep (in minutes) the continuous reactions of hybrid simulation are integrated with
+	int hybrid_threshold; // the fewest molecules every species a reaction changes must have for hybrid simulation to integrate it continuously
+	bool langevin; // whether or not to solve the chemical Langevin equation instead of firing reactions (-L or --langevin)
+	double langevin_step; // the timestep (in minutes) of chemical Langevin simulation
+	int ncrit; // the maximum number of molecules / update value of a species for it to be considered critical
+	double nstiff; // increase this to increase the rate of implicit tau-leaping over explicit tau-leaping
+	int skip_steps_ex; // how many steps of the next-reaction-method to perform before resuming tau-leaping if the last tau-leap was explicit
+	int skip_steps_im; // how many steps of the next-reaction-method to perform before resuming tau-leaping if the last tau-leap was implicit
+	double tau1_mult; // the factor used (in combination with a0) to determine if tau-leaping is efficient enough to use over the next-reaction-method
+
+	leap_settings () {
+		this->appx = false;
+		this->beta = default_beta;
+		this->delta_factor = default_delta_factor;
+		this->epsilon = default_epsilon;
+		this->hybrid = false;
+		this->hybrid_step = default_hybrid_step;
+		this->hybrid_threshold = default_hybrid_threshold;
+		this->langevin = false;
+		this->langevin_step = default_langevin_step;
+		this->ncrit = default_ncrit;
+		this->nstiff = default_nstiff;
+		this->skip_steps_ex = default_skip_steps_ex;
+		this->skip_steps_im = default_skip_steps_im;
+		this->tau1_mult = default_tau1_mult;
+	}
+};
+
+// the names of the settings, as given to -w or --leap and printed in the statistics and autotuning cache (in the order of leap_settings' numeric fields)
+extern const char* leap_setting_names[num_of_leap_settings];
+
+void get_leap_settings(const leap_settings*, double[]);
+void set_leap_settings(leap_settings*, double[]);
+bool parse_leap_settings(const char*, leap_settings*);
+
+#endif
+
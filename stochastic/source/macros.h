@@ -19,11 +19,18 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #ifndef MACROS_H
 #define MACROS_H
 
-#define beta 0.05 // increase this to merge more delayed queues for id-leaping at the cost of less accuracy (should be 0.05-0.1)
-#define delta_factor 0.05 // increase this to make partial equilibrium a more stringent condition, allowing more reactions to be considered for implicit tau (should be around 0.05)
-#define epsilon 0.01 // increase this to increase the timesteps of tau-leaping (should be 0.03-0.05)
+#define default_beta 0.05 // increase this to merge more delayed queues for id-leaping at the cost of less accuracy (should be 0.05-0.1) (-w or --leap changes this)
+#define cache_line 64 // the number of bytes in a cache line (every row of a reaction_array starts on one, see reaction-array.h)
+#define chunk_memory 256 // the most megabytes of concentration snapshots to store before printing them (large tissues print more often instead)
+#define delay_arena_nodes 1048576 // the most nodes a delay_arena's slab starts with (queues start smaller in large tissues, see delay-queue.h)
+#define delay_queue_capacity 256 // the most nodes each delayed reaction queue starts with (queues double in size when they run out, so this only affects how often that happens)
+#define default_delta_factor 0.05 // increase this to make partial equilibrium a more stringent condition, allowing more reactions to be considered for implicit tau (should be around 0.05) (-w or --leap changes this)
+#define default_epsilon 0.01 // increase this to increase the timesteps of tau-leaping (should be 0.03-0.05) (-w or --leap changes this)
+#define default_hybrid_step 0.01 // the timestep (in minutes) hybrid simulation integrates its continuous reactions with (should be small enough that each step changes a high-copy species by a few molecules) (-w or --leap changes this)
+#define default_hybrid_threshold 100 // the fewest molecules every species a reaction changes must have for hybrid simulation to treat the reaction as continuous (-w or --leap changes this)
+#define default_langevin_step 0.01 // the timestep (in minutes) of chemical Langevin simulation, which is also how finely its delays are rounded like the deterministic simulator's (-w or --leap changes this)
 #define MB pow(2, 20) // the number of bytes in a megabyte
-#define ncrit 10 // the maximum number of molecules / update value of a species for it to be considered critical (should be around 10)
+#define default_ncrit 10 // the maximum number of molecules / update value of a species for it to be considered critical (should be around 10) (-w or --leap changes this)
 #define structure_twocell 0 // indicates a two-cell simulation
 #define structure_chain 1 // indicates a chain simulation
 #define structure_tissue 2 // indicates a tissue simulation
@@ -32,12 +39,13 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #define neighbors_for_tissue 7 // how many neighbors a cell in a haxagonal tissue grid has (including itself)
 #define num_of_delayed_reactions 7 // the number of reactions that are delayed in the zebrafish segmentation system
 #define num_of_parameters 45 // the number of parameters each line in the input file should have
-#define nstiff 100 // increase this to increase the rate of implicit tau-leaping over explicit tau-leaping (should be around 100)
+#define output_buffers 2 // the number of chunks of concentration snapshots each worker cycles through, so it can fill one while its output thread prints another (see output-writer.h)
+#define default_nstiff 100 // increase this to increase the rate of implicit tau-leaping over explicit tau-leaping (should be around 100) (-w or --leap changes this)
 #define reactions 34 // the number of reactions in the zebrafish segmentation system
-#define skip_steps_ex 100 // how many steps of the next-reaction-method to perform before resuming tau-leaping if the last tau-leap was explicit
-#define skip_steps_im 10 // how many steps of the next-reaction-method to perform before resuming tau-leaping if the last tau-leap was implicit
+#define default_skip_steps_ex 100 // how many steps of the next-reaction-method to perform before resuming tau-leaping if the last tau-leap was explicit (-w or --leap changes this)
+#define default_skip_steps_im 10 // how many steps of the next-reaction-method to perform before resuming tau-leaping if the last tau-leap was implicit (-w or --leap changes this)
 #define species 14 // the number of species in the zebrafish segmentation system
-#define tau1_mult 10 // the factor used (in combination with a0) to determine if tau-leaping is efficient enough to use over the next-reaction-method
+#define default_tau1_mult 10 // the factor used (in combination with a0) to determine if tau-leaping is efficient enough to use over the next-reaction-method (-w or --leap changes this)
 
 // these are convenient macros to calculate the maximum and minimum of two given values and the absolute value of the given value
 // don't give compound expressions as arguments to these because macros do stupid things with them (e.g. don't put max(i++, j) because then i will be incremented more times than expected)
@@ -26,22 +26,34 @@ We used the following articles and their associated algorithms to construct this
 
 #include "main.h"
 
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
 #include <errno.h>
 #include <fstream>
-#include <list>
+#include <iostream>
 #include <map>
+#include <mutex>
+#include <new>
 #include <math.h>
 #include <stdlib.h>
 #include <string>
 #include <string.h>
 #include <sys/stat.h>
+#include <thread>
+#include <vector>
 
+#include "autotune.h"
+#include "batch.h"
+#include "evaluation.h"
+#include "features.h"
 #include "file-io.h"
+#include "leap-settings.h"
 #include "macros.h"
 #include "parameters.h"
-#include "rand-dist.h"
-#include "rq-node.h"
-#include "updates.h"
+#include "run-stats.h"
+#include "simulation.h"
 #include "utility.h"
 
 using namespace std;
@@ -53,38 +65,6 @@ char* terminal_reset;
 
 
 int main (int argc, char** argv) {
-	/*
-	Initialize constant variables:
-	These arrays and matrices do not change over the course of the simulation and contain information specific to the zebrafish segmentation notch pathway.
-	*/
-	
-	const int delayed_reactions[num_of_delayed_reactions] = {0, 8, 14, 24, 26, 28, 32}; // list of delayed reaction indices
-	
-	const int initial_concentrations[species] = {0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0}; // initial (time=0) concentration values for each species
-	
-	const int species_update_indices[reactions][4] = {{0, 0, 0, 0}, {1, 4, 0, 0}, {2, 4, 8, 0}, {2, 4, 8, 0}, {3, 4, 5, 9}, {3, 4, 5, 9}, {3, 4, 6, 10}, {3, 4, 6, 10}, {0, 0, 0, 0}, {1, 5, 0, 0}, {2, 5, 11, 0}, {2, 5, 11, 0}, {3, 5, 6, 12}, {3, 5, 6, 12}, {0, 0, 0, 0}, {1, 6, 0, 0}, {2, 6, 13, 0}, {2, 6, 13, 0}, {1, 8, 0, 0}, {1, 9, 0, 0}, {1, 10, 0, 0}, {1, 11, 0, 0}, {1, 12, 0, 0}, {1, 13, 0, 0}, {0, 0, 0, 0}, {1, 7, 0, 0}, {0, 0, 0, 0}, {1, 0, 0, 0}, {0, 0, 0, 0}, {1, 1, 0, 0}, {1, 2, 0, 0}, {1, 2, 0, 0}, {0, 0, 0, 0}, {1, 3, 0, 0}}; // the species indices to update for each nChains of cells look like this:on-delayed reaction (the first value of each array is the number of species to update, so if the first value is 2 then only the next 2 indices are looked at to determine which species to update)
-	
-	const int species_update_indices_delayed[num_of_delayed_reactions] = {4, 5, 6, 7, 0, 1, 3}; // the species indices to update for each delayed reaction (in this system delayed reactions update only 1 species each so the structure is less complicated than the one above for non-delayed reactions)
-	
-	const int species_update_values[species][reactions] = // the values (i.e. number of molecules) to change each species by for each reaction
-	//	  0   1   2   3   4   5   6   7   8   9  10  11  12  13  14  15  16  17  18  19  20  21  22  23  24  25  26  27  28  29  30  31  32  33
-	       {{ 0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0, +1, -1,  0,  0,  0,  0,  0,  0},
-		{ 0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0, +1, -1,  0,  0,  0,  0},
-		{ 0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0, +1, -1,  0,  0},
-		{ 0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0, +1, -1},
-		{+1, -1, -2, +2, -1, +1, -1, +1,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0},
-		{ 0,  0,  0,  0, -1, +1,  0,  0, +1, -1, -2, +2, -1, +1,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0},
-		{ 0,  0,  0,  0,  0,  0, -1, +1,  0,  0,  0,  0, -1, +1, +1, -1, -2, +2,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0},
-		{ 0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0, +1, -1,  0,  0,  0,  0,  0,  0,  0,  0},
-		{ 0,  0, +1, -1,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0, -1,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0},
-		{ 0,  0,  0,  0, +1, -1,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0, -1,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0},
-		{ 0,  0,  0,  0,  0,  0, +1, -1,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0, -1,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0},
-		{ 0,  0,  0,  0,  0,  0,  0,  0,  0,  0, +1, -1,  0,  0,  0,  0,  0,  0,  0,  0,  0, -1,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0},
-		{ 0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0, +1, -1,  0,  0,  0,  0,  0,  0,  0,  0, -1,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0},
-		{ 0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0, +1, -1,  0,  0,  0,  0,  0, -1,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0}};
-	
-	const int par_eq_pairs[reactions] = {-1, -1, 3, 2, 5, 4, 7, 6, -1, -1, 11, 10, 13, 12, -1, -1, 17, 16, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1}; // if a reaction has a pair then the value at its index contains its pair's index, and if a reaction doesn't have a pair then the value at its index is -1
-	
 	map<string, int> levels; // a map between strings describing concentration levels and their indices used in the program
 	levels["her1"] = 1;
 	levels["her7"] = 2;
@@ -123,717 +103,219 @@ int main (int argc, char** argv) {
 	unsigned int print_interval = 1200; // how often (in minutes) the output file should be printed to (this does not change the simulation results, but is useful to see progress in very slow simulations) (-p or --print changes this)
 	char* seed_file = NULL; // the filename containing the seed used to generate random numbers (relative to the output path, this defaults to "seed.txt") (-k --keepseed changes this)
 	bool appx = false; // if this is set to true then the simulation will use approximation algorithms to create faster but potentially less accurate results (-a or --algorithm followed by "exact" or "appx" changes this)
+	bool hybrid = false; // if this is set to true then the reactions of high-copy species are integrated as ODEs while the rest are simulated exactly (-H or --hybrid changes this)
+	bool langevin = false; // if this is set to true then the chemical Langevin equation is solved instead of firing reactions (-L or --langevin changes this)
+	unsigned int threads = 1; // the number of runs to simulate at the same time (-n or --threads changes this)
+	bool binary = false; // if this is set to true then the results are printed as binary run files instead of text ones (-b or --binary changes this)
+	char* ofeat_file = NULL; // the filename to print each run's oscillation features to (relative to the output path, these aren't computed unless a filename is given) (-f or --ofeatures changes this)
+	bool print_runs = true; // if this is set to false then only the oscillation features are printed, not the run files (-e or --features-only changes this)
+	char* batch_file = NULL; // the path and filename containing the parameter sets to simulate in batch mode (batch mode isn't used unless a filename is given) (-j or --batch changes this)
+	char* mutant_list = NULL; // the comma-separated mutants to simulate for each parameter set in batch mode (this defaults to every mutant) (-u or --mutants changes this)
+	bool evaluate = false; // if this is set to true then batch mode decides whether each parameter set passes, stopping its runs once it's decided (-v or --evaluate changes this)
+	bool print_stats = false; // if this is set to true then every run's hot-path statistics are printed to stats.json, which requires compiling them in (-z or --stats changes this)
+	char* leap_list = NULL; // the comma-separated name=value pairs of the leaping settings to change from their defaults in macros.h (-w or --leap changes this)
+	char* autotune_file = NULL; // the path and filename caching the autotuned leaping settings of each condition (the settings aren't autotuned unless a filename is given) (-d or --autotune changes this)
 	
 	terminal_color();
 
-	checkArgs(argc, argv, xcells, ycells, max_minutes, max_timesteps, runs, seed, &input_file, &output_path, con_level, levels, granularity, print_interval, &seed_file, appx);
+	checkArgs(argc, argv, xcells, ycells, max_minutes, max_timesteps, runs, seed, &input_file, &output_path, con_level, levels, granularity, print_interval, &seed_file, appx, hybrid, langevin, threads, binary, &ofeat_file, print_runs, &batch_file, &mutant_list, evaluate, print_stats, &leap_list, &autotune_file);
+	if (batch_file != NULL) { // batch mode only prints the oscillation features of every run, all to one file
+		print_runs = false;
+		if (ofeat_file == NULL) {
+			store_filename(&ofeat_file, "batch.csv");
+		}
+	}
+	if (!print_runs && ofeat_file == NULL) {
+		usage("Printing only the oscillation features requires a file to print them to. Set -f or --ofeatures when using -e or --features-only.");
+	}
+	if (print_stats && !stats_compiled) {
+		usage("The hot-path statistics aren't compiled in. Build with scons stats=1 to use -z or --stats.");
+	}
+	leap_settings leaping; // the leaping settings of every condition, unless they're autotuned
+	leaping.appx = appx;
+	leaping.hybrid = hybrid;
+	leaping.langevin = langevin;
+	if (appx && hybrid) {
+		usage("Hybrid simulation replaces tau-leaping rather than approximating alongside it. Set only one of -a or --approximate and -H or --hybrid.");
+	}
+	if (langevin && (appx || hybrid)) {
+		usage("Chemical Langevin simulation doesn't fire reactions, so it can't leap or simulate hybridly. Set -L or --langevin without -a or --approximate and -H or --hybrid.");
+	}
+	if (leap_list != NULL && !parse_leap_settings(leap_list, &leaping)) {
+		usage("The leaping settings must be a comma-separated list of name=value pairs with positive values (whole numbers for hybrid_threshold, ncrit, skip_steps_ex, and skip_steps_im). Set -w or --leap to a list such as epsilon=0.03,tau1_mult=20.");
+	}
+	int mutants[num_of_mutants]; // the mutants to simulate in batch mode
+	int num_mutants = parse_mutants(mutant_list != NULL ? mutant_list : "wt,delta,her13,her1,her7,her713", mutants);
+	if (num_mutants == 0) {
+		usage("The mutants must be a comma-separated list of wt, delta, her13, her1, her7, and her713. Set -u or --mutants to a list such as wt,delta.");
+	}
+	if (evaluate) { // the mutants are evaluated in the deterministic simulator's order, which is the order of their indices, and their periods are compared with the wild type's
+		if (batch_file == NULL) {
+			usage("Evaluating parameter sets requires batch mode. Set -j or --batch when using -v or --evaluate.");
+		}
+		sort(mutants, mutants + num_mutants);
+		if (mutants[0] != mutant_wt) {
+			usage("Evaluating parameter sets requires the wild type. Include wt in -u or --mutants when using -v or --evaluate.");
+		}
+	}
 	
 	unsigned int cells = xcells * ycells; // the total number of cells
 	int structure; // two-cell, chain, or tissue
 	int neighbors; // the number of neighbors each cell has
 	checkSize(xcells, ycells, structure, neighbors);
 	
-	int nc[cells][7];
+	int (*nc)[7]; // the neighbors of each cell (on the heap, since large tissues don't fit on the stack)
+	try {
+		nc = new int[cells][7];
+	} catch (bad_alloc) { // if there isn't enough memory to allocate the neighbors then exit the program
+		cout << terminal_no_memory << endl;
+		exit(1);
+	}
 	cells_neighbors(structure, neighbors, cells, xcells, nc);
 	
 	seed_init(seed_file, seed);
 
-	rates rs = new rates(50); // create the rates struct
-	
-	parse_input();
-	double delay_times[num_of_delayed_reactions] = {rs.rates_base[RDELAYPH1], rs.rates_base[RDELAYPH7], rs.rates_base[RDELAYPH13], rs.rates_base[RDELAYPDELTA], rs.rates_base[RDELAYMH1], rs.rates_base[RDELAYMH7], rs.rates_base[RDELAYMDELTA]}; // create the delay times array
-		
-	ofstream ofile[runs]; // the array of file streams
-	create_output(output_path, ofile);
-
-	int chunk = max_minutes / granularity + 1;
-	int** x; // concentrations
-	double* T; // timesteps
-	memory_alloc(chunk, cells, &x, &T);
-
 	/*
-	Run the simulations:
-	1) For every run (by default 1, but can be changed with -r or --runs), do the following:
-	2) Initialize the initial concentration and timestep values
-	3) Initialize delayed reaction lists, propensity values, Pk and Tk arrays (for calculating delta using next-reaction-method), etc.
-	4) Iterate through the allowed number of iterations doing the following:
-		a) End the simulation if the number of simulation minutes exceeds the limit
-		b) Otherwise, if tau-leaping is not temporarily disabled, try to leap
-		c) If tau-leaping is disabled, run next-reaction-method until it isn't anymore
-		d) If the simulation has progressed enough to print (by default every 60 minutes, but can be changed with -p or --print), print the results
-	5) When the simulation is done, clear any remaining items in the delayed reaction lists
-	6) Print any unprinted results
-	7) If there is another run then go back to step 4
-	8) Otherwise, if every run is finished, clear the memory allocated for the concentrations and timestep structures
+	Gather the conditions to simulate:
+	1) In batch mode (-j or --batch), every parameter set in the batch file with every mutant (by default all of them, but can be changed with -u or --mutants)
+	2) Otherwise, the input file's parameter set as is
 	*/
-	
-	for (unsigned int r = 0; r < runs; r++) {
-		// indicate to the user that a new run is starting
-		cout << terminal_blue << "Simulating " << terminal_reset << "run #" << r << " ... ";
-		cout.flush();
-
-		// initialize concentration and timestep values (the 0th index isn't used because T[chunk_index - 1] must always exist, so the results start at 1)
-		for (unsigned int i = 0; i < cells; i++) {
-			for (int j = 0; j < species; j++) {
-				x[1][i * species + j] = initial_concentrations[j];
-			}
-		}
-		T[0] = 0; // placeholder value
-		T[1] = 0; // actual first time entry
-		int last_print = T[1]; // the last time that was printed
-
-		// create an array of lists to store the delayed reactions
-		list<double> rq[cells][num_of_delayed_reactions]; // used for next-reaction-method and id-leaping
-		list<rq_node> rq_idl[cells][num_of_delayed_reactions]; // used just for id-leaping
-		/* create Tk and Pk arrays, used to calculate delta for the next-reaction-method 
-		   (Tk = current internal time of reaction k, Pk = first internal time after Tk at which reaction k fires)
-		*/
-		double Tk[cells][reactions];
-		double Pk[cells][reactions];
-		// create the propensity values array and the sum of them, a0
-		double a[cells][reactions];
-		double a0 = 0;
-		// create an array to keep track of how many times each reaction fires for tau-leaping
-		int firings[cells][reactions];
+	sim_condition* conditions; // the parameters and delays of each condition
+	unsigned int num_conditions;
+	if (batch_file != NULL) {
+		num_conditions = parse_batch(batch_file, mutants, num_mutants, &conditions);
+	} else {
+		rates rs = new rates(50); // create the rates struct
 		
-		// initialize everything that was just created
-		for (unsigned int i = 0; i < cells; i++) {
-			for (int k = 0; k < reactions; k++) {
-				Tk[i][k] = 0;
-				Pk[i][k] = pk_dist(); // log(1 / unif_dist())
-				a[i][k] = 0;
-				firings[i][k] = 0;
-			}
-			
-			// initialize delayed transcription reactions properly
-			a[i][26] = pars.msh1;
-			a[i][28] = pars.msh7;
-			a[i][30] = pars.msh13; // remains constant throughout the simulation
-			a[i][32] = pars.msd;
-			a0 += a[i][26] + a[i][28] + a[i][30] + a[i][32]; // keep track of the sum of the propensities as they are changed
-		}
+		parse_input();
+		double delay_times[num_of_delayed_reactions] = {rs.rates_base[RDELAYPH1], rs.rates_base[RDELAYPH7], rs.rates_base[RDELAYPH13], rs.rates_base[RDELAYPDELTA], rs.rates_base[RDELAYMH1], rs.rates_base[RDELAYMH7], rs.rates_base[RDELAYMDELTA]}; // create the delay times array
 		
-		int HOR[3]; // the higher order reactions array stores a dividing factor for Hill-type reactions, used for tau-leaping
-		for (int j = 0; j < 3; j++) {
-			HOR[j] = 0;
+		num_conditions = 1;
+		try {
+			conditions = new sim_condition[1];
+		} catch (bad_alloc) { // if there isn't enough memory to allocate the condition then exit the program
+			cout << terminal_no_memory << endl;
+			exit(1);
 		}
-		
-		bool last_step_ex = true; // whether or not the last tau-leaping step was explicit (as opposed to implicit)
-		int skip_steps = !appx * -1; // if the simulation shouldn't approximate then set skip_steps to -1, preventing it from ever becoming 0
-
-		// iterate through each time step
-		int cell_index = -1; // the cell index of the most recently fired reaction for the next-reaction-method
-		int reaction_index = -1; // the reaction index of the most recently fired reaction
-		bool is_delayed = false; // whether or not the most recently fired reaction was a delayed reaction
-		int chunk_index = 1; // the current chunk index in which to store data
-		int* cx = x[chunk_index]; // the current concentrations array in which to store data
-		
-		// iterate through the maximum allowed number of timesteps
-		for (unsigned long iter = 0; iter < max_timesteps; iter++) {
-			// if the current simulation time is more than the maximum simulation time then end the simulation
-			if (T[chunk_index] >= max_minutes) {
-				break;
-			}
-			
-			if (skip_steps == 0) { // if tau-leaping isn't temporarily disabled
-				
-				/*
-				Adaptive tau-leaping with improved delay leaping (id-leaping):
-				1) Calculate non-critical tau candidate (tau1)
-					a) Calculate explicit tau1 candidate (tau_ex) based on all non-critical reactions
-					b) Calculate implicit tau1 candidate (tau_im) based on non-critical non-partial-equilibrium reactions
-					c) Take tau1 as the minimum of tau_ex and tau_im
-				2) If tau1 is so small that the next-reaction-method would be more efficient, stop trying to tau-leap
-				3) Otherwise, if tau-leaping is useful, calculate tau2
-					a) Store the sum of the propensities of the critical reactions in a0_crit
-					b) Calculate tau2 based on an exponential distribution of a0_crit
-				4) Take tau as the minimum of tau1 and tau2
-				5) Fire any delayed reactions that should be fired and remove them from their list
-				6) Calculate the number of firings for each reaction
-				7) If the new concentration levels would be negative, don't update the concentrations and instead halve tau1 and try from step 3 again
-				8) Add any appropriate delayed reactions (or merge them with existing ones via id-leaping method)
-				9) Update concentrations, propensities, and the simulation timestep
-				*/
-				
-				double tau1; // non-critical tau candidate
-				double tau_ex = INFINITY; // explicit tau1 candidate
-				double tau_im = INFINITY; // implicit tau1 candidate
-				bool critical[cells][reactions]; // a matrix that stores whether each reaction of each cell is critical or not at this point in the simulation
-				bool ncrit_exists = false; // true if at least one non-critical reaction exists, false otherwise
-				for (unsigned int i = 0; i < cells; i++) {
-					int co = i * species; // cell offset for indexing the concentrations array
-					for (int k = 0; k < reactions; k++) {
-						if (a[i][k] > 0) { // if the reaction has a chance of occuring
-							int min = (int)-INFINITY; // since this considers only negative update reactions, the least negative value is chosen
-							for (int j = 0; j < species; j++) {
-								if (species_update_values[j][k] < 0) { // consider only negative update reactions (i.e. degradations)
-									int min_temp = cx[co + j] / species_update_values[j][k];
-									if (min_temp > min) { // if min_temp is less negative than min then overwrite min with min_temp
-										min = min_temp;
-									}
-								}
-							}
-							critical[i][k] = min != (int)-INFINITY ? min * -1 < ncrit : false; // each reaction is considered critical if the absolute value of min is less than ncrit
-						} else { // reactions with no chance of occuring can't be critical
-							critical[i][k] = false;
-						}
-						if (!ncrit_exists && !critical[i][k]) { // if the first non-critical reaction is encountered then indicate that it exists
-							ncrit_exists = true;
-						}
-					}
-					
-					if (ncrit_exists) { // if at least one non-critical reaction exists
-						for (int j = 4; j <= 6; j++) { // species 4, 5, and 6 are higher order reactions, so their division factors must be calculated based on their current concentration values
-							HOR[j - 4] = 2 + 1 / (cx[co + j] + 1);
-						}
-						
-						for (int j = 0; j < species; j++) {
-							double exg = epsilon * cx[co + j]; // epsilon is usually 0.03-0.05
-							if (j >= 4 && j <= 6) { // higher order reactions divide by a factor more than 1, lower order reactions divide by 1, so no division is executed
-								exg /= HOR[j - 4];
-							}
-							double max_ep = max(exg, 1); // make sure exg is at least one
-							
-							double mu_ex = 0; // mu for explicit tau
-							double mu_im = 0; // mu for implicit tau
-							double sigma_ex = 0; // sigma for explicit tau
-							double sigma_im = 0; // sigma for implicit tau
-							for (int k = 0; k < reactions; k++) {
-								if (!critical[i][k]) { // mu and sigma values only consider non-critical reactions
-									int r_up = species_update_values[j][k]; // reaction update value
-									double r_a = a[i][k]; // reaction propensity value
-									double mu_change = r_up * r_a; // add to explicit tau
-									mu_ex += mu_change;
-									sigma_ex += mu_change * r_up;
-									int pair = par_eq_pairs[k]; // the index of the reaction's pair, or -1 if it has none
-									if (pair == -1) { // a reaction without a pair is never in partial equilibrium
-										mu_im += mu_change;
-										sigma_im += mu_change * r_up;
-									} else if (pair > k) { // if the reaction has a pair and the pair has not already been considered
-										int pair_up = species_update_values[j][pair]; // pair update value
-										double pair_a = a[i][pair]; // pair propensity value
-										if ((r_a < pair_a && pair_a - r_a <= delta_factor * r_a) || (pair_a <= r_a && r_a - pair_a <= delta_factor * pair_a)) { // if the pair isn't in partial equilibrium then add to implicit tau
-											mu_im += mu_change + pair_up * pair_a;
-											sigma_im += mu_change * r_up + pair_up * pair_up * pair_a;
-										}
-									}
-								}
-							}
-							mu_ex = abs(mu_ex);
-							mu_im = abs(mu_im);
-							
-							// calculate new candidates for tau explicit and tau implicit and update them if a new minimum value has been found
-							double min1 = mu_ex != 0 ? max_ep / mu_ex : INFINITY;
-							double min2 = sigma_ex != 0 ? (max_ep * max_ep) / sigma_ex : INFINITY;
-							min1 = min(min1, min2);
-							if (min1 < tau_ex) {
-								tau_ex = min1;
-							}
-							min1 = mu_im != 0 ? max_ep / mu_im : INFINITY;
-							min2 = sigma_im != 0 ? (max_ep * max_ep) / sigma_im : INFINITY;
-							min1 = min(min1, min2);
-							if (min1 < tau_im) {
-								tau_im = min1;
-							}
-						}
-					}
-				}
-				
-				bool temp_lse = last_step_ex; // store whether the last step was explicit
-				if (tau_im > nstiff * tau_ex) { // if the system is considered stiff then set tau1 to tau implicit and mark the current step as implicit
-					tau1 = tau_im;
-					last_step_ex = false;
-				} else { // if the system isn't considered stiff then set tau1 to tau explicit and mark the current step as explicit
-					tau1 = tau_ex;
-					last_step_ex = true;
-				}
-				
-				bool repeat;
-				do { // under some conditions these steps must be repeated multiple times per iteration but by default they aren't (this only repeats when repeat=true)
-					repeat = false;
-					if (tau1 < tau1_mult / a0) { // if the stepsize of tau1 is so small that it would be more efficient to use the next-reaction-method then skip tau-leaping for a number of steps depending on the stiffness of the system
-						if (temp_lse) {
-							skip_steps = skip_steps_ex;
-						} else {
-							skip_steps = skip_steps_im;
-						}
-					} else { // if tau-leaping is more efficient than the next-reaction-method then continue
-						// calculate the sum of the propensities for all critical reactions
-						double a0_crit = 0;
-						for (unsigned int i = 0; i < cells; i++) {
-							for (int k = 0; k < reactions; k++) {
-								if (critical[i][k]) {
-									a0_crit += a[i][k];
-								}
-							}
-						}
-						
-						double tau2 = a0_crit != 0 ? expo_dist(a0_crit) : INFINITY; // critical tau candidate
-						double tau = min(tau1, tau2); // pick tau based on the smaller of the non-critical and critical candidates
-						
-						double nT = T[chunk_index] + tau; // the next simulation timestep
-						for (unsigned int i = 0; i < cells; i++) { // iterate through every delayed reaction for every cell
-							for (int d = 0; d < num_of_delayed_reactions; d++) {
-								int ri = delayed_reactions[d];
-								list<double>::iterator earliest = rq[i][d].begin(); // iterate through this reaction's list, split into the earlist firing time list and the number of firings and span length list
-								list<rq_node>::iterator fs = rq_idl[i][d].begin();
-								while (earliest != rq[i][d].end()) {
-									if (*earliest < nT) { // if the delayed reaction's delay is over
-										double qd = nT - *earliest; // the difference between the delayed reaction's earliest firing time and the new time
-										int kd = bino_dist(fs->firings, min(qd, fs->span) / fs->span); // a binomial distribution based on the number of times the reaction should fire and the minimum of qd and the reaction's span
-										fs->firings -= kd; // update firings, span, and earliest
-										fs->span -= qd;
-										*earliest = nT;
-										for (int j = 0; j < species; j++) { // update the concentrations based on kd
-											cx[i * species + j] += kd * species_update_values[j][ri];
-										}
-										if (fs->firings == 0) { // if the delayed reaction is done then remove it from its list
-											rq[i][d].erase(earliest++);
-											rq_idl[i][d].erase(fs++);
-										}
-									} else {
-										earliest++;
-										fs++;
-									}
-								}
-							}
-						}
-						
-						if (tau2 > tau1) { // if tau=tau1
-							for (unsigned int i = 0; i < cells; i++) {
-								for (int k = 0; k < reactions; k++) {
-									if (critical[i][k]) {
-										firings[i][k] = 0; // no critical reactions should fire
-									} else {
-										firings[i][k] = pois_dist(a[i][k] * tau); // non-critical reactions should fire based on a Poisson distribution of their propensities and the time difference, tau
-									}
-								}
-							}
-						} else { // if tau=tau2
-							unsigned int jc = 0; // the index of the critical reaction that should fire this iteration
-							double random_start = 0; // use a point probability distribution to pick jc
-							double random_end = unif_dist();
-							bool breakout = false;
-							for (unsigned int i = 0; i < cells; i++) {
-								if (breakout) {
-									break;
-								}
-								for (int k = 0; k < reactions; k++) {
-									if (critical[i][k]) {
-										random_start += a[i][k] / a0_crit; // incrementally work up to a0_crit
-										if (random_start >= random_end) { // if the intermediate sum is more than the uniformly distributed random variable chosen above then set jc to the kth reaction of the ith cell
-											jc = i * reactions + k;
-											breakout = true; // stop iterating because jc has already been found
-											break;
-										}
-									}
-								}
-							}
-							
-							for (unsigned int i = 0; i < cells; i++) {
-								for (int k = 0; k < reactions; k++) {
-									if (critical[i][k]) {
-										firings[i][k] = (i * reactions + k == jc); // no critical reaction but jc should fire
-									} else {
-										firings[i][k] = pois_dist(a[i][k] * tau); // non-critical reactions should fire based on a Poisson distribution of their propensities and the time difference, tau
-									}
-									
-									for (int j = 0; j < species; j++) {
-										if (cx[i * species + j] + firings[i][k] * species_update_values[j][k] < 0) { // if the new concentration levels for any species would be negative then halve tau1 and try again
-											repeat = true;
-											tau1 /= 2;
-											break;
-										}
-									}
-									if (repeat) {
-										break;
-									}
-								}
-							}
-						}
-						
-						if (!repeat) { // if the concentrations won't be negative (i.e. everything is fine)
-							for (unsigned int i = 0; i < cells; i++) {
-								for (int d = 0; d < num_of_delayed_reactions; d++) {
-									int ri = delayed_reactions[d]; // reaction index
-									if (firings[i][ri] > 0) { // if the delayed reaction should fire
-										bool add = true;
-										if (!rq_idl[i][d].empty()) { // if the list for this reaction isn't empty
-											rq_node* fs = &rq_idl[i][d].back();
-											double fs_ratio = fs->firings / fs->span;
-											double ratio_diff = firings[i][ri] / tau - fs_ratio;
-											if (abs(ratio_diff) < beta * fs_ratio) { // if the last list element and this one can be merged then merge them
-												fs->firings += firings[i][ri];
-												fs->span += tau;
-												add = false;
-											}
-										}
-										if (add) { // if the last list element couldn't be merged with this one then add it to the reaction's list
-											try {
-												rq[i][d].push_back(T[chunk_index] + delay_times[d]);
-												rq_idl[i][d].push_back(rq_node(firings[i][ri], tau));
-											} catch (bad_alloc) { // if there isn't enough memory to allocate a new list element then exit the program
-												cout << terminal_no_memory << endl;
-												exit(1);
-											}
-										}
-									}
-								}
-							}
-							
-							// update the appropriate concentrations
-							for (unsigned int i = 0; i < cells; i++) {
-								for (int j = 0; j < species; j++) {
-									for (int k = 0; k < reactions; k++) {
-										bool not_delayed = true;
-										for (int d = 0; d < num_of_delayed_reactions; d++) { // check if the kth reaction is delayed
-											if (k == delayed_reactions[d]) {
-												not_delayed = false;
-												break;
-											}
-										}
-										if (not_delayed) { // if the reaction isn't delayed (and therefore hasn't updated its appropriate concentrations) update the concentrations for it
-											cx[i * species + j] += firings[i][k] * species_update_values[j][k];
-										}
-									}
-								}
-								
-								// update every propensity value since any could have changed
-								double* acell = a[i];
-								int xcell = i * species;
-								update_a0_27(acell, &pars, cx, xcell, &a0);
-								update_a1_2_4_6(acell, &pars, cx, xcell, &a0);
-								update_a3_18(acell, &pars, cx, xcell, &a0);
-								update_a4_9_10_12(acell, &pars, cx, xcell, &a0);
-								update_a5_19(acell, &pars, cx, xcell, &a0);
-								update_a6_12_15_16(acell, &pars, cx, xcell, &a0);
-								update_a7_20(acell, &pars, cx, xcell, &a0);
-								update_a8_29(acell, &pars, cx, xcell, &a0);
-								update_a11_21(acell, &pars, cx, xcell, &a0);
-								update_a13_22(acell, &pars, cx, xcell, &a0);
-								update_a14_31(acell, &pars, cx, xcell, &a0);
-								update_a17_23(acell, &pars, cx, xcell, &a0);
-								update_a24_33(acell, &pars, cx, xcell, &a0);
-								update_a25(acell, &pars, cx, xcell, &a0);
-								update_a26_28_32(acell, &pars, cx, xcell, neighbors, nc[i], &a0);
-							}
-							
-							// update the simulation timestep
-							T[chunk_index] = nT;
-						}
-					}
-				} while (repeat); // repeat if the concentrations would have become negative
-			} else { // if tau-leaping has been temporarily disabled for the sake of efficiency
-				if (skip_steps > 0) { 
-					/* 
-					   if tau-leaping should eventually be resumed 
-					   then decrement the number of times the next-reaction-method should be run before doing so
-					*/
-					skip_steps--;
-				}
-				
-				/*
-				Next reaction method with delayed reactions:
-				1) Update the propensity values related to the most recently fired reaction (skip this step the first iteration)
-				2) Calculate delta
-					a) Find the minimum of (Pk - Tk) / ak for each reaction to find delta
-					b) Find the minimum delay time - current time for each delayed reaction to find delta
-					c) Take delta as the minimum of steps a and b
-				3) Update the simulation timestep
-				4) Update the concentrations for the active reaction and 
-				   either pop it off its list if it's a finished delayed reaction or add it to the list if it's a new one
-				5) Update Pk and Tk with the appropriate values
-				*/
-				
-				// update the propensity functions
-				if (cell_index != -1) { // if there is a reaction to update the propensities with
-					int* cnc = nc[cell_index]; // get the cell's neighbors
-					int maxcell;
-					if ((is_delayed && reaction_index == 24) || reaction_index == 25) { 
-					    // reactions 24 and 25 require each of the cell's neighbors to update as well
-						maxcell = neighbors;
-					} else {
-						maxcell = 1;
-					}
-					for (int cn = 0; cn < maxcell; cn++) { 
-					    // for every cell that should update (usually just the active cell but see above about reactions 24 and 25)
-						double* acell = a[cnc[cn]]; // the cell index for the propensities array
-						int xcell = cnc[cn] * species; // the cell index for the concentrations array
-						bool enter = true; // update the propensities for all non-delayed reactions and delayed reactions that are finishing, not starting
-						for (int j = 0; j < num_of_delayed_reactions; j++) {
-							if (reaction_index == delayed_reactions[j]) {
-								enter = is_delayed;
-								break;
-							}
-						}
-						if (enter) {
-							switch (reaction_index) { // update the propensities based on the reaction index (these functions are inlined and combined for efficiency)
-								case 0:
-								case 1:
-									update_a1_2_4_6(acell, &pars, cx, xcell, &a0);
-									break;
-								case 2:
-								case 3:
-									update_a1_2_4_6(acell, &pars, cx, xcell, &a0);
-									update_a3_18(acell, &pars, cx, xcell, &a0);
-									update_a26_28_32(acell, &pars, cx, xcell, neighbors, nc[cnc[cn]], &a0);
-									break;
-								case 4:
-								case 5:
-									update_a1_2_4_6(acell, &pars, cx, xcell, &a0);
-									update_a5_19(acell, &pars, cx, xcell, &a0);
-									update_a4_9_10_12(acell, &pars, cx, xcell, &a0);
-									break;
-								case 6:
-								case 7:
-									update_a1_2_4_6(acell, &pars, cx, xcell, &a0);
-									update_a7_20(acell, &pars, cx, xcell, &a0);
-									update_a6_12_15_16(acell, &pars, cx, xcell, &a0);
-									break;
-								case 8:
-								case 9:
-									update_a4_9_10_12(acell, &pars, cx, xcell, &a0);
-									break;
-								case 10:
-								case 11:
-									update_a4_9_10_12(acell, &pars, cx, xcell, &a0);
-									update_a11_21(acell, &pars, cx, xcell, &a0);
-									break;
-								case 12:
-								case 13:
-									update_a4_9_10_12(acell, &pars, cx, xcell, &a0);
-									update_a13_22(acell, &pars, cx, xcell, &a0);
-									update_a6_12_15_16(acell, &pars, cx, xcell, &a0);
-									update_a26_28_32(acell, &pars, cx, xcell, neighbors, nc[cnc[cn]], &a0);
-									break;
-								case 14:
-								case 15:
-									update_a6_12_15_16(acell, &pars, cx, xcell, &a0);
-									break;
-								case 16:
-								case 17:
-									update_a6_12_15_16(acell, &pars, cx, xcell, &a0);
-									update_a17_23(acell, &pars, cx, xcell, &a0);
-									break;
-								case 18:
-									update_a3_18(acell, &pars, cx, xcell, &a0);
-									update_a26_28_32(acell, &pars, cx, xcell, neighbors, nc[cnc[cn]], &a0);
-									break;
-								case 19:
-									update_a5_19(acell, &pars, cx, xcell, &a0);
-									break;
-								case 20:
-									update_a7_20(acell, &pars, cx, xcell, &a0);
-									break;
-								case 21:
-									update_a11_21(acell, &pars, cx, xcell, &a0);
-									break;
-								case 22:
-									update_a13_22(acell, &pars, cx, xcell, &a0);
-									update_a26_28_32(acell, &pars, cx, xcell, neighbors, nc[cnc[cn]], &a0);
-									break;
-								case 23:
-									update_a17_23(acell, &pars, cx, xcell, &a0);
-									break;
-								case 24:
-								case 25:
-									update_a25(acell, &pars, cx, xcell, &a0);
-									update_a26_28_32(acell, &pars, cx, xcell, neighbors, nc[cnc[cn]], &a0);
-									break;
-								case 26:
-								case 27:
-									update_a0_27(acell, &pars, cx, xcell, &a0);
-									break;
-								case 28:
-								case 29:
-									update_a8_29(acell, &pars, cx, xcell, &a0);
-									break;
-								case 30:
-								case 31:
-									update_a14_31(acell, &pars, cx, xcell, &a0);
-									break;
-								case 32:
-								case 33:
-									update_a24_33(acell, &pars, cx, xcell, &a0);
-									break;
-							}
-						}
-					}
-				}
-				
-				double delta = INFINITY; // the time change
-				cell_index = -1; // the cell index of the active reaction
-				reaction_index = -1; // the reaction index of the active reaction
-				int dr_index = -1; // the delayed reaction index of the active reaction
-				is_delayed = false; // whether or not the reaction is delayed
-				
-				// calculate the minimum delta using non-delayed reactions
-				for (unsigned int i = 0; i < cells; i++) {
-					for (int j = 0; j < reactions; j++) {
-						if (a[i][j] != 0) {
-							double delta_temp = (Pk[i][j] - Tk[i][j]) / a[i][j];
-							if (delta_temp < delta) {
-								delta = delta_temp;
-								cell_index = i;
-								reaction_index = j;
-							}
-						}
-					}
-				}
-				
-				// calculate the minimum delta using delayed reactions
-				for (unsigned int i = 0; i < cells; i++) {
-					for (int d = 0; d < num_of_delayed_reactions; d++) {
-						if (!rq[i][d].empty()) {
-							double delta_temp = rq[i][d].front() - T[chunk_index];
-							if (delta_temp < delta) {
-								delta = delta_temp;
-								cell_index = i;
-								reaction_index = delayed_reactions[d];
-								dr_index = d;
-								is_delayed = true;
-							}
-						}
-					}
-				}
-				
-				// update the simulation timestep
-				T[chunk_index] += delta;
-				
-				// update the concentrations and appropriate delayed list if necessary
-				int cell_offset = cell_index * species;
-				if (is_delayed) { 
-				    // if the current reaction is delayed then update the concentrations according to delayed update values
-					cx[cell_offset + species_update_indices_delayed[dr_index]]++;
-					
-					// remove the current reaction from its delayed list
-					if (!rq[cell_index][dr_index].empty()) {
-						rq[cell_index][dr_index].pop_front();
-						if (appx) { 
-						    /* 
-						       if tau-leaping is also activated (if -a or --algorithm is set to "appx") 
-						       then update the firings and span list as well
-							*/
-							rq_idl[cell_index][dr_index].pop_front();
-						}
-					}
-				} else { 
-				    /* 
-				       if the current reaction isn't a delayed one finishing 
-				       then update the concentrations according to non-delayed update values
-					   if the reaction is a delayed one starting then add it to the corresponding delayed reactions list
-					*/
-					bool do_update = true;
-					for (int d = 0; d < num_of_delayed_reactions; d++) {
-						if (reaction_index == delayed_reactions[d]) {
-							try {
-								rq[cell_index][d].push_back(T[chunk_index] + delay_times[d]);
-								if (appx) {
-									rq_idl[cell_index][d].push_back(rq_node(1, delta));
-								}
-							} catch (bad_alloc) { // if there isn't enough memory to allocate a new list index then exit the program
-								cout << terminal_no_memory << endl;
-								exit(1);
-							}
-							do_update = false; // don't update the concentrations if the reaction is a delayed one starting
-							break;
-						}
-					}
-					
-					// if the reaction is not a delayed one starting then update the concentrations according to non-delayed update values
-					if (do_update) {
-						int end = species_update_indices[reaction_index][0];
-						for (int i = 1; i <= end; i++) {
-							int species_index = species_update_indices[reaction_index][i];
-							cx[cell_offset + species_index] += species_update_values[species_index][reaction_index];
-						}
-					}
-					
-					// update the appropriate Pk with a new random value
-					Pk[cell_index][reaction_index] += pk_dist(); // log(1 / unif_dist())
-				}
-				
-				// update every Tk value according to delta and the propensity values
-				for (unsigned int i = 0; i < cells; i++) {
-					for (int j = 0; j < reactions; j++) {
-						Tk[i][j] += a[i][j] * delta;
-					}
-				}
-			}
-			
-			/*
-			Print the results:
-			1) If the difference in simulation time exceeds the granularity 
-			   (0.1 minutes by default, but can be changed with -g or --granularity) then do the following:
-			2) If the sum of the concentrations is negative then something went wrong and the simulation ends prematurely
-			3) Increment the chunk index so the current one can be stored without being overwritten
-			4) If the the final chunk index has been reached or the difference in simulation time warrants printing 
-			   (60 minutes by default, but can be changed with -p or --print):
-				a) Print every chunk element from 1 to chunk_index
-				b) Reset the chunk index to 1
-				c) Wrap the most recent concentration levels and simulation timestep back to index 1 
-				   so they can be considered the previous ones
-			*/
-			
-			// if the difference in timesteps exceeds the granularity then move to the next index in the chunk
-			if (T[chunk_index] - T[chunk_index - 1] >= granularity) {
-				// if the sum of the concentration values is less than 0 then end the simulation
-				int sum = 0;
-				for (unsigned int i = 0; i < cells; i++) {
-					for (int j = 0; j < species; j++) {
-						sum += x[chunk_index][i * species + j];
-					}
-				}
-				if (sum < 0) {
-					break;
-				}
-				
-				// move to the next chunk index
-				int prev_ci = chunk_index;
-				chunk_index++;
-				
-				// at the end of each chunk
-				if (chunk_index == chunk || (T[chunk_index - 1] - last_print >= print_interval)) {
-					// print the current chunk's results
-					store_results(&ofile[r], x, T, cells, chunk_index, r, con_level);
-					
-					// reset the chunk
-					last_print = T[prev_ci];
-					T[0] = T[chunk_index - 1];
-					chunk_index = 1;
-				}
-				
-				// wrap around the concentration levels and simulation timestep so they can be considered the previous ones
-				for (unsigned int i = 0; i < cells; i++) {
-					for (int j = 0; j < species; j++) {
-						x[chunk_index][i * species + j] = x[prev_ci][i * species + j];
-					}
-				}
-				cx = x[chunk_index];
-				T[chunk_index] = T[prev_ci];
-			}
+		init_condition(&conditions[0], &pars, 0, mutant_wt);
+		for (int d = 0; d < num_of_delayed_reactions; d++) {
+			conditions[0].delay_times[d] = delay_times[d];
 		}
-		
-		// free any delayed reactions from their list
-		for (unsigned int i = 0; i < cells; i++) {
-			for (int d = 0; d < num_of_delayed_reactions; d++) {
-				while (!rq[i][d].empty()) {
-					rq[i][d].pop_front();
-					if (appx) {
-						rq_idl[i][d].pop_front();
-					}
-				}
-			}
+	}
+	for (unsigned int c = 0; c < num_conditions; c++) {
+		conditions[c].leaping = leaping;
+	}
+	
+	ofstream ofile[runs]; // the array of file streams
+	if (print_runs) {
+		create_output(output_path, ofile);
+	} else if (mkdir(output_path, 0755) != 0 && errno != EEXIST) { // only the features file is printed, so only the output directory is needed
+		cout << terminal_red << "Couldn't create " << output_path << " directory!" << terminal_reset << endl;
+		exit(1);
+	}
+	run_features* features = NULL; // the oscillation features of each run of each condition
+	if (ofeat_file != NULL) {
+		try {
+			features = new run_features[num_conditions * runs];
+		} catch (bad_alloc) { // if there isn't enough memory to allocate the features then exit the program
+			cout << terminal_no_memory << endl;
+			exit(1);
+		}
+	}
+	run_stats* stats = NULL; // the hot-path statistics of each run of each condition
+	if (print_stats) {
+		try {
+			stats = new run_stats[num_conditions * runs];
+		} catch (bad_alloc) { // if there isn't enough memory to allocate the statistics then exit the program
+			cout << terminal_no_memory << endl;
+			exit(1);
 		}
+	}
 
-		// close the output file and indicate the end of the run
-		store_results(&ofile[r], x, T, cells, chunk_index + 1, r, con_level);
-		ofile[r].close();
-		cout << terminal_done << endl;
-		cout.flush();
+	/*
+	Run the simulations:
+	1) Gather the settings every run shares
+	2) Autotune the leaping settings of every condition if a cache file is given with -d or --autotune (see autotune.h)
+	3) Simulate every run (by default 1, but can be changed with -r or --runs) of every condition on a pool of worker threads (by default 1, but can be changed with -n or --threads),
+	   each of which initializes and simulates one run at a time until every run is finished (see simulation.cpp)
+	   (or, when evaluating parameter sets with -v or --evaluate, each of which simulates one parameter set at a time until it passes or fails, see evaluation.h)
+	4) When every run is finished, print whether each parameter set passed if they were evaluated, the hot-path statistics if they were counted, and the oscillation features if they were computed
+	   (by default they aren't, but -f or --ofeatures turns them on)
+	5) Clear the memory allocated for the input and output paths
+	*/
+	
+	sim_constants sc;
+	sc.cells = cells;
+	sc.width = xcells;
+	sc.height = ycells;
+	sc.neighbors = neighbors;
+	sc.nc = nc;
+	sc.max_minutes = max_minutes;
+	sc.max_timesteps = max_timesteps;
+	sc.granularity = granularity;
+	sc.print_interval = print_interval;
+	sc.con_level = con_level;
+	sc.binary = binary;
+	sc.print_runs = print_runs;
+	sc.quiet = false;
+	sc.features = features;
+	sc.stats = stats;
+	sc.chunk = max_minutes / granularity + 1;
+	int chunk_limit = chunk_memory * MB / (output_buffers * cells * species * sizeof(int)); // large tissues store fewer concentration snapshots and print them more often
+	if (sc.chunk > chunk_limit) {
+		sc.chunk = chunk_limit > 3 ? chunk_limit : 3;
+	}
+	sc.seed = seed;
+	sc.runs = runs;
+	sc.num_conditions = num_conditions;
+	sc.conditions = conditions;
+	sc.ofile = ofile;
+	sc.evaluate = evaluate;
+	sc.conditions_per_set = num_mutants;
+	sc.evaluations = NULL;
+	if (evaluate) {
+		try {
+			sc.evaluations = new set_evaluation[num_conditions / num_mutants];
+		} catch (bad_alloc) { // if there isn't enough memory to allocate the evaluations then exit the program
+			cout << terminal_no_memory << endl;
+			exit(1);
+		}
+	}
+	
+	if (autotune_file != NULL) {
+		autotune(&sc, threads, autotune_file);
+		free(autotune_file);
+	}
+	simulate_runs(&sc, threads);
+	
+	if (evaluate) {
+		store_evaluations(output_path, "evaluation.csv", sc.evaluations, num_conditions / num_mutants);
+		delete[] sc.evaluations;
 	}
 	
-	memory_dealloc(x, T, input_file, output_path, chunk);	
+	if (stats != NULL) {
+		store_stats(output_path, "stats.json", stats, runs, conditions, num_conditions, batch_file != NULL);
+		delete[] stats;
+	}
+	if (features != NULL) {
+		store_features(output_path, ofeat_file, features, runs, batch_file != NULL ? conditions : NULL, num_conditions);
+		delete[] features;
+		free(ofeat_file);
+	}
+	delete[] conditions;
+	if (batch_file != NULL) {
+		free(batch_file);
+	}
+	if (mutant_list != NULL) {
+		free(mutant_list);
+	}
+	if (leap_list != NULL) {
+		free(leap_list);
+	}
+	
+	strings_dealloc(input_file, output_path);
+	delete[] nc;
+	
 	return 0;
 }
 
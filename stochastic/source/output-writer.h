@@ -0,0 +1,209 @@
+/*
+Stochastic simulator for zebrafish segmentation
+Copyright (C) 2012 Ahmet Ay, Jack Holland, Adriana Sperlea
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/*
+Every worker prints its runs' results on its own output thread, so simulating never waits for a chunk to be formatted and written.
+A worker owns output_buffers chunks of concentration snapshots (x and T). It fills one chunk while the output thread prints the others:
+a full chunk is handed to the output thread through the filled queue, and the output thread hands each chunk it has printed back through the empty queue.
+Both queues have exactly one producer and one consumer, so pushing and popping only need atomic indices, not locks.
+A side that finds its queue empty sleeps on a condition variable until the other side pushes, which happens at most once per printed chunk.
+Because a worker can't take a new chunk until one has been printed, a slow disk holds the simulation back instead of letting unprinted chunks pile up.
+The output thread also feeds every chunk to the worker's feature_extractor when oscillation features are wanted (see features.h).
+*/
+
+#ifndef OUTPUT_WRITER_H
+#define OUTPUT_WRITER_H
+
+#include <atomic>
+#include <condition_variable>
+#include <fstream>
+#include <mutex>
+#include <thread>
+
+#include "features.h"
+#include "file-io.h"
+#include "macros.h"
+
+using namespace std;
+
+#define output_queue_capacity (output_buffers + 1) // every chunk plus the job that stops the output thread
+
+// a chunk to print, or a request for the output thread to stop
+struct output_job {
+	int buffer; // the index of the chunk in the worker's buffers
+	ofstream* file; // the run's output file, NULL if it isn't printed
+	int chunk; // the number of entries to print plus 1 (see store_results)
+	int run; // the run's index (for error messages)
+	int cells; // the number of cells in each entry
+	int con_level; // the index of the concentration level to print
+	bool binary; // whether or not to print binary records
+	bool print; // whether or not to print the chunk to the file (it isn't with -e or --features-only)
+	run_features* features; // where to store the run's oscillation features once its last chunk is done, NULL if they aren't wanted
+	bool close; // whether or not this is the run's last chunk, after which its file is closed and its features are stored
+	bool stop; // whether or not the output thread should stop (every job before this one is printed first)
+
+	output_job () {
+		this->buffer = -1;
+		this->file = NULL;
+		this->chunk = 0;
+		this->run = 0;
+		this->cells = 0;
+		this->con_level = 0;
+		this->binary = false;
+		this->print = true;
+		this->features = NULL;
+		this->close = false;
+		this->stop = false;
+	}
+};
+
+// a lock-free ring buffer of jobs with one producer thread and one consumer thread
+struct output_queue {
+	output_job jobs[output_queue_capacity];
+	atomic<unsigned int> head; // the number of jobs popped (only changed by the consumer)
+	atomic<unsigned int> tail; // the number of jobs pushed (only changed by the producer)
+
+	output_queue () : head(0), tail(0) {}
+
+	// add a job to the back of the queue, returning false if the queue is full
+	bool push (const output_job& job) {
+		unsigned int t = this->tail.load(memory_order_relaxed);
+		if (t - this->head.load(memory_order_acquire) == output_queue_capacity) {
+			return false;
+		}
+		this->jobs[t % output_queue_capacity] = job;
+		this->tail.store(t + 1, memory_order_release); // publishes the job to the consumer
+		return true;
+	}
+
+	// remove the job at the front of the queue, returning false if the queue is empty
+	bool pop (output_job* job) {
+		unsigned int h = this->head.load(memory_order_relaxed);
+		if (h == this->tail.load(memory_order_acquire)) {
+			return false;
+		}
+		*job = this->jobs[h % output_queue_capacity];
+		this->head.store(h + 1, memory_order_release); // gives the slot back to the producer
+		return true;
+	}
+
+	// the number of jobs in the queue
+	unsigned int size () {
+		return this->tail.load(memory_order_acquire) - this->head.load(memory_order_acquire);
+	}
+};
+
+struct output_writer {
+	int*** x; // the concentrations of each chunk
+	double** T; // the timesteps of each chunk
+	feature_extractor* extractor; // computes oscillation features from the chunks, NULL if they aren't wanted
+	output_queue filled; // chunks waiting to be printed (pushed by the worker, popped by the output thread)
+	output_queue empty; // chunks that have been printed (pushed by the output thread, popped by the worker)
+	mutex sleep_mutex; // only used to sleep and wake, never held while a queue is used
+	condition_variable wake; // signaled whenever either queue is pushed to
+	thread printer; // the output thread
+
+	// start printing the given chunks on a new thread, every one of which starts empty
+	void start (int*** x, double** T, feature_extractor* extractor) {
+		this->x = x;
+		this->T = T;
+		this->extractor = extractor;
+		for (int b = 0; b < output_buffers; b++) {
+			output_job job;
+			job.buffer = b;
+			this->empty.push(job);
+		}
+		this->printer = thread(&output_writer::run, this);
+	}
+
+	// print every chunk handed to the output thread so far, close their files, and end the thread
+	void stop () {
+		output_job job;
+		job.stop = true;
+		this->submit(job);
+		this->printer.join();
+	}
+
+	// take a chunk to fill, waiting for the output thread to finish printing one if none are free
+	int acquire () {
+		output_job job;
+		this->wait_until([&] { return this->empty.pop(&job); });
+		return job.buffer;
+	}
+
+	// hand a job to the output thread (the worker mustn't change the job's chunk until it acquires it again)
+	void submit (const output_job& job) {
+		this->wait_until([&] { return this->filled.push(job); });
+		this->notify();
+	}
+
+	// wait until the output thread has handed back every chunk, so every job given to it is done and the last run's features are stored
+	void drain () {
+		this->wait_until([&] { return this->empty.size() == output_buffers; });
+	}
+
+	// the output thread's loop, which prints chunks until it's told to stop
+	void run () {
+		while (true) {
+			output_job job;
+			this->wait_until([&] { return this->filled.pop(&job); });
+			if (job.stop) {
+				return;
+			}
+			if (job.print) {
+				store_results(job.file, this->x[job.buffer], this->T[job.buffer], job.cells, job.chunk, job.run, job.con_level, job.binary);
+			}
+			if (job.features != NULL) {
+				for (int sn = 1; sn < job.chunk; sn++) {
+					this->extractor->add(this->T[job.buffer][sn], this->x[job.buffer][sn], job.con_level);
+				}
+			}
+			if (job.close) {
+				if (job.file != NULL && job.file->is_open()) {
+					job.file->close();
+				}
+				if (job.features != NULL) {
+					this->extractor->finish(job.features);
+				}
+			}
+			this->empty.push(job); // can't fail since there are never more chunks than the queue holds
+			this->notify();
+		}
+	}
+
+	// return as soon as ready() is true, sleeping between checks until the other thread pushes to a queue
+	template <typename F>
+	void wait_until (F ready) {
+		if (ready()) {
+			return;
+		}
+		unique_lock<mutex> lock(this->sleep_mutex);
+		this->wake.wait(lock, ready);
+	}
+
+	// wake the other thread if it's sleeping (taking the mutex ensures a thread that has just checked its queue is already waiting)
+	void notify () {
+		{
+			lock_guard<mutex> lock(this->sleep_mutex);
+		}
+		this->wake.notify_all();
+	}
+};
+
+#endif
+
@@ -20,43 +20,283 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #define RAND_DIST_H
 
 #include <math.h>
+#include <stdint.h>
+
+/*
+The random number engine, xoshiro256++, as described in
+"Scrambled linear pseudorandom number generators" by Blackman and Vigna, ACM Transactions on Mathematical Software, 2021
+It has 256 bits of state, a period of 2^256 - 1, and produces 64 bits per step.
+jump advances the engine by 2^128 steps, so the streams made by jumping from one seed never overlap in any realistic simulation.
+The distributions below take the engine as a template parameter, so any struct with the same next and fill_unif functions can be plugged in instead.
+*/
+struct xoshiro256pp {
+	uint64_t s[4]; // the state
+	
+	explicit xoshiro256pp (uint64_t seed) {
+		// expand the seed into the state with splitmix64, which never produces the invalid all-zero state from a 64 bit seed
+		for (int i = 0; i < 4; i++) {
+			seed += 0x9e3779b97f4a7c15ULL;
+			uint64_t z = seed;
+			z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+			z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+			this->s[i] = z ^ (z >> 31);
+		}
+	}
+	
+	static uint64_t rotl (uint64_t x, int k) {
+		return (x << k) | (x >> (64 - k));
+	}
+	
+	// the next 64 random bits
+	uint64_t next () {
+		uint64_t result = rotl(this->s[0] + this->s[3], 23) + this->s[0];
+		uint64_t t = this->s[1] << 17;
+		this->s[2] ^= this->s[0];
+		this->s[3] ^= this->s[1];
+		this->s[1] ^= this->s[2];
+		this->s[0] ^= this->s[3];
+		this->s[2] ^= t;
+		this->s[3] = rotl(this->s[3], 45);
+		return result;
+	}
+	
+	// fill out with n uniform doubles from 0.0-1.0 (the same values n calls to unif_dist would return)
+	void fill_unif (double* out, int n) {
+		for (int i = 0; i < n; i++) {
+			out[i] = (this->next() >> 11) * (1.0 / 9007199254740992.0); // the top 53 bits, divided by 2^53
+		}
+	}
+	
+	// advance the engine by 2^128 steps
+	void jump () {
+		static const uint64_t polynomial[4] = {0x180ec6d33cfd0abaULL, 0xd5a61266f0c9392cULL, 0xa9582618e03fc9aaULL, 0x39abdc4529b1661cULL};
+		uint64_t t[4] = {0, 0, 0, 0};
+		for (int i = 0; i < 4; i++) {
+			for (int b = 0; b < 64; b++) {
+				if (polynomial[i] & ((uint64_t)1 << b)) {
+					for (int j = 0; j < 4; j++) {
+						t[j] ^= this->s[j];
+					}
+				}
+				this->next();
+			}
+		}
+		for (int j = 0; j < 4; j++) {
+			this->s[j] = t[j];
+		}
+	}
+};
+
+/*
+The random number stream of one run.
+Every run's stream starts from the same seeded engine and is then jumped ahead once per run index, so the streams of different runs never overlap
+and runs can be simulated in any order (or at the same time) and still give the same results.
+*/
+struct rand_stream : xoshiro256pp {
+	rand_stream (unsigned int seed, unsigned int run) : xoshiro256pp(seed) {
+		for (unsigned int r = 0; r < run; r++) {
+			this->jump();
+		}
+	}
+	
+	explicit rand_stream (const xoshiro256pp& engine) : xoshiro256pp(engine) {}
+};
+
+/*
+The random number streams of the runs one worker simulates.
+Jumping from the seed costs one jump per run index, so doing it for every run of a large batch would take time quadratic in the number of runs;
+a worker takes its runs in increasing order, so this keeps the engine of its last run's stream and only jumps it ahead by the gap to the next one.
+A worker that goes back to earlier runs (evaluating a parameter set can, see evaluation.h) marks a checkpoint to start over from instead of the seed.
+Each stream is the same as rand_stream(seed, run) would be.
+*/
+struct stream_source {
+	unsigned int seed;
+	xoshiro256pp engine; // the engine of run index run's stream
+	unsigned int run;
+	xoshiro256pp mark; // the engine of run index mark_run's stream, which streams of earlier runs start over from
+	unsigned int mark_run;
+	
+	explicit stream_source (unsigned int seed) : seed(seed), engine(seed), run(0), mark(seed), mark_run(0) {}
+	
+	// the stream of the given run index, starting over from the checkpoint (or the seed if it's before that too) if it comes before the last one
+	rand_stream stream (unsigned int run) {
+		if (run < this->run) {
+			bool marked = run >= this->mark_run;
+			this->engine = marked ? this->mark : xoshiro256pp(this->seed);
+			this->run = marked ? this->mark_run : 0;
+		}
+		for (; this->run < run; this->run++) {
+			this->engine.jump();
+		}
+		return rand_stream(this->engine);
+	}
+	
+	// mark the given run index as the checkpoint
+	void checkpoint (unsigned int run) {
+		this->stream(run);
+		this->mark = this->engine;
+		this->mark_run = run;
+	}
+};
 
 // uniform distribution (returns a double from 0.0-1.0)
-inline double unif_dist () {
-	return rand() / (((double)RAND_MAX) + 1);
+template <typename engine> inline double unif_dist (engine* rng) {
+	return (rng->next() >> 11) * (1.0 / 9007199254740992.0); // the top 53 bits, divided by 2^53
+}
+
+/*
+The Poisson and binomial samplers below take an expected constant time no matter how large their mean is:
+small means are sampled by inversion (walking up the cumulative distribution from 0, which takes about mean + 1 steps),
+and larger means by the transformed rejection methods of
+"The transformed rejection method for generating Poisson random variables" by Hormann, Insurance: Mathematics and Economics, 1993 (PTRS) and
+"The generation of binomial random variates" by Hormann, J. of Statistical Computation and Simulation, 1993 (BTRS),
+which accept about 9 out of 10 candidates using two uniforms each.
+Binomials of only a few trials are still sampled one trial at a time, which is cheaper than either method's setup.
+*/
+#define rand_dist_inversion_mean 10 // the mean below which the Poisson and binomial samplers use inversion instead of transformed rejection
+#define rand_dist_bernoulli_n 16 // the number of trials below which the binomial sampler draws every trial instead
+
+// Poisson distribution by inversion (for small means)
+template <typename engine> inline int pois_inversion (engine* rng, double mean) {
+	while (true) {
+		double u = unif_dist(rng);
+		double p = exp(-mean); // P(X = x)
+		double cdf = p; // P(X <= x)
+		for (int x = 0; x < 1000; x++) {
+			if (u < cdf) {
+				return x;
+			}
+			p *= mean / (x + 1);
+			cdf += p;
+		}
+		// u was so close to 1 that rounding kept the cumulative probability below it, so draw again
+	}
+}
+
+// Poisson distribution by transformed rejection with squeeze (PTRS, for large means)
+template <typename engine> inline int pois_ptrs (engine* rng, double mean) {
+	double slam = sqrt(mean);
+	double loglam = log(mean);
+	double b = 0.931 + 2.53 * slam;
+	double a = -0.059 + 0.02483 * b;
+	double invalpha = 1.1239 + 1.1328 / (b - 3.4);
+	double vr = 0.9277 - 3.6224 / (b - 2);
+	while (true) {
+		double u = unif_dist(rng) - 0.5;
+		double v = unif_dist(rng);
+		double us = 0.5 - fabs(u);
+		double k = floor((2 * a / us + b) * u + mean + 0.43);
+		if (us >= 0.07 && v <= vr) { // the candidate is inside the squeeze, so accept it without evaluating the distribution
+			return (int)k;
+		}
+		if (k < 0 || (us < 0.013 && v > us)) {
+			continue;
+		}
+		if (log(v * invalpha / (a / (us * us) + b)) <= -mean + k * loglam - lgamma(k + 1)) {
+			return (int)k;
+		}
+	}
+}
+
+// Poisson distribution (returns an integer based on mean)
+template <typename engine> inline int pois_dist (engine* rng, double mean) {
+	if (mean <= 0) {
+		return 0;
+	}
+	return mean < rand_dist_inversion_mean ? pois_inversion(rng, mean) : pois_ptrs(rng, mean);
+}
+
+// binomial distribution by inversion (for small means, with p <= 0.5)
+template <typename engine> inline int bino_inversion (engine* rng, int n, double p) {
+	double q = 1 - p;
+	double s = p / q;
+	double a = (n + 1) * s;
+	while (true) {
+		double u = unif_dist(rng);
+		double r = pow(q, n); // P(X = x)
+		for (int x = 0; x <= n; x++) {
+			if (u < r) {
+				return x;
+			}
+			u -= r;
+			r *= a / (x + 1) - s;
+		}
+		// u was so close to 1 that rounding left some of it after every outcome, so draw again
+	}
+}
+
+// binomial distribution by transformed rejection with squeeze (BTRS, for large means, with p <= 0.5)
+template <typename engine> inline int bino_btrs (engine* rng, int n, double p) {
+	double q = 1 - p;
+	double spq = sqrt(n * p * q);
+	double b = 1.15 + 2.53 * spq;
+	double a = -0.0873 + 0.0248 * b + 0.01 * p;
+	double c = n * p + 0.5;
+	double vr = 0.92 - 4.2 / b;
+	double alpha = (2.83 + 5.1 / b) * spq;
+	double lpq = log(p / q);
+	double m = floor((n + 1) * p); // the mode
+	double h = lgamma(m + 1) + lgamma(n - m + 1);
+	while (true) {
+		double u = unif_dist(rng) - 0.5;
+		double v = unif_dist(rng);
+		double us = 0.5 - fabs(u);
+		double k = floor((2 * a / us + b) * u + c);
+		if (k < 0 || k > n) {
+			continue;
+		}
+		if (us >= 0.07 && v <= vr) { // the candidate is inside the squeeze, so accept it without evaluating the distribution
+			return (int)k;
+		}
+		if (log(v * alpha / (a / (us * us) + b)) <= h - lgamma(k + 1) - lgamma(n - k + 1) + (k - m) * lpq) {
+			return (int)k;
+		}
+	}
 }
 
 // binomial distribution (returns an integer from 0-n)
-inline int bino_dist (int n, double p) {
-	int x = 0;
-	for (int i = 0; i < n; i++) {
-		if (unif_dist() < p) {
-			x++;
+template <typename engine> inline int bino_dist (engine* rng, int n, double p) {
+	if (n <= 0 || p <= 0) {
+		return 0;
+	}
+	if (p >= 1) {
+		return n;
+	}
+	if (n < rand_dist_bernoulli_n) { // for a few trials, drawing each one is cheaper than either sampler's setup
+		int x = 0;
+		for (int i = 0; i < n; i++) {
+			if (unif_dist(rng) < p) {
+				x++;
+			}
 		}
+		return x;
+	}
+	if (p > 0.5) { // both samplers need p <= 0.5, so count the failures instead
+		return n - bino_dist(rng, n, 1 - p);
 	}
-	return x;
+	return n * p < rand_dist_inversion_mean ? bino_inversion(rng, n, p) : bino_btrs(rng, n, p);
 }
 
 // exponential distribution (returns a double based on mean)
-inline double expo_dist (double mean) {
-	return -log(1.0 - unif_dist()) / mean;
+template <typename engine> inline double expo_dist (engine* rng, double mean) {
+	return -log(1.0 - unif_dist(rng)) / mean;
 }
 
-// Poisson distribution (returns an integer based on mean)
-inline int pois_dist (double mean) {
-	double L = pow(M_E, -mean);
-	int k = 0;
-	double p = 1;
-	do {
-		k++;
-		p *= unif_dist();
-	} while (p > L);
-	return k - 1;
+// standard normal distribution, filling the given array with n draws (the Box-Muller transform turns each pair of uniforms into two independent normals)
+template <typename engine> inline void norm_dist_fill (engine* rng, double* out, int n) {
+	for (int i = 0; i < n; i += 2) {
+		double radius = sqrt(-2 * log(1.0 - unif_dist(rng)));
+		double angle = 2 * M_PI * unif_dist(rng);
+		out[i] = radius * cos(angle);
+		if (i + 1 < n) {
+			out[i + 1] = radius * sin(angle);
+		}
+	}
 }
 
 // Pk distribution, which is just a logarithmic uniform distribution
-inline double pk_dist () {
-	return log(1 / unif_dist());
+template <typename engine> inline double pk_dist (engine* rng) {
+	return log(1 / unif_dist(rng));
 }
 
 #endif
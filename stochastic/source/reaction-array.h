@@ -0,0 +1,71 @@
+/*
+Stochastic simulator for zebrafish segmentation
+Copyright (C) 2012 Ahmet Ay, Jack Holland, Adriana Sperlea
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/*
+Per-reaction state of every cell stored as a structure of arrays: array[k][i] is the value of reaction k in cell i.
+Each reaction's values for every cell are contiguous and start on a cache line, so loops over the cells of one reaction
+(like bringing every Tk up to date before a tau-leap) walk memory in order and can be vectorized.
+Rows shorter than a cache line are packed together instead, so the state of a two-cell system takes a few cache lines rather than one per reaction and stays in L1.
+The rows share one heap block, so even tissues with hundreds of thousands of cells need only a single allocation per array.
+*/
+
+#ifndef REACTION_ARRAY_H
+#define REACTION_ARRAY_H
+
+#include <new>
+#include <stdlib.h>
+
+#include "macros.h"
+
+template <typename T>
+struct reaction_array {
+	T* data; // the rows of every reaction, one after the other
+	int stride; // the distance between the starts of two rows (the number of cells rounded up to a whole cache line, unless a row is shorter than one)
+	
+	reaction_array () {
+		this->data = NULL;
+		this->stride = 0;
+	}
+	
+	~reaction_array () {
+		free(this->data);
+	}
+	
+	// allocate a row of the given number of cells for every reaction, or for the given number of rows (throws bad_alloc if there isn't enough memory)
+	void allocate (int cells, int rows = reactions) {
+		int per_line = cache_line / sizeof(T);
+		this->stride = cells < per_line ? cells : (cells + per_line - 1) / per_line * per_line;
+		void* block;
+		if (posix_memalign(&block, cache_line, (size_t)rows * this->stride * sizeof(T)) != 0) {
+			throw std::bad_alloc();
+		}
+		this->data = (T*)block;
+	}
+	
+	// the values of reaction k, indexed by cell
+	T* operator[] (int k) {
+		return this->data + k * this->stride;
+	}
+	
+	const T* operator[] (int k) const {
+		return this->data + k * this->stride;
+	}
+};
+
+#endif
+
@@ -0,0 +1,137 @@
+/*
+Stochastic simulator for zebrafish segmentation
+Copyright (C) 2012 Ahmet Ay, Jack Holland, Adriana Sperlea
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/*
+An indexed binary min-heap of putative firing times for the next-reaction-method, as described in
+"Efficient exact stochastic simulation of chemical systems with many species and many channels" by Gibson and Bruck, J. of Physical Chemistry A, 2000
+
+Every non-delayed reaction of every cell and the head of every delayed reaction queue of every cell has exactly one entry.
+Entries are numbered as follows:
+	cell * reactions + reaction							for the putative firing times of the reactions
+	cells * reactions + cell * num_of_delayed_reactions + d	for the firing times of the heads of the delayed reaction queues
+An entry that can't fire (a propensity of 0 or an empty delayed reaction queue) is stored with a time of INFINITY.
+Ties are broken by the entry number, which gives the same choice as scanning the reactions in order and then the delayed reaction queues in order.
+*/
+
+#ifndef REACTION_HEAP_H
+#define REACTION_HEAP_H
+
+#include <math.h>
+
+struct reaction_heap {
+	int size; // the number of entries in the heap
+	double* times; // the absolute firing time of each entry, indexed by entry
+	int* heap; // the entries ordered as a binary heap, heap[0] fires first
+	int* position; // the index of each entry in heap
+
+	explicit reaction_heap (int size) {
+		this->size = size;
+		this->times = new double[size];
+		this->heap = new int[size];
+		this->position = new int[size];
+		for (int e = 0; e < size; e++) {
+			this->times[e] = INFINITY;
+			this->heap[e] = e;
+			this->position[e] = e;
+		}
+	}
+
+	~reaction_heap () {
+		delete[] this->times;
+		delete[] this->heap;
+		delete[] this->position;
+	}
+
+	// the entry that fires first
+	int top () const {
+		return this->heap[0];
+	}
+
+	// whether or not entry e should fire before entry f
+	bool earlier (int e, int f) const {
+		return this->times[e] < this->times[f] || (this->times[e] == this->times[f] && e < f);
+	}
+
+	// change the firing time of entry e and move it to its new place in the heap
+	void update (int e, double time) {
+		double old = this->times[e];
+		this->times[e] = time;
+		if (time < old) {
+			this->sift_up(this->position[e]);
+		} else if (time > old) {
+			this->sift_down(this->position[e]);
+		}
+	}
+
+	// re-order the whole heap after its times have been set directly (e.g. after a tau-leap changed every propensity)
+	void build () {
+		for (int e = 0; e < this->size; e++) {
+			this->heap[e] = e;
+			this->position[e] = e;
+		}
+		for (int i = this->size / 2 - 1; i >= 0; i--) {
+			this->sift_down(i);
+		}
+	}
+
+	void sift_up (int i) {
+		int e = this->heap[i];
+		while (i > 0) {
+			int parent = (i - 1) / 2;
+			int p = this->heap[parent];
+			if (!this->earlier(e, p)) {
+				break;
+			}
+			this->heap[i] = p;
+			this->position[p] = i;
+			i = parent;
+		}
+		this->heap[i] = e;
+		this->position[e] = i;
+	}
+
+	void sift_down (int i) {
+		int e = this->heap[i];
+		while (true) {
+			int child = 2 * i + 1;
+			if (child >= this->size) {
+				break;
+			}
+			if (child + 1 < this->size && this->earlier(this->heap[child + 1], this->heap[child])) {
+				child++;
+			}
+			int c = this->heap[child];
+			if (!this->earlier(c, e)) {
+				break;
+			}
+			this->heap[i] = c;
+			this->position[c] = i;
+			i = child;
+		}
+		this->heap[i] = e;
+		this->position[e] = i;
+	}
+};
+
+// the absolute time at which a non-delayed reaction will next fire, given its internal times Pk and Tk and its propensity a at simulation time t
+inline double putative_time (double t, double Pk, double Tk, double a) {
+	return a != 0 ? t + (Pk - Tk) / a : INFINITY;
+}
+
+#endif
+
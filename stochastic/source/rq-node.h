@@ -20,10 +20,14 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #define RQ_NODE_H
 
 struct rq_node {
-	int firings;
-	double span;
+	double time; // the earliest time at which the delayed reaction fires
+	int firings; // the number of firings merged into this node (used for id-leaping)
+	double span; // the length of time over which those firings were started (used for id-leaping)
 	
-	rq_node (int firings, double span) {
+	rq_node () {}
+	
+	rq_node (double time, int firings, double span) {
+		this->time = time;
 		this->firings = firings;
 		this->span = span;
 	}
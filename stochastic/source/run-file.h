@@ -0,0 +1,160 @@
+/*
+Stochastic simulator for zebrafish segmentation
+Copyright (C) 2012 Ahmet Ay, Jack Holland, Adriana Sperlea
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/*
+The formats of the run files the stochastic simulator prints and the analysis tools read.
+A text run file starts with a "width height" line followed by one line per printed timestep: the time and then the concentration of every cell, separated by tabs.
+A binary run file (printed with -b or --binary) starts with a run_file_header followed by one record per printed timestep:
+the time as a double and then the concentration of every cell as an int32_t, in cell order, with every value in the byte order of the machine that printed it.
+Binary records have a fixed size and need no formatting or parsing, and their times aren't rounded to 6 significant digits like the text ones.
+run_reader reads either format, so the analysis tools accept both.
+*/
+
+#ifndef RUN_FILE_H
+#define RUN_FILE_H
+
+#include <fstream>
+#include <stdint.h>
+#include <string>
+#include <string.h>
+
+#define run_file_magic "SCRUN01" // the first 8 bytes of every binary run file (including the terminating null)
+
+struct run_file_header {
+	char magic[8]; // run_file_magic
+	int32_t width; // the tissue width in cells
+	int32_t height; // the tissue height in cells
+	int32_t con_level; // the index of the species whose concentration level is printed (see -l or --con-level)
+	int32_t reserved; // keeps granularity 8-byte aligned, always 0
+	double granularity; // the minimum amount of simulated time between printed timesteps
+
+	run_file_header () {
+		memset(this, 0, sizeof(run_file_header));
+	}
+
+	run_file_header (int width, int height, int con_level, double granularity) {
+		memset(this, 0, sizeof(run_file_header));
+		memcpy(this->magic, run_file_magic, sizeof(this->magic));
+		this->width = width;
+		this->height = height;
+		this->con_level = con_level;
+		this->granularity = granularity;
+	}
+
+	bool valid () const {
+		return memcmp(this->magic, run_file_magic, sizeof(this->magic)) == 0;
+	}
+};
+
+// the size in bytes of one binary record with the given number of cells
+inline long run_record_size (int cells) {
+	return sizeof(double) + (long)cells * sizeof(int32_t);
+}
+
+/*
+Reads a text or binary run file value by value, so the analysis tools can read both with the same loops.
+For text files every read is the same stream extraction the tools used before binary files existed, so their results don't change.
+*/
+struct run_reader {
+	std::ifstream file;
+	bool binary; // whether or not the file is a binary run file
+	int width;
+	int height;
+	long end; // the size of a binary file in bytes
+
+	run_reader () {
+		this->binary = false;
+		this->width = 0;
+		this->height = 0;
+		this->end = 0;
+	}
+
+	// open the file and read its header, returning false if the file couldn't be opened
+	bool open (const char* filename) {
+		this->file.open(filename, std::fstream::in | std::fstream::binary);
+		if (!this->file.is_open()) {
+			return false;
+		}
+		this->file.seekg(0, std::ios::end);
+		this->end = this->file.tellg();
+		this->file.seekg(0, std::ios::beg);
+
+		run_file_header header;
+		this->file.read((char*)&header, sizeof(header));
+		this->binary = this->file.gcount() == (std::streamsize)sizeof(header) && header.valid();
+		if (this->binary) {
+			this->width = header.width;
+			this->height = header.height;
+		} else { // a text file starts with its width and height
+			this->file.clear();
+			this->file.seekg(0, std::ios::beg);
+			this->file >> this->width >> this->height;
+		}
+		return true;
+	}
+
+	void close () {
+		this->file.close();
+	}
+
+	// the number of lines in a text file (counting the header and the empty line after the last newline) or the number of records in a binary file plus 2, so the tools can size their arrays the same way for either format
+	int lines (const char* filename) {
+		if (this->binary) {
+			return (this->end - sizeof(run_file_header)) / run_record_size(this->width * this->height) + 2;
+		}
+		std::ifstream counter(filename, std::fstream::in);
+		std::string line;
+		int count = 0;
+		while (!counter.eof()) {
+			std::getline(counter, line);
+			count++;
+		}
+		return count;
+	}
+
+	bool eof () {
+		if (this->binary) {
+			return this->file.eof() || this->file.tellg() >= this->end;
+		}
+		return this->file.eof();
+	}
+
+	// read the time at the start of a timestep
+	void read_time (double& time) {
+		if (this->binary) {
+			this->file.read((char*)&time, sizeof(double));
+		} else {
+			this->file >> time;
+		}
+	}
+
+	// read the concentration of the next cell
+	void read_value (double& value) {
+		if (this->binary) {
+			int32_t count;
+			if (this->file.read((char*)&count, sizeof(int32_t))) {
+				value = count;
+			}
+		} else {
+			this->file >> value;
+		}
+	}
+};
+
+#endif
+
@@ -0,0 +1,102 @@
+/*
+Stochastic simulator for zebrafish segmentation
+Copyright (C) 2012 Ahmet Ay, Jack Holland, Adriana Sperlea
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/*
+Hot-path statistics count what each run's algorithms do and time where tau-leaping spends its time, so the leaping settings (see leap-settings.h) can be tuned from data.
+They are only compiled in when SIM_STATS is defined (scons stats=1), and are printed with -z or --stats to stats.json in the output directory, one object per run.
+Without SIM_STATS every stat_ macro expands to nothing, so the hot paths compile exactly as they would without the statistics.
+Next-reaction-method steps are counted but not timed, since timing steps that short would cost more than the steps themselves;
+their time is roughly the total minus every timed phase.
+*/
+
+#ifndef RUN_STATS_H
+#define RUN_STATS_H
+
+#include <chrono>
+
+using namespace std;
+
+typedef chrono::steady_clock stats_clock;
+
+#ifdef SIM_STATS
+#define stats_compiled true
+#define stat_add(field, n) (stats.field += (n)) // add n to a counter of the run's statistics
+#define stat_peak(field, n) (stats.field = stats.field > (unsigned long)(n) ? stats.field : (unsigned long)(n)) // raise a counter of the run's statistics to n if n is more
+#define stat_timer(name) stats_clock::time_point name = stats_clock::now() // start a timer
+#define stat_time(field, start) (stats.field += chrono::duration<double>(stats_clock::now() - (start)).count()) // add the seconds since a timer started to a timer of the run's statistics
+#else
+#define stats_compiled false
+#define stat_add(field, n)
+#define stat_peak(field, n)
+#define stat_timer(name)
+#define stat_time(field, start)
+#endif
+
+// the statistics of one run
+struct run_stats {
+	bool simulated; // whether or not the run was simulated (evaluating parameter sets can skip runs, see evaluation.h)
+	unsigned long nrm_steps; // the number of next-reaction-method steps
+	unsigned long nrm_delayed; // the number of those steps that finished a delayed reaction
+	unsigned long hybrid_steps; // the number of timesteps hybrid simulation integrated its continuous reactions over
+	unsigned long langevin_steps; // the number of timesteps of chemical Langevin simulation
+	unsigned long leaps; // the number of tau-leaps taken
+	unsigned long explicit_leaps; // the number of those leaps that were explicit
+	unsigned long implicit_leaps; // the number of those leaps that were implicit
+	unsigned long repeats; // the number of leaps rejected because a concentration would have become negative (each of which halves tau1)
+	unsigned long skips; // the number of times tau1 was too small to leap, so the next-reaction-method took over for skip_steps steps
+	unsigned long poisson_draws; // the number of Poisson draws for the firings of non-critical reactions
+	unsigned long binomial_draws; // the number of binomial draws for the firings of delayed reactions released by id-leaping
+	unsigned long delay_pushes; // the number of nodes added to the delayed reaction queues
+	unsigned long delay_merges; // the number of leaps' delayed firings merged into the last node of their queue by id-leaping instead
+	unsigned long delay_queue_total; // the sum of the queues' lengths each time a node was added (divided by delay_pushes for the mean length)
+	unsigned long delay_queue_max; // the longest a queue was when a node was added
+	double tau_selection; // the seconds spent finding the critical reactions and tau
+	double firing; // the seconds spent drawing the firings of each leap and checking them for negative concentrations
+	double delay_release; // the seconds spent releasing finished delayed firings and queuing new ones while leaping
+	double propensity_update; // the seconds spent updating the concentrations and propensities after each leap
+	double output; // the seconds spent handing chunks to the output thread, including waiting for a free one (see output-writer.h)
+	double total; // the seconds the whole run took
+
+	run_stats () {
+		this->simulated = false;
+		this->nrm_steps = 0;
+		this->nrm_delayed = 0;
+		this->hybrid_steps = 0;
+		this->langevin_steps = 0;
+		this->leaps = 0;
+		this->explicit_leaps = 0;
+		this->implicit_leaps = 0;
+		this->repeats = 0;
+		this->skips = 0;
+		this->poisson_draws = 0;
+		this->binomial_draws = 0;
+		this->delay_pushes = 0;
+		this->delay_merges = 0;
+		this->delay_queue_total = 0;
+		this->delay_queue_max = 0;
+		this->tau_selection = 0;
+		this->firing = 0;
+		this->delay_release = 0;
+		this->propensity_update = 0;
+		this->output = 0;
+		this->total = 0;
+	}
+};
+
+#endif
+
@@ -0,0 +1,1099 @@
+/*
+Stochastic simulator for zebrafish segmentation
+Copyright (C) 2012 Ahmet Ay, Jack Holland, Adriana Sperlea
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/*
+We used the following articles and their associated algorithms to construct this simulation:
+"A modified next reaction method for simulating chemical systems with time dependent propensities and delays" by Anderson, J. of Chemical Physics, 2007
+"Adaptive explicit-implicit tau-leaping method with automatic tau selection" by Cao et al., J. of Chemical Physics, 2007
+"D-leaping: Accelerating stochastic simulation algorithms for reactions with delays" by Bayati et al., J. of Computational Physics, 2009
+"Improved delay-leaping simulation algorithm for biochemical reaction systems with delays" by Ni et al., J. of Chemical Physics, 2012
+*/
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <iostream>
+#include <math.h>
+#include <mutex>
+#include <new>
+#include <thread>
+#include <vector>
+
+#include "delay-queue.h"
+#include "batch.h"
+#include "dependencies.h"
+#include "evaluation.h"
+#include "features.h"
+#include "file-io.h"
+#include "langevin.h"
+#include "macros.h"
+#include "output-writer.h"
+#include "parameters.h"
+#include "rand-dist.h"
+#include "reaction-heap.h"
+#include "run-stats.h"
+#include "simulation.h"
+#include "stoichiometry.h"
+#include "updates.h"
+#include "utility.h"
+
+using namespace std;
+
+// global variables used in main.cpp and file-io.cpp
+extern char* terminal_blue;
+extern char* terminal_red;
+extern char* terminal_reset;
+
+/*
+Constant variables:
+These arrays and matrices do not change over the course of the simulation and contain information specific to the zebrafish segmentation notch pathway.
+*/
+
+const int delayed_reactions[num_of_delayed_reactions] = {0, 8, 14, 24, 26, 28, 32}; // list of delayed reaction indices
+
+const int initial_concentrations[species] = {0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0}; // initial (time=0) concentration values for each species
+
+const int species_update_indices[reactions][4] = {{0, 0, 0, 0}, {1, 4, 0, 0}, {2, 4, 8, 0}, {2, 4, 8, 0}, {3, 4, 5, 9}, {3, 4, 5, 9}, {3, 4, 6, 10}, {3, 4, 6, 10}, {0, 0, 0, 0}, {1, 5, 0, 0}, {2, 5, 11, 0}, {2, 5, 11, 0}, {3, 5, 6, 12}, {3, 5, 6, 12}, {0, 0, 0, 0}, {1, 6, 0, 0}, {2, 6, 13, 0}, {2, 6, 13, 0}, {1, 8, 0, 0}, {1, 9, 0, 0}, {1, 10, 0, 0}, {1, 11, 0, 0}, {1, 12, 0, 0}, {1, 13, 0, 0}, {0, 0, 0, 0}, {1, 7, 0, 0}, {0, 0, 0, 0}, {1, 0, 0, 0}, {0, 0, 0, 0}, {1, 1, 0, 0}, {1, 2, 0, 0}, {1, 2, 0, 0}, {0, 0, 0, 0}, {1, 3, 0, 0}}; // the species indices to update for each nChains of cells look like this:on-delayed reaction (the first value of each array is the number of species to update, so if the first value is 2 then only the next 2 indices are looked at to determine which species to update)
+
+const int species_update_indices_delayed[num_of_delayed_reactions] = {4, 5, 6, 7, 0, 1, 3}; // the species indices to update for each delayed reaction (in this system delayed reactions update only 1 species each so the structure is less complicated than the one above for non-delayed reactions)
+
+const int species_update_values[species][reactions] = // the values (i.e. number of molecules) to change each species by for each reaction
+//	  0   1   2   3   4   5   6   7   8   9  10  11  12  13  14  15  16  17  18  19  20  21  22  23  24  25  26  27  28  29  30  31  32  33
+       {{ 0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0, +1, -1,  0,  0,  0,  0,  0,  0},
+	{ 0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0, +1, -1,  0,  0,  0,  0},
+	{ 0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0, +1, -1,  0,  0},
+	{ 0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0, +1, -1},
+	{+1, -1, -2, +2, -1, +1, -1, +1,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0},
+	{ 0,  0,  0,  0, -1, +1,  0,  0, +1, -1, -2, +2, -1, +1,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0},
+	{ 0,  0,  0,  0,  0,  0, -1, +1,  0,  0,  0,  0, -1, +1, +1, -1, -2, +2,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0},
+	{ 0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0, +1, -1,  0,  0,  0,  0,  0,  0,  0,  0},
+	{ 0,  0, +1, -1,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0, -1,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0},
+	{ 0,  0,  0,  0, +1, -1,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0, -1,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0},
+	{ 0,  0,  0,  0,  0,  0, +1, -1,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0, -1,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0},
+	{ 0,  0,  0,  0,  0,  0,  0,  0,  0,  0, +1, -1,  0,  0,  0,  0,  0,  0,  0,  0,  0, -1,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0},
+	{ 0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0, +1, -1,  0,  0,  0,  0,  0,  0,  0,  0, -1,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0},
+	{ 0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0, +1, -1,  0,  0,  0,  0,  0, -1,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0}};
+
+const int par_eq_pairs[reactions] = {-1, -1, 3, 2, 5, 4, 7, 6, -1, -1, 11, 10, 13, 12, -1, -1, 17, 16, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1}; // if a reaction has a pair then the value at its index contains its pair's index, and if a reaction doesn't have a pair then the value at its index is -1
+
+// the propensities each reaction's firing could change, derived from the species each reaction updates (see dependencies.h)
+static dependency_graph dg(delayed_reactions, species_update_indices, species_update_indices_delayed);
+
+// the nonzero entries of species_update_values, so tau-leaping only walks the species and reactions that actually change (see stoichiometry.h)
+static stoichiometry st(species_update_values, delayed_reactions);
+
+static mutex cout_mutex; // keeps the workers' progress messages from interleaving
+
+sim_state::sim_state (int cells, int chunk, bool features, unsigned int seed) : rh(cells * reactions + cells * num_of_delayed_reactions), rq(cells, delay_arena::initial_capacity(cells)), streams(seed) {
+	this->chunk = chunk;
+	for (int b = 0; b < output_buffers; b++) {
+		memory_alloc(chunk, cells, &this->xs[b], &this->Ts[b]);
+	}
+	try {
+		this->Tk.allocate(cells);
+		this->Pk.allocate(cells);
+		this->Tk_time.allocate(cells);
+		this->a.allocate(cells);
+		this->firings.allocate(cells);
+		this->critical.allocate(cells);
+		this->continuous.allocate(cells);
+		this->ac.allocate(cells);
+		this->extent.allocate(cells);
+		this->delta_sums = new int[cells];
+	} catch (bad_alloc) { // if there isn't enough memory to allocate the structures then exit the program
+		cout << terminal_no_memory << endl;
+		exit(1);
+	}
+	this->extractor = features ? new feature_extractor(cells) : NULL;
+	this->writer.start(this->xs, this->Ts, this->extractor);
+}
+
+sim_state::~sim_state () {
+	this->writer.stop(); // prints every chunk still waiting and closes its file
+	delete this->extractor;
+	for (int b = 0; b < output_buffers; b++) {
+		memory_dealloc(this->xs[b], this->Ts[b], this->chunk); // the per-reaction arrays free themselves
+	}
+	delete[] this->delta_sums;
+}
+
+// bring every lazily updated Tk up to the given time, which must happen before the propensities change across the whole tissue (by leaping or a hybrid step)
+static void catch_up_internal_times (sim_state* ss, unsigned int cells, double t) {
+	for (int k = 0; k < reactions; k++) {
+		double* tk = ss->Tk[k];
+		const double* ak = ss->a[k];
+		const double* tkt = ss->Tk_time[k];
+		for (unsigned int i = 0; i < cells; i++) {
+			tk[i] += ak[i] * (t - tkt[i]);
+		}
+	}
+}
+
+/*
+Partition one cell's reactions for hybrid simulation:
+a reaction is continuous if it isn't delayed, consumes at least one species (so her13 transcription, whose constant propensity no update_a* function recalculates, stays discrete),
+and every species it changes (its products as well as its reactants) has at least the threshold number of molecules, and discrete otherwise,
+since a species with few molecules needs its integer changes whether a reaction consumes or produces it.
+A continuous reaction's propensity is moved from a to ac, so the next-reaction-method never fires it (with a propensity of 0 its Tk stays put until it's discrete again,
+which keeps its remaining internal time exponential), and a reaction that becomes discrete drops the fraction of a firing it had integrated.
+*/
+static void partition_cell (sim_state* ss, unsigned int cell, int* cx, int threshold, double* a0) {
+	int xcell = cell * species;
+	for (int nd = 1; nd <= st.non_delayed[0]; nd++) {
+		int k = st.non_delayed[nd];
+		bool high = st.reactant_offsets[k] < st.reactant_offsets[k + 1];
+		for (int n = st.reaction_offsets[k]; high && n < st.reaction_offsets[k + 1]; n++) {
+			high = cx[xcell + st.reaction_species[n]] >= threshold;
+		}
+		if (!high && ss->continuous[k][cell]) {
+			ss->extent[k][cell] = 0;
+		}
+		ss->continuous[k][cell] = high;
+		if (high) {
+			ss->ac[k][cell] = ss->a[k][cell];
+			*a0 -= ss->a[k][cell];
+			ss->a[k][cell] = 0;
+		}
+	}
+}
+
+/*
+Integrate the continuous reactions of hybrid simulation over one timestep with Euler's method, as the deterministic simulator integrates every reaction:
+1) Add each continuous reaction's propensity times the timestep to its extent, fire it the whole number of times its extent has reached
+   (but never more than its reactants allow), and keep the fraction for the next step
+2) Recalculate every propensity (only after every cell has changed, since Delta protein reaches the neighbors) and repartition every cell
+*/
+static void integrate_continuous (sim_state* ss, unsigned int cells, double dt, parameters* p, int* cx, int neighbors, int (*nc)[7], int threshold, double* a0) {
+	for (unsigned int i = 0; i < cells; i++) {
+		int xcell = i * species;
+		for (int nd = 1; nd <= st.non_delayed[0]; nd++) {
+			int k = st.non_delayed[nd];
+			if (!ss->continuous[k][i]) {
+				continue;
+			}
+			double extent = ss->extent[k][i] + ss->ac[k][i] * dt;
+			int fire = (int)extent;
+			for (int n = st.reactant_offsets[k]; n < st.reactant_offsets[k + 1]; n++) {
+				int most = cx[xcell + st.reactant_species[n]] / -st.reactant_values[n];
+				if (fire > most) {
+					fire = most;
+				}
+			}
+			ss->extent[k][i] = extent - fire;
+			for (int n = st.reaction_offsets[k]; n < st.reaction_offsets[k + 1]; n++) {
+				cx[xcell + st.reaction_species[n]] += fire * st.reaction_values[n];
+				if (st.reaction_species[n] == 7) { // Delta protein reaches the neighbors
+					push_delta(ss->delta_sums, neighbors, nc[i], fire * st.reaction_values[n]);
+				}
+			}
+		}
+	}
+	for (unsigned int i = 0; i < cells; i++) {
+		update_all_propensities(ss->a, i, p, cx, neighbors, ss->delta_sums, a0);
+		partition_cell(ss, i, cx, threshold, a0);
+	}
+}
+
+// the job that hands the given chunk of job j to the output thread (see output-writer.h), where chunk is the number of entries to print plus 1
+static output_job chunk_job (sim_constants* sc, unsigned int j, int buffer, int chunk, bool last) {
+	output_job job;
+	job.buffer = buffer;
+	job.file = sc->print_runs ? &sc->ofile[j] : NULL;
+	job.chunk = chunk;
+	job.run = j;
+	job.cells = sc->cells;
+	job.con_level = sc->con_level;
+	job.binary = sc->binary;
+	job.print = sc->print_runs;
+	job.features = sc->features != NULL ? &sc->features[j] : NULL;
+	job.close = last;
+	return job;
+}
+
+/*
+Move a run to the next entry of its chunk once its simulation time has passed the last entry's by the granularity
+(0.1 minutes by default, but can be changed with -g or --granularity):
+1) If the sum of the concentrations is negative then something went wrong, so return false to end the simulation prematurely
+2) Increment the chunk index so the current one can be stored without being overwritten
+3) If the the final chunk index has been reached or the difference in simulation time warrants printing 
+   (60 minutes by default, but can be changed with -p or --print):
+	a) Hand every chunk element from 1 to chunk_index to the output thread
+	b) Take a free chunk (waiting if the output thread is still printing all of the others) and reset the chunk index to 1
+4) Wrap the most recent concentration levels and simulation timestep around to the new index so they can be considered the previous ones
+*/
+static bool next_entry (sim_constants* sc, sim_state* ss, unsigned int j, run_stats& stats, int& buffer, int**& x, double*& T, int& chunk_index, int& last_print) {
+	unsigned int cells = sc->cells;
+	
+	// if the sum of the concentration values is less than 0 then end the simulation
+	int sum = 0;
+	for (unsigned int i = 0; i < cells; i++) {
+		for (int s = 0; s < species; s++) {
+			sum += x[chunk_index][i * species + s];
+		}
+	}
+	if (sum < 0) {
+		return false;
+	}
+	
+	// move to the next chunk index
+	int prev_ci = chunk_index;
+	int** prev_x = x;
+	double* prev_T = T;
+	chunk_index++;
+	
+	// at the end of each chunk
+	if (chunk_index == sc->chunk || (T[chunk_index - 1] - last_print >= sc->print_interval)) {
+		// hand the current chunk's results to the output thread
+		stat_timer(output_start);
+		ss->writer.submit(chunk_job(sc, j, buffer, chunk_index, false));
+		
+		// continue in a free chunk
+		buffer = ss->writer.acquire();
+		stat_time(output, output_start);
+		x = ss->xs[buffer];
+		T = ss->Ts[buffer];
+		last_print = prev_T[prev_ci];
+		T[0] = prev_T[prev_ci];
+		chunk_index = 1;
+	}
+	
+	// wrap around the concentration levels and simulation timestep so they can be considered the previous ones
+	for (unsigned int i = 0; i < cells; i++) {
+		for (int s = 0; s < species; s++) {
+			x[chunk_index][i * species + s] = prev_x[prev_ci][i * species + s];
+		}
+	}
+	T[chunk_index] = prev_T[prev_ci];
+	return true;
+}
+
+// store the statistics of job j (if they're wanted) and announce that it's been simulated
+static void finish_run (sim_constants* sc, unsigned int j, run_stats& stats) {
+	if (sc->stats != NULL) {
+		stats.simulated = true;
+		sc->stats[j] = stats;
+	}
+	if (!sc->quiet) {
+		sim_condition* condition = &sc->conditions[j / sc->runs];
+		cout_mutex.lock();
+		cout << terminal_blue << "Simulated " << terminal_reset;
+		if (sc->num_conditions > 1) {
+			cout << "set #" << condition->set << " " << mutant_names[condition->mutant] << " ";
+		}
+		cout << "run #" << j % sc->runs << " ... " << terminal_done << endl;
+		cout.flush();
+		cout_mutex.unlock();
+	}
+}
+
+/*
+Simulate one job with the chemical Langevin equation (see langevin.h) instead of firing reactions:
+1) Print the header of the run's output file and start the Langevin state with the initial concentrations and the condition's delays
+2) Until the simulation time or timestep limit is reached:
+	a) Recalculate every propensity and advance the whole tissue by one timestep
+	b) Once the simulation has progressed at least the granularity, store the rounded concentrations in the chunk and move to the next entry
+3) Hand any unprinted results to the output thread, which closes the file after printing them
+*/
+static void simulate_langevin_run (sim_constants* sc, sim_state* ss, unsigned int j) {
+	sim_condition* condition = &sc->conditions[j / sc->runs];
+	double dt = condition->leaping.langevin_step;
+	langevin_state& ls = ss->langevin;
+	int buffer = ss->writer.acquire(); // the chunk the run is filling
+	int** x = ss->xs[buffer];
+	double* T = ss->Ts[buffer];
+	rand_stream rng = ss->streams.stream(j); // the job's random number stream
+	run_stats stats; // the run's hot-path statistics, which are only counted if they're compiled in (see run-stats.h)
+	stat_timer(run_start);
+	
+	if (sc->print_runs) {
+		stat_timer(header_start);
+		store_header(&sc->ofile[j], sc->width, sc->height, sc->con_level, sc->granularity, sc->binary, j % sc->runs);
+		stat_time(output, header_start);
+	}
+	
+	try {
+		ls.start(sc->cells, initial_concentrations, condition->delay_times, dt);
+	} catch (bad_alloc) { // if there isn't enough memory to allocate the state then exit the program
+		cout << terminal_no_memory << endl;
+		exit(1);
+	}
+	ls.round_concentrations(x[1]);
+	T[0] = 0; // placeholder value
+	T[1] = 0; // actual first time entry
+	int last_print = T[1]; // the last time that was printed
+	int chunk_index = 1;
+	
+	for (unsigned long iter = 0; iter < sc->max_timesteps && T[chunk_index] < sc->max_minutes; iter++) {
+		ls.update_propensities(&condition->pars, sc->neighbors, sc->nc);
+		ls.advance(&rng, dt, st, delayed_reactions);
+		T[chunk_index] = ls.step * dt; // multiplied rather than summed so rounding errors don't accumulate
+		stat_add(langevin_steps, 1);
+		
+		if (T[chunk_index] - T[chunk_index - 1] >= sc->granularity) {
+			ls.round_concentrations(x[chunk_index]);
+			if (!next_entry(sc, ss, j, stats, buffer, x, T, chunk_index, last_print)) {
+				break;
+			}
+		}
+	}
+	
+	// hand the rest of the results to the output thread, which closes the file once they're printed, and indicate the end of the run
+	ls.round_concentrations(x[chunk_index]);
+	stat_timer(output_start);
+	ss->writer.submit(chunk_job(sc, j, buffer, chunk_index + 1, true));
+	stat_time(output, output_start);
+	stat_time(total, run_start);
+	finish_run(sc, j, stats);
+}
+
+/*
+Simulate one job, i.e. one run of one condition, with the tissue's structure and whether to approximate known at compile time (see simulate_run),
+so every loop over a cell's neighbors has a constant length, the two-cell system's loops over its cells do too, and exact runs compile without tau-leaping:
+1) Print the header of the run's output file and initialize the initial concentration and timestep values
+2) Initialize delayed reaction queues, propensity values, Pk and Tk arrays (for calculating delta using next-reaction-method), etc.
+3) Iterate through the allowed number of iterations doing the following:
+	a) End the simulation if the number of simulation minutes exceeds the limit
+	b) Otherwise, if tau-leaping is not temporarily disabled, try to leap
+	c) If tau-leaping is disabled, run next-reaction-method until it isn't anymore
+	d) If the simulation has progressed enough to print (by default every 60 minutes, but can be changed with -p or --print), hand the chunk to the output thread
+4) When the simulation is done, clear any remaining items in the delayed reaction queues
+5) Hand any unprinted results to the output thread, which closes the file after printing them
+*/
+template <unsigned int fixed_cells, int neighbors, bool appx>
+static void simulate_structure_run (sim_constants* sc, sim_state* ss, unsigned int j) {
+	// give the shared settings and the worker's state the names the algorithms below use
+	const unsigned int cells = fixed_cells != 0 ? fixed_cells : sc->cells; // the number of cells, constant if the structure fixes it
+	int (*nc)[7] = sc->nc;
+	unsigned int max_minutes = sc->max_minutes;
+	unsigned long max_timesteps = sc->max_timesteps;
+	double granularity = sc->granularity;
+	unsigned int con_level = sc->con_level;
+	bool binary = sc->binary;
+	unsigned int r = j % sc->runs; // the run of the job's condition
+	sim_condition* condition = &sc->conditions[j / sc->runs];
+	const leap_settings& leaping = condition->leaping; // how the job's condition trades accuracy for speed (see leap-settings.h)
+	bool hybrid = leaping.hybrid;
+	parameters* p = &condition->pars; // the rates of the job's condition
+	const double* delay_times = condition->delay_times;
+	ofstream* ofile = sc->ofile;
+	output_writer& writer = ss->writer;
+	int buffer = writer.acquire(); // the chunk the run is filling
+	int** x = ss->xs[buffer];
+	double* T = ss->Ts[buffer];
+	reaction_heap& rh = ss->rh;
+	delay_arena& rq = ss->rq;
+	int delayed_entries = cells * reactions; // the index of the first heap entry for the heads of the delayed reaction queues (see reaction-heap.h)
+	rand_stream rng = ss->streams.stream(j); // the job's random number stream
+	run_stats stats; // the run's hot-path statistics, which are only counted if they're compiled in (see run-stats.h)
+	stat_timer(run_start);
+	
+	if (sc->print_runs) {
+		stat_timer(header_start);
+		store_header(&ofile[j], sc->width, sc->height, con_level, granularity, binary, r);
+		stat_time(output, header_start);
+	}
+	
+	// initialize concentration and timestep values (the 0th index isn't used because T[chunk_index - 1] must always exist, so the results start at 1)
+	for (unsigned int i = 0; i < cells; i++) {
+		for (int j = 0; j < species; j++) {
+			x[1][i * species + j] = initial_concentrations[j];
+		}
+	}
+	T[0] = 0; // placeholder value
+	T[1] = 0; // actual first time entry
+	int last_print = T[1]; // the last time that was printed
+	int* delta_sums = ss->delta_sums; // the Delta protein of each cell's neighbors, which every change to a cell's Delta protein is pushed to
+	sum_neighbor_delta(delta_sums, cells, x[1], neighbors, nc);
+
+	/* Tk and Pk arrays are used to calculate delta for the next-reaction-method 
+	   (Tk = current internal time of reaction k, Pk = first internal time after Tk at which reaction k fires)
+	*/
+	reaction_array<double>& Tk = ss->Tk;
+	reaction_array<double>& Pk = ss->Pk;
+	reaction_array<double>& Tk_time = ss->Tk_time; // the simulation time Tk was last brought up to date at (Tk is updated lazily, only when its propensity changes)
+	// the propensity values array and the sum of them, a0
+	reaction_array<double>& a = ss->a;
+	double a0 = 0;
+	// an array to keep track of how many times each reaction fires for tau-leaping
+	reaction_array<int>& firings = ss->firings;
+	// the partition of the reactions and the propensities of the continuous ones for hybrid simulation
+	reaction_array<bool>& continuous = ss->continuous;
+	reaction_array<double>& ac = ss->ac;
+	double next_step = leaping.hybrid_step; // the time the continuous reactions are next integrated to
+	
+	// initialize the worker's state for this run
+	for (unsigned int i = 0; i < cells; i++) {
+		double u[reactions];
+		rng.fill_unif(u, reactions); // draw the uniforms for every Pk of the cell at once
+		for (int k = 0; k < reactions; k++) {
+			Tk[k][i] = 0;
+			Tk_time[k][i] = 0;
+			Pk[k][i] = log(1 / u[k]); // pk_dist()
+			a[k][i] = 0;
+			firings[k][i] = 0;
+			continuous[k][i] = false; // every species starts empty, so every reaction starts discrete
+			ac[k][i] = 0;
+			ss->extent[k][i] = 0;
+		}
+		
+		// initialize delayed transcription reactions properly
+		a[26][i] = p->msh1;
+		a[28][i] = p->msh7;
+		a[30][i] = p->msh13; // remains constant throughout the simulation
+		a[32][i] = p->msd;
+		a0 += a[26][i] + a[28][i] + a[30][i] + a[32][i]; // keep track of the sum of the propensities as they are changed
+	}
+	
+	int HOR[3]; // the higher order reactions array stores a dividing factor for Hill-type reactions, used for tau-leaping
+	for (int j = 0; j < 3; j++) {
+		HOR[j] = 0;
+	}
+	
+	bool last_step_ex = true; // whether or not the last tau-leaping step was explicit (as opposed to implicit)
+	int skip_steps = !appx * -1; // if the simulation shouldn't approximate then set skip_steps to -1, preventing it from ever becoming 0
+
+	// iterate through each time step
+	int cell_index = -1; // the cell index of the most recently fired reaction for the next-reaction-method
+	int reaction_index = -1; // the reaction index of the most recently fired reaction
+	bool is_delayed = false; // whether or not the most recently fired reaction was a delayed reaction
+	int dr_index = -1; // the delayed reaction index of the most recently fired reaction
+	bool heap_stale = true; // whether or not every entry of the heap must be recalculated (at the start of the run and after tau-leaping)
+	int chunk_index = 1; // the current chunk index in which to store data
+	int* cx = x[chunk_index]; // the current concentrations array in which to store data
+	
+	// iterate through the maximum allowed number of timesteps
+	for (unsigned long iter = 0; iter < max_timesteps; iter++) {
+		// if the current simulation time is more than the maximum simulation time then end the simulation
+		if (T[chunk_index] >= max_minutes) {
+			break;
+		}
+		
+		if (appx && skip_steps == 0) { // if tau-leaping isn't temporarily disabled
+			
+			/*
+			Adaptive tau-leaping with improved delay leaping (id-leaping):
+			1) Calculate non-critical tau candidate (tau1)
+				a) Calculate explicit tau1 candidate (tau_ex) based on all non-critical reactions
+				b) Calculate implicit tau1 candidate (tau_im) based on non-critical non-partial-equilibrium reactions
+				c) Take tau1 as the minimum of tau_ex and tau_im
+			2) If tau1 is so small that the next-reaction-method would be more efficient, stop trying to tau-leap
+			3) Otherwise, if tau-leaping is useful, calculate tau2
+				a) Store the sum of the propensities of the critical reactions in a0_crit
+				b) Calculate tau2 based on an exponential distribution of a0_crit
+			4) Take tau as the minimum of tau1 and tau2
+			5) Fire any delayed reactions that should be fired and remove them from their queue
+			6) Calculate the number of firings for each reaction
+			7) If the new concentration levels would be negative, don't update the concentrations and instead halve tau1 and try from step 3 again
+			8) Add any appropriate delayed reactions (or merge them with existing ones via id-leaping method)
+			9) Update concentrations, propensities, and the simulation timestep
+			*/
+			
+			stat_timer(tau_start);
+			double tau1; // non-critical tau candidate
+			double tau_ex = INFINITY; // explicit tau1 candidate
+			double tau_im = INFINITY; // implicit tau1 candidate
+			reaction_array<bool>& critical = ss->critical; // a matrix that stores whether each reaction of each cell is critical or not at this point in the simulation
+			for (int k = 0; k < reactions; k++) { // walk one reaction of every cell at a time, since that's how the propensities are stored
+				double* ak = a[k];
+				bool* ck = critical[k];
+				for (unsigned int i = 0; i < cells; i++) {
+					if (ak[i] > 0) { // if the reaction has a chance of occuring
+						int co = i * species; // cell offset for indexing the concentrations array
+						int min = (int)-INFINITY; // since this considers only negative update reactions, the least negative value is chosen
+						for (int n = st.reactant_offsets[k]; n < st.reactant_offsets[k + 1]; n++) { // consider only negative update reactions (i.e. degradations)
+							int min_temp = cx[co + st.reactant_species[n]] / st.reactant_values[n];
+							if (min_temp > min) { // if min_temp is less negative than min then overwrite min with min_temp
+								min = min_temp;
+							}
+						}
+						ck[i] = min != (int)-INFINITY ? min * -1 < leaping.ncrit : false; // each reaction is considered critical if the absolute value of min is less than ncrit
+					} else { // reactions with no chance of occuring can't be critical
+						ck[i] = false;
+					}
+				}
+			}
+			
+			bool ncrit_exists = false; // true if at least one non-critical reaction exists, false otherwise
+			for (unsigned int i = 0; i < cells; i++) {
+				int co = i * species; // cell offset for indexing the concentrations array
+				for (int k = 0; !ncrit_exists && k < reactions; k++) { // if the first non-critical reaction is encountered then indicate that it exists
+					ncrit_exists = !critical[k][i];
+				}
+				
+				if (ncrit_exists) { // if at least one non-critical reaction exists
+					for (int j = 4; j <= 6; j++) { // species 4, 5, and 6 are higher order reactions, so their division factors must be calculated based on their current concentration values
+						HOR[j - 4] = 2 + 1 / (cx[co + j] + 1);
+					}
+					
+					for (int j = 0; j < species; j++) {
+						double exg = leaping.epsilon * cx[co + j]; // epsilon is usually 0.03-0.05
+						if (j >= 4 && j <= 6) { // higher order reactions divide by a factor more than 1, lower order reactions divide by 1, so no division is executed
+							exg /= HOR[j - 4];
+						}
+						double max_ep = max(exg, 1.0); // make sure exg is at least one
+						
+						double mu_ex = 0; // mu for explicit tau
+						double mu_im = 0; // mu for implicit tau
+						double sigma_ex = 0; // sigma for explicit tau
+						double sigma_im = 0; // sigma for implicit tau
+						for (int n = st.species_offsets[j]; n < st.species_offsets[j + 1]; n++) { // reactions that don't change the species add nothing to its mu and sigma
+							int k = st.species_reactions[n];
+							if (!critical[k][i]) { // mu and sigma values only consider non-critical reactions
+								int r_up = st.species_values[n]; // reaction update value
+								double r_a = a[k][i]; // reaction propensity value
+								double mu_change = r_up * r_a; // add to explicit tau
+								mu_ex += mu_change;
+								sigma_ex += mu_change * r_up;
+								int pair = par_eq_pairs[k]; // the index of the reaction's pair, or -1 if it has none
+								if (pair == -1) { // a reaction without a pair is never in partial equilibrium
+									mu_im += mu_change;
+									sigma_im += mu_change * r_up;
+								} else if (pair > k) { // if the reaction has a pair and the pair has not already been considered
+									int pair_up = species_update_values[j][pair]; // pair update value
+									double pair_a = a[pair][i]; // pair propensity value
+									if ((r_a < pair_a && pair_a - r_a <= leaping.delta_factor * r_a) || (pair_a <= r_a && r_a - pair_a <= leaping.delta_factor * pair_a)) { // if the pair isn't in partial equilibrium then add to implicit tau
+										mu_im += mu_change + pair_up * pair_a;
+										sigma_im += mu_change * r_up + pair_up * pair_up * pair_a;
+									}
+								}
+							}
+						}
+						mu_ex = abs(mu_ex);
+						mu_im = abs(mu_im);
+						
+						// calculate new candidates for tau explicit and tau implicit and update them if a new minimum value has been found
+						double min1 = mu_ex != 0 ? max_ep / mu_ex : INFINITY;
+						double min2 = sigma_ex != 0 ? (max_ep * max_ep) / sigma_ex : INFINITY;
+						min1 = min(min1, min2);
+						if (min1 < tau_ex) {
+							tau_ex = min1;
+						}
+						min1 = mu_im != 0 ? max_ep / mu_im : INFINITY;
+						min2 = sigma_im != 0 ? (max_ep * max_ep) / sigma_im : INFINITY;
+						min1 = min(min1, min2);
+						if (min1 < tau_im) {
+							tau_im = min1;
+						}
+					}
+				}
+			}
+			
+			bool temp_lse = last_step_ex; // store whether the last step was explicit
+			if (tau_im > leaping.nstiff * tau_ex) { // if the system is considered stiff then set tau1 to tau implicit and mark the current step as implicit
+				tau1 = tau_im;
+				last_step_ex = false;
+			} else { // if the system isn't considered stiff then set tau1 to tau explicit and mark the current step as explicit
+				tau1 = tau_ex;
+				last_step_ex = true;
+			}
+			stat_time(tau_selection, tau_start);
+			
+			bool repeat;
+			do { // under some conditions these steps must be repeated multiple times per iteration but by default they aren't (this only repeats when repeat=true)
+				repeat = false;
+				if (tau1 < leaping.tau1_mult / a0) { // if the stepsize of tau1 is so small that it would be more efficient to use the next-reaction-method then skip tau-leaping for a number of steps depending on the stiffness of the system
+					stat_add(skips, 1);
+					if (temp_lse) {
+						skip_steps = leaping.skip_steps_ex;
+					} else {
+						skip_steps = leaping.skip_steps_im;
+					}
+				} else { // if tau-leaping is more efficient than the next-reaction-method then continue
+					// Tk doesn't advance while leaping, so bring every lazily updated Tk up to the current time before the propensities change
+					if (!heap_stale) {
+						catch_up_internal_times(ss, cells, T[chunk_index]);
+					}
+					heap_stale = true; // leaping changes concentrations, propensities, and delayed reaction queues across the whole tissue
+
+					// calculate the sum of the propensities for all critical reactions
+					stat_timer(tau2_start);
+					double a0_crit = 0;
+					for (unsigned int i = 0; i < cells; i++) {
+						for (int k = 0; k < reactions; k++) {
+							if (critical[k][i]) {
+								a0_crit += a[k][i];
+							}
+						}
+					}
+					
+					double tau2 = a0_crit != 0 ? expo_dist(&rng, a0_crit) : INFINITY; // critical tau candidate
+					double tau = min(tau1, tau2); // pick tau based on the smaller of the non-critical and critical candidates
+					stat_time(tau_selection, tau2_start);
+					
+					double nT = T[chunk_index] + tau; // the next simulation timestep
+					stat_timer(release_start);
+					for (unsigned int i = 0; i < cells; i++) { // iterate through every delayed reaction for every cell
+						for (int d = 0; d < num_of_delayed_reactions; d++) {
+							int ri = delayed_reactions[d];
+							delay_queue* q = &rq[i][d]; // iterate through this reaction's queue, compacting the nodes that aren't done to its front
+							int kept = 0;
+							for (int n = 0; n < q->size(); n++) {
+								rq_node* fs = &q->at(n);
+								if (fs->time < nT) { // if the delayed reaction's delay is over
+									double qd = nT - fs->time; // the difference between the delayed reaction's earliest firing time and the new time
+									int kd = bino_dist(&rng, fs->firings, min(qd, fs->span) / fs->span); // a binomial distribution based on the number of times the reaction should fire and the minimum of qd and the reaction's span
+									stat_add(binomial_draws, 1);
+									fs->firings -= kd; // update firings, span, and earliest
+									fs->span -= qd;
+									fs->time = nT;
+									for (int n = st.reaction_offsets[ri]; n < st.reaction_offsets[ri + 1]; n++) { // update the concentrations based on kd
+										cx[i * species + st.reaction_species[n]] += kd * st.reaction_values[n];
+										if (st.reaction_species[n] == 7) { // Delta protein reaches the neighbors
+											push_delta(delta_sums, neighbors, nc[i], kd * st.reaction_values[n]);
+										}
+									}
+									if (fs->firings == 0) { // if the delayed reaction is done then remove it from its queue
+										continue;
+									}
+								}
+								if (kept != n) {
+									q->at(kept) = *fs;
+								}
+								kept++;
+							}
+							q->truncate(kept);
+						}
+					}
+					stat_time(delay_release, release_start);
+					
+					stat_timer(firing_start);
+					if (tau2 > tau1) { // if tau=tau1
+						for (unsigned int i = 0; i < cells; i++) {
+							for (int k = 0; k < reactions; k++) {
+								if (critical[k][i]) {
+									firings[k][i] = 0; // no critical reactions should fire
+								} else {
+									firings[k][i] = pois_dist(&rng, a[k][i] * tau); // non-critical reactions should fire based on a Poisson distribution of their propensities and the time difference, tau
+									stat_add(poisson_draws, 1);
+								}
+							}
+						}
+					} else { // if tau=tau2
+						unsigned int jc = 0; // the index of the critical reaction that should fire this iteration
+						double random_start = 0; // use a point probability distribution to pick jc
+						double random_end = unif_dist(&rng);
+						bool breakout = false;
+						for (unsigned int i = 0; i < cells; i++) {
+							if (breakout) {
+								break;
+							}
+							for (int k = 0; k < reactions; k++) {
+								if (critical[k][i]) {
+									random_start += a[k][i] / a0_crit; // incrementally work up to a0_crit
+									if (random_start >= random_end) { // if the intermediate sum is more than the uniformly distributed random variable chosen above then set jc to the kth reaction of the ith cell
+										jc = i * reactions + k;
+										breakout = true; // stop iterating because jc has already been found
+										break;
+									}
+								}
+							}
+						}
+						
+						for (unsigned int i = 0; i < cells; i++) {
+							for (int k = 0; k < reactions; k++) {
+								if (critical[k][i]) {
+									firings[k][i] = (i * reactions + k == jc); // no critical reaction but jc should fire
+								} else {
+									firings[k][i] = pois_dist(&rng, a[k][i] * tau); // non-critical reactions should fire based on a Poisson distribution of their propensities and the time difference, tau
+									stat_add(poisson_draws, 1);
+								}
+								
+								for (int n = st.reaction_offsets[k]; n < st.reaction_offsets[k + 1]; n++) {
+									if (cx[i * species + st.reaction_species[n]] + firings[k][i] * st.reaction_values[n] < 0) { // if the new concentration levels for any species would be negative then halve tau1 and try again
+										repeat = true;
+										tau1 /= 2;
+										break;
+									}
+								}
+								if (repeat) {
+									break;
+								}
+							}
+						}
+					}
+					stat_time(firing, firing_start);
+					stat_add(repeats, repeat);
+					
+					if (!repeat) { // if the concentrations won't be negative (i.e. everything is fine)
+						stat_timer(queue_start);
+						for (unsigned int i = 0; i < cells; i++) {
+							for (int d = 0; d < num_of_delayed_reactions; d++) {
+								int ri = delayed_reactions[d]; // reaction index
+								if (firings[ri][i] > 0) { // if the delayed reaction should fire
+									bool add = true;
+									if (!rq[i][d].empty()) { // if the queue for this reaction isn't empty
+										rq_node* fs = &rq[i][d].back();
+										double fs_ratio = fs->firings / fs->span;
+										double ratio_diff = firings[ri][i] / tau - fs_ratio;
+										if (abs(ratio_diff) < leaping.beta * fs_ratio) { // if the last queue node and this one can be merged then merge them
+											fs->firings += firings[ri][i];
+											fs->span += tau;
+											add = false;
+											stat_add(delay_merges, 1);
+										}
+									}
+									if (add) { // if the last queue node couldn't be merged with this one then add it to the reaction's queue
+										try {
+											rq[i][d].push_back(rq_node(T[chunk_index] + delay_times[d], firings[ri][i], tau));
+										} catch (bad_alloc) { // if there isn't enough memory to grow the queue then exit the program
+											cout << terminal_no_memory << endl;
+											exit(1);
+										}
+										stat_add(delay_pushes, 1);
+										stat_add(delay_queue_total, rq[i][d].size());
+										stat_peak(delay_queue_max, rq[i][d].size());
+									}
+								}
+							}
+						}
+						
+						stat_time(delay_release, queue_start);
+						
+						// update the appropriate concentrations
+						stat_timer(update_start);
+						for (unsigned int i = 0; i < cells; i++) {
+							for (int nd = 1; nd <= st.non_delayed[0]; nd++) { // only reactions that aren't delayed (and therefore haven't updated their appropriate concentrations) update the concentrations here
+								int k = st.non_delayed[nd];
+								if (firings[k][i] != 0) {
+									for (int n = st.reaction_offsets[k]; n < st.reaction_offsets[k + 1]; n++) {
+										cx[i * species + st.reaction_species[n]] += firings[k][i] * st.reaction_values[n];
+										if (st.reaction_species[n] == 7) { // Delta protein reaches the neighbors
+											push_delta(delta_sums, neighbors, nc[i], firings[k][i] * st.reaction_values[n]);
+										}
+									}
+								}
+							}
+							
+							update_all_propensities(a, i, p, cx, neighbors, delta_sums, &a0); // any propensity could have changed
+						}
+						stat_time(propensity_update, update_start);
+						
+						// update the simulation timestep
+						T[chunk_index] = nT;
+						stat_add(leaps, 1);
+						stat_add(explicit_leaps, last_step_ex);
+						stat_add(implicit_leaps, !last_step_ex);
+					}
+				}
+			} while (repeat); // repeat if the concentrations would have become negative
+		} else { // if tau-leaping has been temporarily disabled for the sake of efficiency
+			if (skip_steps > 0) { 
+				/* 
+				   if tau-leaping should eventually be resumed 
+				   then decrement the number of times the next-reaction-method should be run before doing so
+				*/
+				skip_steps--;
+			}
+			
+			/*
+			Next reaction method with delayed reactions:
+			1) Update the propensity values the most recently fired reaction could have changed, as given by the dependency graph (skip this step the first iteration)
+			2) Update the heap of putative firing times for every propensity that changed
+			   (or rebuild the whole heap if this is the first iteration or tau-leaping or a hybrid step has changed the system)
+			3) In hybrid simulation, if the next discrete reaction fires after the next continuous timestep, integrate the continuous reactions to that timestep instead of steps 4-7
+			4) Calculate delta
+				a) Take the entry at the top of the heap as the active reaction
+				b) Delta is the entry's firing time - current time (for a non-delayed reaction the firing time is kept as T + (Pk - Tk) / ak)
+			5) Update the simulation timestep
+			6) Update the concentrations for the active reaction and 
+			   either pop it off its queue if it's a finished delayed reaction or add it to the queue if it's a new one, updating the queue's heap entry
+			7) Bring the active reaction's Tk up to date, update its Pk, and update its heap entry
+			   (every other Tk is only brought up to date right before its propensity changes)
+			*/
+			
+			// update the propensity functions and the heap entries of the putative firing times that the most recently fired reaction could have changed
+			if (cell_index != -1) {
+				int event = is_delayed ? reactions + dr_index : reaction_index; // the dependency graph's index for the most recently fired reaction
+				int* cnc = nc[cell_index]; // get the cell's neighbors (the active cell is always its own first neighbor)
+				int maxcell = dg.neighbor_groups[event][0] > 0 ? neighbors : 1; // only changes to Delta protein reach the neighbors
+				for (int cn = 0; cn < maxcell; cn++) {
+					int ci = cnc[cn];
+					const int* groups = cn == 0 ? dg.local_groups[event] : dg.neighbor_groups[event];
+					const int* affected = cn == 0 ? dg.local_propensities[event] : dg.neighbor_propensities[event];
+					
+					// bring Tk up to date for every propensity about to change, since Tk is only updated lazily (a stale heap's Tk values are already up to date)
+					if (!heap_stale) {
+						for (int n = 1; n <= affected[0]; n++) {
+							int k = affected[n];
+							Tk[k][ci] += a[k][ci] * (T[chunk_index] - Tk_time[k][ci]);
+							Tk_time[k][ci] = T[chunk_index];
+						}
+					}
+					for (int g = 1; g <= groups[0]; g++) {
+						update_propensity_group(groups[g], a, ci, p, cx, ci * species, neighbors, delta_sums, &a0);
+					}
+					if (hybrid) { // continuous reactions never fire as discrete ones, so their new propensities go to the continuous integration instead
+						for (int n = 1; n <= affected[0]; n++) {
+							int k = affected[n];
+							if (continuous[k][ci]) {
+								ac[k][ci] = a[k][ci];
+								a0 -= a[k][ci];
+								a[k][ci] = 0;
+							}
+						}
+					}
+					if (!heap_stale) {
+						for (int n = 1; n <= affected[0]; n++) {
+							int k = affected[n];
+							rh.update(ci * reactions + k, putative_time(T[chunk_index], Pk[k][ci], Tk[k][ci], a[k][ci]));
+						}
+					}
+				}
+			}
+			if (heap_stale) { // if every entry could have changed then recalculate them all and rebuild the heap
+				for (int j = 0; j < reactions; j++) {
+					for (unsigned int i = 0; i < cells; i++) {
+						Tk_time[j][i] = T[chunk_index];
+						rh.times[i * reactions + j] = putative_time(T[chunk_index], Pk[j][i], Tk[j][i], a[j][i]);
+					}
+				}
+				for (unsigned int i = 0; i < cells; i++) {
+					for (int d = 0; d < num_of_delayed_reactions; d++) {
+						rh.times[delayed_entries + i * num_of_delayed_reactions + d] = rq[i][d].empty() ? INFINITY : rq[i][d].front().time;
+					}
+				}
+				rh.build();
+				heap_stale = false;
+			}
+
+			int entry = rh.top();
+			if (hybrid && rh.times[entry] > next_step) { // if the continuous reactions must be integrated before the next discrete reaction fires
+				catch_up_internal_times(ss, cells, next_step); // the discrete propensities were constant until the step ends
+				integrate_continuous(ss, cells, leaping.hybrid_step, p, cx, neighbors, nc, leaping.hybrid_threshold, &a0); // over the whole step, since discrete reactions only moved T within it
+				T[chunk_index] = next_step;
+				next_step += leaping.hybrid_step;
+				cell_index = -1; // every propensity was recalculated, so no single reaction's dependencies need updating
+				heap_stale = true;
+				stat_add(hybrid_steps, 1);
+			} else {
+				stat_add(nrm_steps, 1);
+				
+				// calculate delta using the entry that fires first
+				double delta = rh.times[entry] - T[chunk_index]; // the time change
+				is_delayed = entry >= delayed_entries; // whether or not the reaction is delayed
+				stat_add(nrm_delayed, is_delayed);
+				if (!is_delayed) {
+					cell_index = entry / reactions; // the cell index of the active reaction
+					reaction_index = entry % reactions; // the reaction index of the active reaction
+					dr_index = -1;
+				} else {
+					entry -= delayed_entries;
+					cell_index = entry / num_of_delayed_reactions;
+					dr_index = entry % num_of_delayed_reactions; // the delayed reaction index of the active reaction
+					reaction_index = delayed_reactions[dr_index];
+				}
+			
+				// update the simulation timestep
+				T[chunk_index] += delta;
+			
+				// update the concentrations and appropriate delayed queue if necessary
+				int cell_offset = cell_index * species;
+				if (is_delayed) { 
+				    // if the current reaction is delayed then update the concentrations according to delayed update values
+					cx[cell_offset + species_update_indices_delayed[dr_index]]++;
+					if (species_update_indices_delayed[dr_index] == 7) { // Delta protein reaches the neighbors
+						push_delta(delta_sums, neighbors, nc[cell_index], 1);
+					}
+				
+					// remove the current reaction from its delayed queue (along with its firings and span, used if tau-leaping is also activated)
+					if (!rq[cell_index][dr_index].empty()) {
+						rq[cell_index][dr_index].pop_front();
+					}
+					rh.update(delayed_entries + cell_index * num_of_delayed_reactions + dr_index, rq[cell_index][dr_index].empty() ? INFINITY : rq[cell_index][dr_index].front().time);
+				} else { 
+				    /* 
+				       if the current reaction isn't a delayed one finishing 
+				       then update the concentrations according to non-delayed update values
+					   if the reaction is a delayed one starting then add it to the corresponding delayed reactions queue
+					*/
+					int d = dg.delayed_index[reaction_index];
+					if (d != -1) {
+						try {
+							rq[cell_index][d].push_back(rq_node(T[chunk_index] + delay_times[d], 1, delta));
+						} catch (bad_alloc) { // if there isn't enough memory to grow the queue then exit the program
+							cout << terminal_no_memory << endl;
+							exit(1);
+						}
+						stat_add(delay_pushes, 1);
+						stat_add(delay_queue_total, rq[cell_index][d].size());
+						stat_peak(delay_queue_max, rq[cell_index][d].size());
+						rh.update(delayed_entries + cell_index * num_of_delayed_reactions + d, rq[cell_index][d].front().time);
+					} else { // if the reaction is not a delayed one starting then update the concentrations according to non-delayed update values
+						int end = species_update_indices[reaction_index][0];
+						for (int i = 1; i <= end; i++) {
+							int species_index = species_update_indices[reaction_index][i];
+							cx[cell_offset + species_index] += species_update_values[species_index][reaction_index];
+							if (species_index == 7) { // Delta protein reaches the neighbors
+								push_delta(delta_sums, neighbors, nc[cell_index], species_update_values[species_index][reaction_index]);
+							}
+						}
+					}
+				
+					// bring the active reaction's Tk up to the current time (every other Tk is only brought up to date when its propensity changes), update its Pk with a new random value, and reschedule it
+					Tk[reaction_index][cell_index] += a[reaction_index][cell_index] * (T[chunk_index] - Tk_time[reaction_index][cell_index]);
+					Tk_time[reaction_index][cell_index] = T[chunk_index];
+					Pk[reaction_index][cell_index] += pk_dist(&rng); // log(1 / unif_dist())
+					rh.update(cell_index * reactions + reaction_index, putative_time(T[chunk_index], Pk[reaction_index][cell_index], Tk[reaction_index][cell_index], a[reaction_index][cell_index]));
+				}
+			}
+		}
+		
+		// if the difference in timesteps exceeds the granularity then move to the next index in the chunk
+		if (T[chunk_index] - T[chunk_index - 1] >= granularity) {
+			if (!next_entry(sc, ss, j, stats, buffer, x, T, chunk_index, last_print)) {
+				break;
+			}
+			cx = x[chunk_index];
+		}
+	}
+	
+	// empty the delayed reaction queues (their memory is kept for the next run)
+	rq.clear();
+
+	// hand the rest of the results to the output thread, which closes the file once they're printed, and indicate the end of the run
+	stat_timer(output_start);
+	writer.submit(chunk_job(sc, j, buffer, chunk_index + 1, true));
+	stat_time(output, output_start);
+	stat_time(total, run_start);
+	finish_run(sc, j, stats);
+}
+
+/*
+Simulate one job with the algorithm its condition calls for:
+chemical Langevin runs (see langevin.h) have their own loop, and every other run uses the simulate_structure_run specialized for the tissue's structure and the condition's approximation,
+so the structure (fixed for the whole simulation) and approximation (fixed for each condition) are only checked once per run.
+*/
+void simulate_run (sim_constants* sc, sim_state* ss, unsigned int j) {
+	const leap_settings& leaping = sc->conditions[j / sc->runs].leaping;
+	if (leaping.langevin) {
+		simulate_langevin_run(sc, ss, j);
+	} else if (sc->neighbors == neighbors_for_twocell && sc->cells == 2) {
+		(leaping.appx ? simulate_structure_run<2, neighbors_for_twocell, true> : simulate_structure_run<2, neighbors_for_twocell, false>)(sc, ss, j);
+	} else if (sc->neighbors == neighbors_for_chain) {
+		(leaping.appx ? simulate_structure_run<0, neighbors_for_chain, true> : simulate_structure_run<0, neighbors_for_chain, false>)(sc, ss, j);
+	} else {
+		(leaping.appx ? simulate_structure_run<0, neighbors_for_tissue, true> : simulate_structure_run<0, neighbors_for_tissue, false>)(sc, ss, j);
+	}
+}
+
+// the run loop of each worker thread, which takes the next unsimulated job until there are none left
+static void simulate_worker (sim_constants* sc, sim_state* ss, atomic<unsigned int>* next_job, unsigned int jobs) {
+	for (unsigned int j = (*next_job)++; j < jobs; j = (*next_job)++) {
+		simulate_run(sc, ss, j);
+	}
+}
+
+// simulate run count of condition c and wait for the output thread to store its features
+static void simulate_evaluated_run (sim_constants* sc, sim_state* ss, unsigned int c, unsigned int count) {
+	simulate_run(sc, ss, c * sc->runs + count);
+	ss->writer.drain();
+}
+
+/*
+The run loop of each worker thread when evaluating parameter sets, which takes the next unevaluated set until there are none left:
+1) Simulate the set's conditions in order (the wild type first), one run at a time, waiting for the output thread to store each run's features
+2) Decide the condition after each run (see evaluation.h), simulating another run only while it's undecided,
+   and before a mutant's last run simulate the wild type's remaining runs, so the mutant's means are compared with the mean of every wild type run
+3) Stop the set at the first condition that fails, which can be the wild type once all of its runs are in
+*/
+static void evaluate_worker (sim_constants* sc, sim_state* ss, atomic<unsigned int>* next_set, unsigned int sets) {
+	for (unsigned int s = (*next_set)++; s < sets; s = (*next_set)++) {
+		set_evaluation* e = &sc->evaluations[s];
+		e->passed = true;
+		unsigned int wt = s * sc->conditions_per_set; // the wild type's condition
+		run_features* wt_features = &sc->features[wt * sc->runs];
+		unsigned int wt_count = 0; // the number of runs of the wild type simulated
+		sequential_test wt_period(-INFINITY, INFINITY); // the wild type's periods, which the mutants' are compared with
+		ss->streams.checkpoint(wt * sc->runs); // the wild type's runs can be returned to after the mutants' (see rand-dist.h)
+		for (unsigned int c = wt; e->passed && c < (s + 1) * sc->conditions_per_set; c++) {
+			int mutant = sc->conditions[c].mutant;
+			run_features* features = &sc->features[c * sc->runs];
+			int result = test_undecided;
+			unsigned int count = 0;
+			while (result == test_undecided) {
+				if (mutant != mutant_wt && count + 1 == sc->runs && wt_count < sc->runs) {
+					for (; wt_count < sc->runs; wt_count++) {
+						simulate_evaluated_run(sc, ss, wt, wt_count);
+						wt_period.add(wt_features[wt_count].period);
+						e->jobs++;
+					}
+					if (decide_condition(mutant_wt, wt_features, wt_count, wt_period, sc->runs) == test_fail) {
+						mutant = mutant_wt; // the set fails on the wild type's means over every run, as it would in seg-clock
+						result = test_fail;
+						break;
+					}
+				}
+				simulate_evaluated_run(sc, ss, c, count);
+				count++;
+				result = decide_condition(mutant, features, count, wt_period, sc->runs);
+			}
+			e->jobs += count;
+			if (mutant == mutant_wt && c == wt) {
+				wt_count = count;
+				for (unsigned int r = 0; r < count; r++) {
+					wt_period.add(features[r].period);
+				}
+			}
+			if (result == test_fail) {
+				e->passed = false;
+				e->failed = mutant;
+			}
+		}
+		
+		cout_mutex.lock();
+		cout << terminal_blue << "Evaluated " << terminal_reset << "set #" << s << " ... ";
+		if (e->passed) {
+			cout << terminal_done << endl;
+		} else {
+			cout << terminal_red << "failed " << mutant_names[e->failed] << terminal_reset << endl;
+		}
+		cout_mutex.unlock();
+	}
+}
+
+/*
+Simulate every run of every condition:
+1) Allocate a state for each worker (no more workers than jobs, or parameter sets if they're evaluated, are used)
+2) Start the workers, with the calling thread acting as the first one
+3) Wait for every worker to finish and free their states (which waits for their output threads to print and close every file)
+*/
+void simulate_runs (sim_constants* sc, unsigned int threads) {
+	unsigned int jobs = sc->evaluate ? sc->num_conditions / sc->conditions_per_set : sc->num_conditions * sc->runs;
+	if (threads > jobs) {
+		threads = jobs;
+	}
+	
+	vector<sim_state*> states(threads);
+	for (unsigned int w = 0; w < threads; w++) {
+		states[w] = new sim_state(sc->cells, sc->chunk, sc->features != NULL, sc->seed);
+	}
+	
+	atomic<unsigned int> next_job(0);
+	vector<thread> workers;
+	for (unsigned int w = 1; w < threads; w++) {
+		workers.push_back(thread(sc->evaluate ? evaluate_worker : simulate_worker, sc, states[w], &next_job, jobs));
+	}
+	(sc->evaluate ? evaluate_worker : simulate_worker)(sc, states[0], &next_job, jobs);
+	for (unsigned int w = 0; w < workers.size(); w++) {
+		workers[w].join();
+	}
+	
+	for (unsigned int w = 0; w < threads; w++) {
+		delete states[w];
+	}
+}
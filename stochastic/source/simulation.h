@@ -0,0 +1,111 @@
+/*
+Stochastic simulator for zebrafish segmentation
+Copyright (C) 2012 Ahmet Ay, Jack Holland, Adriana Sperlea
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/*
+Runs are simulated by a pool of worker threads (-n or --threads sets how many).
+Every worker owns a sim_state holding everything a run changes, and takes the next unsimulated run until none are left.
+A sim_state is allocated once per worker and reused by each of its runs; its per-reaction arrays are stored by reaction across cells (see reaction-array.h).
+Every run draws its random numbers from its own stream, seeded from the simulation seed and the run's index (see rand-dist.h),
+which a worker jumps to from its previous run's stream, so each run's output is the same no matter how many threads there are or which worker simulates it.
+The workers simulate every run of every condition (a parameter set with a mutant's knockouts, see batch.h), which is just one condition unless -j or --batch is given.
+A job is one run of one condition, numbered so the runs of a condition are consecutive, and its index is used for its random number stream, output file, and features.
+Every worker also has its own output thread that prints the chunks of timesteps the worker fills (see output-writer.h).
+When parameter sets are evaluated (-v or --evaluate), a worker takes a whole parameter set instead of a job and simulates its runs one after another,
+since which run comes next depends on the features of the ones before it (see evaluation.h).
+*/
+
+#ifndef SIMULATION_H
+#define SIMULATION_H
+
+#include <chrono>
+#include <fstream>
+#include <math.h>
+
+#include "batch.h"
+#include "delay-queue.h"
+#include "evaluation.h"
+#include "features.h"
+#include "langevin.h"
+#include "macros.h"
+#include "output-writer.h"
+#include "rand-dist.h"
+#include "reaction-array.h"
+#include "reaction-heap.h"
+#include "run-stats.h"
+
+using namespace std;
+
+// the settings every run shares (workers only read these)
+struct sim_constants {
+	unsigned int cells; // the total number of cells
+	unsigned int width; // the tissue width in cells
+	unsigned int height; // the tissue height in cells
+	int neighbors; // the number of neighbors each cell has (including itself)
+	int (*nc)[7]; // the neighbors of each cell
+	unsigned int max_minutes; // the maximum number of minutes to simulate
+	unsigned long max_timesteps; // the maximum number of timesteps to simulate
+	double granularity; // the amount of time to skip between each timestep when printing the output file
+	unsigned int print_interval; // how often (in minutes) the output file should be printed to
+	unsigned int con_level; // the index of the concentration level to print as output
+	bool binary; // whether or not to print binary run files instead of text ones (see run-file.h)
+	bool print_runs; // whether or not to print the run files (-e or --features-only turns this off)
+	bool quiet; // whether or not to hide the line announcing each finished run (autotuning hides its calibration runs, see autotune.h)
+	run_stats* stats; // the hot-path statistics of each job (see run-stats.h), NULL unless -z or --stats is given
+	run_features* features; // the oscillation features of each job (see features.h), NULL unless -f or --ofeatures or -j or --batch is given
+	int chunk; // the number of timesteps stored before printing
+	unsigned int seed; // the seed every run's random number stream is derived from
+	unsigned int runs; // the number of runs of each condition
+	unsigned int num_conditions; // the number of conditions
+	sim_condition* conditions; // the parameters and delays of each condition
+	bool evaluate; // whether or not to evaluate every parameter set, stopping its runs as soon as it's decided (see evaluation.h)
+	unsigned int conditions_per_set; // the number of consecutive conditions of each parameter set (one per mutant)
+	set_evaluation* evaluations; // the outcome of each parameter set, only used if evaluate is true
+	ofstream* ofile; // the output file of each job (opened but still empty, since each run prints its own header), only used if print_runs is true
+};
+
+// the memory a worker's runs change, reused by every run the worker simulates
+struct sim_state {
+	int** xs[output_buffers]; // the concentrations of each chunk
+	double* Ts[output_buffers]; // the timesteps of each chunk
+	output_writer writer; // prints full chunks on the worker's output thread
+	feature_extractor* extractor; // computes the oscillation features of the worker's runs on the output thread, NULL if they aren't wanted
+	reaction_heap rh; // the putative firing times used to pick the next reaction for the next-reaction-method
+	delay_arena rq; // the delayed reaction queues of every cell (used for next-reaction-method and id-leaping)
+	reaction_array<double> Tk; // the current internal time of each reaction
+	reaction_array<double> Pk; // the first internal time after Tk at which each reaction fires
+	reaction_array<double> Tk_time; // the simulation time each Tk was last brought up to date at
+	reaction_array<double> a; // the propensity of each reaction
+	reaction_array<int> firings; // how many times each reaction fires for tau-leaping
+	reaction_array<bool> critical; // whether each reaction is critical for tau-leaping
+	reaction_array<bool> continuous; // whether hybrid simulation integrates each reaction as an ODE instead of firing it (see leap-settings.h)
+	reaction_array<double> ac; // the propensity of each continuous reaction (its entry in a is 0, so the next-reaction-method never fires it)
+	reaction_array<double> extent; // the fraction of a firing each continuous reaction has integrated but not yet applied
+	int* delta_sums; // the sum of the Delta protein of each cell's neighbors, kept up to date as it changes (see updates.h)
+	langevin_state langevin; // the state of chemical Langevin runs (see langevin.h), only allocated by the worker's first one
+	stream_source streams; // the random number streams of the worker's runs
+	int chunk; // the number of timesteps each chunk stores
+	
+	sim_state (int cells, int chunk, bool features, unsigned int seed);
+	~sim_state ();
+};
+
+void simulate_run(sim_constants*, sim_state*, unsigned int);
+void simulate_runs(sim_constants*, unsigned int);
+
+#endif
+
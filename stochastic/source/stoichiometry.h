@@ -0,0 +1,106 @@
+/*
+Stochastic simulator for zebrafish segmentation
+Copyright (C) 2012 Ahmet Ay, Jack Holland, Adriana Sperlea
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/*
+The sparse form of species_update_values used by tau-leaping.
+Most reactions change only one or two species, so the tau selection, criticality, and concentration update loops walk only the nonzero entries.
+The entries are stored in compressed sparse rows (CSR): row r spans the indices offsets[r] to offsets[r + 1] - 1 of its index and value arrays,
+and the entries of each row are stored in increasing index order so sums over a row add in the same order as a dense loop.
+*/
+
+#ifndef STOICHIOMETRY_H
+#define STOICHIOMETRY_H
+
+#include "macros.h"
+
+#define max_stoichiometry_entries (species * reactions) // an upper bound on the number of nonzero entries in any of the tables below
+
+struct stoichiometry {
+	// the reactions that change each species and by how much (rows are species)
+	int species_offsets[species + 1];
+	int species_reactions[max_stoichiometry_entries];
+	int species_values[max_stoichiometry_entries];
+
+	// the species each reaction changes and by how much (rows are reactions)
+	int reaction_offsets[reactions + 1];
+	int reaction_species[max_stoichiometry_entries];
+	int reaction_values[max_stoichiometry_entries];
+
+	// the species each reaction consumes and by how much, i.e. only the negative entries (rows are reactions)
+	int reactant_offsets[reactions + 1];
+	int reactant_species[max_stoichiometry_entries];
+	int reactant_values[max_stoichiometry_entries];
+
+	bool not_delayed[reactions]; // whether or not each reaction changes its species as soon as it fires
+	int non_delayed[reactions + 1]; // the reactions that aren't delayed, storing its length as its first value like the lists in dependencies.h
+
+	stoichiometry (const int species_update_values[][reactions], const int delayed_reactions[]) {
+		int n = 0;
+		for (int j = 0; j < species; j++) {
+			this->species_offsets[j] = n;
+			for (int k = 0; k < reactions; k++) {
+				if (species_update_values[j][k] != 0) {
+					this->species_reactions[n] = k;
+					this->species_values[n] = species_update_values[j][k];
+					n++;
+				}
+			}
+		}
+		this->species_offsets[species] = n;
+
+		int nr = 0; // the number of reaction entries
+		int nn = 0; // the number of reactant entries
+		for (int k = 0; k < reactions; k++) {
+			this->reaction_offsets[k] = nr;
+			this->reactant_offsets[k] = nn;
+			for (int j = 0; j < species; j++) {
+				int value = species_update_values[j][k];
+				if (value != 0) {
+					this->reaction_species[nr] = j;
+					this->reaction_values[nr] = value;
+					nr++;
+				}
+				if (value < 0) {
+					this->reactant_species[nn] = j;
+					this->reactant_values[nn] = value;
+					nn++;
+				}
+			}
+		}
+		this->reaction_offsets[reactions] = nr;
+		this->reactant_offsets[reactions] = nn;
+
+		for (int k = 0; k < reactions; k++) {
+			this->not_delayed[k] = true;
+		}
+		for (int d = 0; d < num_of_delayed_reactions; d++) {
+			this->not_delayed[delayed_reactions[d]] = false;
+		}
+		this->non_delayed[0] = 0;
+		for (int k = 0; k < reactions; k++) {
+			if (this->not_delayed[k]) {
+				this->non_delayed[++this->non_delayed[0]] = k;
+			}
+		}
+	}
+
+	~stoichiometry () {}
+};
+
+#endif
+
@@ -19,127 +19,189 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #ifndef UPDATES_H
 #define UPDATES_H
 
+#include "dependencies.h"
 #include "macros.h"
 #include "parameters.h"
+#include "reaction-array.h"
 
-inline void update_a0_27 (double* ca, parameters* p, int* cx, int xcell, double* a0) { // If her1 mRNA is updated
-	double old = ca[0] + ca[27];
-	ca[0] = p->psh1 * cx[xcell + 0]; 		// Her1 protein synthesis
-	ca[27] = p->mdh1 * cx[xcell + 0]; 		// her1 mRNA degradation
-	*a0 += ca[0] + ca[27] - old;
+inline void update_a0_27 (reaction_array<double>& a, int cell, parameters* p, int* cx, int xcell, double* a0) { // If her1 mRNA is updated
+	double old = a[0][cell] + a[27][cell];
+	a[0][cell] = p->psh1 * cx[xcell + 0]; 		// Her1 protein synthesis
+	a[27][cell] = p->mdh1 * cx[xcell + 0]; 		// her1 mRNA degradation
+	*a0 += a[0][cell] + a[27][cell] - old;
 }
 
-inline void update_a1_2_4_6 (double* ca, parameters* p, int* cx, int xcell, double* a0) { // If Her1 protein is updated
-	double old = ca[1] + ca[2] + ca[4] + ca[6];
-	ca[1] = p->pdh1 * cx[xcell + 4]; 								// Her1 protein degradation
-	ca[2] = p->dah1h1 * cx[xcell + 4] * (cx[xcell + 4] - 1) / 2; 	// Her1-Her1 dimer association
-	ca[4] = p->dah1h7 * cx[xcell + 4] * cx[xcell + 5]; 				// Her1-Her7 dimer association
-	ca[6] = p->dah1h13 * cx[xcell + 4] * cx[xcell + 6]; 			// Her1-Her13 dimer association
-	*a0 += ca[1] + ca[2] + ca[4] + ca[6] - old;
+inline void update_a1_2_4_6 (reaction_array<double>& a, int cell, parameters* p, int* cx, int xcell, double* a0) { // If Her1 protein is updated
+	double old = a[1][cell] + a[2][cell] + a[4][cell] + a[6][cell];
+	a[1][cell] = p->pdh1 * cx[xcell + 4]; 								// Her1 protein degradation
+	a[2][cell] = p->dah1h1 * cx[xcell + 4] * (cx[xcell + 4] - 1) / 2; 	// Her1-Her1 dimer association
+	a[4][cell] = p->dah1h7 * cx[xcell + 4] * cx[xcell + 5]; 				// Her1-Her7 dimer association
+	a[6][cell] = p->dah1h13 * cx[xcell + 4] * cx[xcell + 6]; 			// Her1-Her13 dimer association
+	*a0 += a[1][cell] + a[2][cell] + a[4][cell] + a[6][cell] - old;
 }
 
-inline void update_a3_18 (double* ca, parameters* p, int* cx, int xcell, double* a0) { // If Her1-Her1 dimer is updated
-	double old = ca[3] + ca[18];
-	ca[3] = p->ddh1h1 * cx[xcell + 8]; 		// Her1-Her1 dimer dissociation
-	ca[18] = p->ddgh1h1 * cx[xcell + 8]; 	// Her1-Her1 dimer degradation
-	*a0 += ca[3] + ca[18] - old;
+inline void update_a3_18 (reaction_array<double>& a, int cell, parameters* p, int* cx, int xcell, double* a0) { // If Her1-Her1 dimer is updated
+	double old = a[3][cell] + a[18][cell];
+	a[3][cell] = p->ddh1h1 * cx[xcell + 8]; 		// Her1-Her1 dimer dissociation
+	a[18][cell] = p->ddgh1h1 * cx[xcell + 8]; 	// Her1-Her1 dimer degradation
+	*a0 += a[3][cell] + a[18][cell] - old;
 }
 
-inline void update_a4_9_10_12 (double* ca, parameters* p, int* cx, int xcell, double* a0) { // If Her7 protein is updated
-	double old = ca[4] + ca[9] + ca[10] + ca[12];
-	ca[4] = p->dah1h7 * cx[xcell + 4] * cx[xcell + 5]; 				// Her1-Her7 dimer association
-	ca[9] = p->pdh7 * cx[xcell + 5]; 								// Her7 protein degradation
-	ca[10] = p->dah7h7 * cx[xcell + 5] * (cx[xcell + 5] - 1) / 2; 	// Her7-Her7 dimer association
-	ca[12] = p->dah7h13 * cx[xcell + 5] * cx[xcell + 6]; 			// Her7-Her13 dimer association
-	*a0 += ca[4] + ca[9] + ca[10] + ca[12] - old;
+inline void update_a4_9_10_12 (reaction_array<double>& a, int cell, parameters* p, int* cx, int xcell, double* a0) { // If Her7 protein is updated
+	double old = a[4][cell] + a[9][cell] + a[10][cell] + a[12][cell];
+	a[4][cell] = p->dah1h7 * cx[xcell + 4] * cx[xcell + 5]; 				// Her1-Her7 dimer association
+	a[9][cell] = p->pdh7 * cx[xcell + 5]; 								// Her7 protein degradation
+	a[10][cell] = p->dah7h7 * cx[xcell + 5] * (cx[xcell + 5] - 1) / 2; 	// Her7-Her7 dimer association
+	a[12][cell] = p->dah7h13 * cx[xcell + 5] * cx[xcell + 6]; 			// Her7-Her13 dimer association
+	*a0 += a[4][cell] + a[9][cell] + a[10][cell] + a[12][cell] - old;
 }
 
-inline void update_a5_19 (double* ca, parameters* p, int* cx, int xcell, double* a0) { // If Her1-Her7 dimer is updated
-	double old = ca[5] + ca[19];
-	ca[5] = p->ddh1h7 * cx[xcell + 9];		// Her1-Her7 dimer dissociation
-	ca[19] = p->ddgh1h7 * cx[xcell + 9];	// Her1-Her7 dimer degradation
-	*a0 += ca[5] + ca[19] - old;
+inline void update_a5_19 (reaction_array<double>& a, int cell, parameters* p, int* cx, int xcell, double* a0) { // If Her1-Her7 dimer is updated
+	double old = a[5][cell] + a[19][cell];
+	a[5][cell] = p->ddh1h7 * cx[xcell + 9];		// Her1-Her7 dimer dissociation
+	a[19][cell] = p->ddgh1h7 * cx[xcell + 9];	// Her1-Her7 dimer degradation
+	*a0 += a[5][cell] + a[19][cell] - old;
 }
 
-inline void update_a6_12_15_16 (double* ca, parameters* p, int* cx, int xcell, double* a0) { // If Her13 protein is updated
-	double old = ca[6] + ca[12] + ca[15] + ca[16];
-	ca[6] = p->dah1h13 * cx[xcell + 4] * cx[xcell + 6];					// Her1-Her13 dimer association
-	ca[12] = p->dah7h13 * cx[xcell + 5] * cx[xcell + 6];				// Her7-Her13 dimer association
-	ca[15] = p->pdh13 * cx[xcell + 6];									// Her13 protein degradation
-	ca[16] = p->dah13h13 * cx[xcell + 6] * (cx[xcell + 6] - 1) / 2;		// Her13-Her13 dimer association
-	*a0 += ca[6] + ca[12] + ca[15] + ca[16] - old;
+inline void update_a6_12_15_16 (reaction_array<double>& a, int cell, parameters* p, int* cx, int xcell, double* a0) { // If Her13 protein is updated
+	double old = a[6][cell] + a[12][cell] + a[15][cell] + a[16][cell];
+	a[6][cell] = p->dah1h13 * cx[xcell + 4] * cx[xcell + 6];					// Her1-Her13 dimer association
+	a[12][cell] = p->dah7h13 * cx[xcell + 5] * cx[xcell + 6];				// Her7-Her13 dimer association
+	a[15][cell] = p->pdh13 * cx[xcell + 6];									// Her13 protein degradation
+	a[16][cell] = p->dah13h13 * cx[xcell + 6] * (cx[xcell + 6] - 1) / 2;		// Her13-Her13 dimer association
+	*a0 += a[6][cell] + a[12][cell] + a[15][cell] + a[16][cell] - old;
 }
 
-inline void update_a7_20 (double* ca, parameters* p, int* cx, int xcell, double* a0) { // If Her1-Her13 dimer is updated
-	double old = ca[7] + ca[20];
-	ca[7] = p->ddh1h13 * cx[xcell + 10];		// Her1-Her13 dimer dissociation
-	ca[20] = p->ddgh1h13 * cx[xcell + 10];		// Her1-Her13 dimer degradation
-	*a0 += ca[7] + ca[20] - old;
+inline void update_a7_20 (reaction_array<double>& a, int cell, parameters* p, int* cx, int xcell, double* a0) { // If Her1-Her13 dimer is updated
+	double old = a[7][cell] + a[20][cell];
+	a[7][cell] = p->ddh1h13 * cx[xcell + 10];		// Her1-Her13 dimer dissociation
+	a[20][cell] = p->ddgh1h13 * cx[xcell + 10];		// Her1-Her13 dimer degradation
+	*a0 += a[7][cell] + a[20][cell] - old;
 }
 
-inline void update_a8_29 (double* ca, parameters* p, int* cx, int xcell, double* a0) { // If her7 mRNA is updated
-	double old = ca[8] + ca[29];
-	ca[8] = p->psh7 * cx[xcell + 1];			// Her7 protein synthesis
-	ca[29] = p->mdh7 * cx[xcell + 1];			// her7 mRNA degradation
-	*a0 += ca[8] + ca[29] - old;
+inline void update_a8_29 (reaction_array<double>& a, int cell, parameters* p, int* cx, int xcell, double* a0) { // If her7 mRNA is updated
+	double old = a[8][cell] + a[29][cell];
+	a[8][cell] = p->psh7 * cx[xcell + 1];			// Her7 protein synthesis
+	a[29][cell] = p->mdh7 * cx[xcell + 1];			// her7 mRNA degradation
+	*a0 += a[8][cell] + a[29][cell] - old;
 }
 
-inline void update_a11_21 (double* ca, parameters* p, int* cx, int xcell, double* a0) { // If Her7-Her7 dimer is updated
-	double old = ca[11] + ca[21];
-	ca[11] = p->ddh7h7 * cx[xcell + 11];		// Her7-Her7 dimer dissociation
-	ca[21] = p->ddgh7h7 * cx[xcell + 11];		// Her7-Her7 dimer degradation
-	*a0 += ca[11] + ca[21] - old;				
+inline void update_a11_21 (reaction_array<double>& a, int cell, parameters* p, int* cx, int xcell, double* a0) { // If Her7-Her7 dimer is updated
+	double old = a[11][cell] + a[21][cell];
+	a[11][cell] = p->ddh7h7 * cx[xcell + 11];		// Her7-Her7 dimer dissociation
+	a[21][cell] = p->ddgh7h7 * cx[xcell + 11];		// Her7-Her7 dimer degradation
+	*a0 += a[11][cell] + a[21][cell] - old;				
 }
 
-inline void update_a13_22 (double* ca, parameters* p, int* cx, int xcell, double* a0) { // If Her7-Her13 dimer is updated
-	double old = ca[13] + ca[22];
-	ca[13] = p->ddh7h13 * cx[xcell + 12];			// Her7-Her13 dimer dissociation
-	ca[22] = p->ddgh7h13 * cx[xcell + 12];			// Her7-Her13 dimer degradation
-	*a0 += ca[13] + ca[22] - old;
+inline void update_a13_22 (reaction_array<double>& a, int cell, parameters* p, int* cx, int xcell, double* a0) { // If Her7-Her13 dimer is updated
+	double old = a[13][cell] + a[22][cell];
+	a[13][cell] = p->ddh7h13 * cx[xcell + 12];			// Her7-Her13 dimer dissociation
+	a[22][cell] = p->ddgh7h13 * cx[xcell + 12];			// Her7-Her13 dimer degradation
+	*a0 += a[13][cell] + a[22][cell] - old;
 }
 
-inline void update_a14_31 (double* ca, parameters* p, int* cx, int xcell, double* a0) { // If her13 mRNA is updated
-	double old = ca[14] + ca[31];
-	ca[14] = p->psh13 * cx[xcell + 2];			// Her13 protein synthesis
-	ca[31] = p->mdh13 * cx[xcell + 2];			// her13 mRNA degradation
-	*a0 += ca[14] + ca[31] - old;
+inline void update_a14_31 (reaction_array<double>& a, int cell, parameters* p, int* cx, int xcell, double* a0) { // If her13 mRNA is updated
+	double old = a[14][cell] + a[31][cell];
+	a[14][cell] = p->psh13 * cx[xcell + 2];			// Her13 protein synthesis
+	a[31][cell] = p->mdh13 * cx[xcell + 2];			// her13 mRNA degradation
+	*a0 += a[14][cell] + a[31][cell] - old;
 }
 
-inline void update_a17_23 (double* ca, parameters* p, int* cx, int xcell, double* a0) {	// If Her13-Her13 dimer is updated
-	double old = ca[17] + ca[23];
-	ca[17] = p->ddh13h13 * cx[xcell + 13];		// Her13-Her13 dimer dissociation
-	ca[23] = p->ddgh13h13 * cx[xcell + 13];		// Her13-Her13 dimer degradation
-	*a0 += ca[17] + ca[23] - old;
+inline void update_a17_23 (reaction_array<double>& a, int cell, parameters* p, int* cx, int xcell, double* a0) {	// If Her13-Her13 dimer is updated
+	double old = a[17][cell] + a[23][cell];
+	a[17][cell] = p->ddh13h13 * cx[xcell + 13];		// Her13-Her13 dimer dissociation
+	a[23][cell] = p->ddgh13h13 * cx[xcell + 13];		// Her13-Her13 dimer degradation
+	*a0 += a[17][cell] + a[23][cell] - old;
 }
 
-inline void update_a24_33 (double* ca, parameters* p, int* cx, int xcell, double* a0) { // If delta mRNA is updated
-	double old = ca[24] + ca[33];
-	ca[24] = p->psd * cx[xcell + 3];			// Delta protein synthesis
-	ca[33] = p->mdd * cx[xcell + 3];			// delta mRNA degradation
-	*a0 += ca[24] + ca[33] - old;
+inline void update_a24_33 (reaction_array<double>& a, int cell, parameters* p, int* cx, int xcell, double* a0) { // If delta mRNA is updated
+	double old = a[24][cell] + a[33][cell];
+	a[24][cell] = p->psd * cx[xcell + 3];			// Delta protein synthesis
+	a[33][cell] = p->mdd * cx[xcell + 3];			// delta mRNA degradation
+	*a0 += a[24][cell] + a[33][cell] - old;
 }
 
-inline void update_a25 (double* ca, parameters* p, int* cx, int xcell, double* a0) { // If delta protein is updated
-	double old = ca[25];
-	ca[25] = p->pdd * cx[xcell + 7];			// Delta protein degradation
-	*a0 += ca[25] - old;
+inline void update_a25 (reaction_array<double>& a, int cell, parameters* p, int* cx, int xcell, double* a0) { // If delta protein is updated
+	double old = a[25][cell];
+	a[25][cell] = p->pdd * cx[xcell + 7];			// Delta protein degradation
+	*a0 += a[25][cell] - old;
 }
 
-inline void update_a26_28_32 (double* ca, parameters* p, int* cx, int xcell, int neighbors, int* nc, double* a0) {	// If Her1-Her1 dimer, Her7-Her13 dimer and Delta protein is updated
-	double old = ca[26] + ca[28] + ca[32];
+inline void update_a26_28_32 (reaction_array<double>& a, int cell, parameters* p, int* cx, int xcell, int neighbors, const int* delta_sums, double* a0) {	// If Her1-Her1 dimer, Her7-Her13 dimer and Delta protein is updated
+	double old = a[26][cell] + a[28][cell] + a[32][cell];
 	double x11 = cx[xcell + 8] / p->critph1h1;
 	double x713 = cx[xcell + 12] / p->critph7h13;
-	double reaction_sum = 0;
-	for (int nn = 1; nn < neighbors; nn++) {
-		reaction_sum += cx[nc[nn] * species + 7];
-	}
+	double reaction_sum = delta_sums[cell]; // the Delta protein of the cell's neighbors, kept up to date as it changes (see push_delta)
 	double y = (reaction_sum / (neighbors - 1)) / p->critpd;
 	double result1 = 1 + x11 * x11 + x713 * x713;
 	double result2 = (1 + y) / (y + result1);
-	ca[26] = p->msh1 * result2;
-	ca[28] = p->msh7 * result2;
-	ca[32] = p->msd / result1;
-	*a0 += ca[26] + ca[28] + ca[32] - old;
+	a[26][cell] = p->msh1 * result2;
+	a[28][cell] = p->msh7 * result2;
+	a[32][cell] = p->msd / result1;
+	*a0 += a[26][cell] + a[28][cell] + a[32][cell] - old;
+}
+
+/*
+Transcription depends on the sum of the Delta protein of a cell's neighbors, which is kept for every cell instead of being summed each time a propensity is updated:
+whenever a cell's Delta protein changes, the change is added to the sums of its neighbors (neighborhoods are symmetric, so the cells whose sums include a cell are its own neighbors).
+This makes updating the transcription propensities take constant time instead of reading every neighbor, which matters most in hexagonal tissues.
+*/
+
+// add a change in a cell's Delta protein to the sums of its neighbors (the cell is always its own first neighbor, which isn't included)
+inline void push_delta (int* delta_sums, int neighbors, const int* nc, int change) {
+	for (int nn = 1; nn < neighbors; nn++) {
+		delta_sums[nc[nn]] += change;
+	}
+}
+
+// calculate every cell's sum from scratch (at the start of a run)
+inline void sum_neighbor_delta (int* delta_sums, unsigned int cells, const int* cx, int neighbors, int (*nc)[7]) {
+	for (unsigned int i = 0; i < cells; i++) {
+		int sum = 0;
+		for (int nn = 1; nn < neighbors; nn++) {
+			sum += cx[nc[i][nn] * species + 7];
+		}
+		delta_sums[i] = sum;
+	}
+}
+
+inline void update_all_propensities (reaction_array<double>& a, int cell, parameters* p, int* cx, int neighbors, const int* delta_sums, double* a0) { // Recalculate every propensity of the cell, since any could have changed
+	int xcell = cell * species;
+	update_a0_27(a, cell, p, cx, xcell, a0);
+	update_a1_2_4_6(a, cell, p, cx, xcell, a0);
+	update_a3_18(a, cell, p, cx, xcell, a0);
+	update_a4_9_10_12(a, cell, p, cx, xcell, a0);
+	update_a5_19(a, cell, p, cx, xcell, a0);
+	update_a6_12_15_16(a, cell, p, cx, xcell, a0);
+	update_a7_20(a, cell, p, cx, xcell, a0);
+	update_a8_29(a, cell, p, cx, xcell, a0);
+	update_a11_21(a, cell, p, cx, xcell, a0);
+	update_a13_22(a, cell, p, cx, xcell, a0);
+	update_a14_31(a, cell, p, cx, xcell, a0);
+	update_a17_23(a, cell, p, cx, xcell, a0);
+	update_a24_33(a, cell, p, cx, xcell, a0);
+	update_a25(a, cell, p, cx, xcell, a0);
+	update_a26_28_32(a, cell, p, cx, xcell, neighbors, delta_sums, a0);
+}
+
+inline void update_propensity_group (int group, reaction_array<double>& a, int cell, parameters* p, int* cx, int xcell, int neighbors, const int* delta_sums, double* a0) { // Recalculate the propensity group with the given index (see dependencies.h)
+	switch (group) {
+		case group_a0_27: update_a0_27(a, cell, p, cx, xcell, a0); break;
+		case group_a1_2_4_6: update_a1_2_4_6(a, cell, p, cx, xcell, a0); break;
+		case group_a3_18: update_a3_18(a, cell, p, cx, xcell, a0); break;
+		case group_a4_9_10_12: update_a4_9_10_12(a, cell, p, cx, xcell, a0); break;
+		case group_a5_19: update_a5_19(a, cell, p, cx, xcell, a0); break;
+		case group_a6_12_15_16: update_a6_12_15_16(a, cell, p, cx, xcell, a0); break;
+		case group_a7_20: update_a7_20(a, cell, p, cx, xcell, a0); break;
+		case group_a8_29: update_a8_29(a, cell, p, cx, xcell, a0); break;
+		case group_a11_21: update_a11_21(a, cell, p, cx, xcell, a0); break;
+		case group_a13_22: update_a13_22(a, cell, p, cx, xcell, a0); break;
+		case group_a14_31: update_a14_31(a, cell, p, cx, xcell, a0); break;
+		case group_a17_23: update_a17_23(a, cell, p, cx, xcell, a0); break;
+		case group_a24_33: update_a24_33(a, cell, p, cx, xcell, a0); break;
+		case group_a25: update_a25(a, cell, p, cx, xcell, a0); break;
+		case group_a26_28_32: update_a26_28_32(a, cell, p, cx, xcell, neighbors, delta_sums, a0); break;
+	}
 }
 
 #endif
@@ -58,7 +58,7 @@ void terminal_color(){
 	strcpy(terminal_reset, terminal_reset_d);
 }
 
-void checkArgs(int argc, char **argv, int& xcells, int& ycells, int& max_minutes, long& max_timesteps, int& runs, int& seed, char **input_file, char **output_path, int& con_level, map<string, int> levels, double& granularity, int& print_interval, char **seed_file, bool& appx){
+void checkArgs(int argc, char **argv, int& xcells, int& ycells, int& max_minutes, long& max_timesteps, int& runs, int& seed, char **input_file, char **output_path, int& con_level, map<string, int> levels, double& granularity, int& print_interval, char **seed_file, bool& appx, bool& hybrid, bool& langevin, int& threads, bool& binary, char **ofeat_file, bool& print_runs, char **batch_file, char **mutant_list, bool& evaluate, bool& print_stats, char **leap_list, char **autotune_file){
 	if (argc > 1) { // if arguments were given
 		for (int i = 1; i < argc; i += 2) { // iterate through each argument
 			char* option = argv[i];
@@ -132,9 +132,42 @@ void checkArgs(int argc, char **argv, int& xcells, int& ycells, int& max_minutes
 				}
 			} else if (strcmp(option, "-k") == 0 || strcmp(option, "--keep-seed") == 0) {
 				store_filename(seed_file, value);
+			} else if (strcmp(option, "-n") == 0 || strcmp(option, "--threads") == 0) {
+				threads = atoi(value);
+				if (threads < 1) {
+					usage("The simulation must run on at least one thread. Set -n or --threads to at least 1.");
+				}
 			} else if (strcmp(option, "-a") == 0 || strcmp(option, "--approximate") == 0) {
 				appx = true;
 				i--;
+			} else if (strcmp(option, "-H") == 0 || strcmp(option, "--hybrid") == 0) {
+				hybrid = true;
+				i--;
+			} else if (strcmp(option, "-L") == 0 || strcmp(option, "--langevin") == 0) {
+				langevin = true;
+				i--;
+			} else if (strcmp(option, "-b") == 0 || strcmp(option, "--binary") == 0) {
+				binary = true;
+				i--;
+			} else if (strcmp(option, "-f") == 0 || strcmp(option, "--ofeatures") == 0) {
+				store_filename(ofeat_file, value);
+			} else if (strcmp(option, "-e") == 0 || strcmp(option, "--features-only") == 0) {
+				print_runs = false;
+				i--;
+			} else if (strcmp(option, "-j") == 0 || strcmp(option, "--batch") == 0) {
+				store_filename(batch_file, value);
+			} else if (strcmp(option, "-u") == 0 || strcmp(option, "--mutants") == 0) {
+				store_filename(mutant_list, value);
+			} else if (strcmp(option, "-v") == 0 || strcmp(option, "--evaluate") == 0) {
+				evaluate = true;
+				i--;
+			} else if (strcmp(option, "-z") == 0 || strcmp(option, "--stats") == 0) {
+				print_stats = true;
+				i--;
+			} else if (strcmp(option, "-w") == 0 || strcmp(option, "--leap") == 0) {
+				store_filename(leap_list, value);
+			} else if (strcmp(option, "-d") == 0 || strcmp(option, "--autotune") == 0) {
+				store_filename(autotune_file, value);
 			} else if (strcmp(option, "-c") == 0 || strcmp(option, "--no-color") == 0) {
 				strcpy(terminal_blue, "");
 				strcpy(terminal_red, "");
@@ -313,19 +346,17 @@ void memory_alloc(int chunk, int cells, int ***x, double **T){
 	cout << terminal_done << endl;
 }
 
-void memory_dealloc(int **x, double *T, char *input_file, char *output_path, int chunk){
-	/*
-	Deallocate heap memory:
-	1) Delete the concentrations matrix and simulation timestep array
-	2) Free the memory used to store the input and output paths
-	*/
-	
+void memory_dealloc(int **x, double *T, int chunk){
+	// delete the concentrations matrix and simulation timestep array
 	for (int i = 0; i < chunk; i++) {
 		delete[] x[i];
 	}
 	delete[] x;
 	delete[] T;
-	
+}
+
+void strings_dealloc(char *input_file, char *output_path){
+	// free the memory used to store the input and output paths and the terminal color codes
 	free(input_file);
     free(output_path);
 	free(terminal_blue);
@@ -352,7 +383,19 @@ void usage (const char* message) {
 	cout << "-g, --granularity : the granularity of the output, i.e. print values for every x number of minutes simulated, min=0, default=0.1" << endl;
 	cout << "-p, --print       : printing interval in minutes, min=1, default=1200" << endl;
 	cout << "-k, --keep-seed   : store the seed in the specified file relative to the output directory, default=seed.txt" << endl;
+	cout << "-n, --threads     : the number of runs to simulate at the same time, min=1, default=1" << endl;
 	cout << "-a, --approximate : approximate the simulation for faster results, default=unused" << endl;
+	cout << "-H, --hybrid      : integrate the reactions whose reactants and products all have at least hybrid_threshold molecules as ODEs every hybrid_step minutes (see -w), simulating the rest (and every delayed reaction) exactly, default=unused" << endl;
+	cout << "-L, --langevin    : solve the chemical Langevin equation of the whole tissue every langevin_step minutes (see -w) instead of firing reactions, which keeps the noise and is much faster for large tissues, default=unused" << endl;
+	cout << "-b, --binary      : print binary run files, which are faster to print and read (analysis/run-text converts them to text), default=unused" << endl;
+	cout << "-f, --ofeatures   : compute the oscillation features and synchronization score of each run while simulating and print them to the specified file relative to the output directory, default=unused" << endl;
+	cout << "-e, --features-only : only print the oscillation features, not the run files (requires -f), default=unused" << endl;
+	cout << "-j, --batch       : simulate every parameter set in the specified file (one per line) for every mutant in -u, printing only the oscillation features of every run to one file (-f, default=batch.csv), default=unused" << endl;
+	cout << "-u, --mutants     : the comma-separated mutants to simulate for each parameter set with -j (wt, delta, her13, her1, her7, her713), default=wt,delta,her13,her1,her7,her713" << endl;
+	cout << "-v, --evaluate    : with -j, decide whether each parameter set passes seg-clock's criteria, simulating its mutants in order and only as many runs (at most -r) as needed, and print the results to evaluation.csv, default=unused" << endl;
+	cout << "-z, --stats       : print every run's hot-path statistics (algorithm counters and tau-leaping timers) to stats.json, which requires building with scons stats=1, default=unused" << endl;
+	cout << "-w, --leap        : the comma-separated leaping settings to change (beta, delta_factor, epsilon, hybrid_step, hybrid_threshold, langevin_step, ncrit, nstiff, skip_steps_ex, skip_steps_im, tau1_mult), e.g. epsilon=0.03,tau1_mult=20, default=the values in macros.h" << endl;
+	cout << "-d, --autotune    : choose the fastest leaping settings (exact, approximate, hybrid, or Langevin) whose oscillation features match the exact method's in short calibration runs of each condition, caching them in the specified file; the choice depends on timing, so results are only reproducible across machines or thread counts with the same cache file, default=unused" << endl;
 	cout << "-c, --no-color    : disable coloring the terminal output, default=unused" << endl;
 	cout << "-q, --quiet       : hide the terminal output, default=unused" << endl;
 	cout << "-l, --licensing   : view licensing information (no simulations will be run)" << endl;
@@ -37,11 +37,12 @@ We used the following articles and their associated algorithms to construct this
 using namespace std;
 
 void terminal_color();
-void checkArgs(int argc, char **argv, int& xcells, int& ycells, int& max_minutes, long& max_timesteps, int& runs, int& seed, char **input_file, char **output_path, int& con_level, map<string, int> levels, double& granularity, int& print_interval, char **seed_file, bool& appx);
+void checkArgs(int argc, char **argv, int& xcells, int& ycells, int& max_minutes, long& max_timesteps, int& runs, int& seed, char **input_file, char **output_path, int& con_level, map<string, int> levels, double& granularity, int& print_interval, char **seed_file, bool& appx, bool& hybrid, bool& langevin, int& threads, bool& binary, char **ofeat_file, bool& print_runs, char **batch_file, char **mutant_list, bool& evaluate, bool& print_stats, char **leap_list, char **autotune_file);
 void checkSize(int xcells, int ycells, char *input_file, char *output_path, int& structure, int& neighbors);
 void cells_neighbors(int structure, int neighbors, int cells, int xcells, int ***nc);
 void memory_alloc(int chunk, int cells, int ***x, double **T);
-void memory_dealloc(int **x, double *T, char *input_file, char *output_path, int chunk);
+void memory_dealloc(int **x, double *T, int chunk);
+void strings_dealloc(char *input_file, char *output_path);
 void usage (const char* message);
 void licensing ();
 